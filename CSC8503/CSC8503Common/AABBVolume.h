@@ -5,6 +5,9 @@ namespace NCL {
 	class AABBVolume : CollisionVolume
 	{
 	public:
+		using CollisionVolume::operator new;
+		using CollisionVolume::operator delete;
+
 		AABBVolume(const Vector3& halfDims) {
 			type		= VolumeType::AABB;
 			halfSizes	= halfDims;
@@ -0,0 +1,118 @@
+#include "ClosestPoint.h"
+#include <emmintrin.h>
+
+using namespace NCL;
+
+//Written as selects rather than ifs, so they compile down to minss / maxss
+static inline float Clamp01(float v) {
+	v = v < 0.0f ? 0.0f : v;
+	return v > 1.0f ? 1.0f : v;
+}
+
+static inline float NonZero(float v) {
+	return v > 1e-12f ? v : 1e-12f;
+}
+
+static inline Vector3 ClampToBox(const Vector3& p, const Vector3& halfSize) {
+	return Vector3(
+		p.x < -halfSize.x ? -halfSize.x : (p.x > halfSize.x ? halfSize.x : p.x),
+		p.y < -halfSize.y ? -halfSize.y : (p.y > halfSize.y ? halfSize.y : p.y),
+		p.z < -halfSize.z ? -halfSize.z : (p.z > halfSize.z ? halfSize.z : p.z));
+}
+
+float ClosestPoint::SegmentPoint(const Vector3& a, const Vector3& b, const Vector3& p, Vector3& closest) {
+	Vector3 ab	= b - a;
+	float t		= Clamp01(Vector3::Dot(p - a, ab) / NonZero(Vector3::Dot(ab, ab)));
+	closest		= a + ab * t;
+	return t;
+}
+
+/*
+Based on the segment / segment test from Real-Time Collision Detection (Ericson),
+but rather than branching on which end of which segment got clamped, s is always
+worked out again from the clamped t. If nothing was clamped this gives back the
+same s, so it's always correct, and parallel or zero length segments just fall
+out of the clamps too.
+*/
+void ClosestPoint::SegmentSegment(const Vector3& p1, const Vector3& q1, const Vector3& p2, const Vector3& q2,
+	Vector3& closest1, Vector3& closest2, float& s, float& t) {
+	Vector3 d1	= q1 - p1;
+	Vector3 d2	= q2 - p2;
+	Vector3 r	= p1 - p2;
+
+	float a = Vector3::Dot(d1, d1);
+	float e = Vector3::Dot(d2, d2);
+	float b = Vector3::Dot(d1, d2);
+	float c = Vector3::Dot(d1, r);
+	float f = Vector3::Dot(d2, r);
+
+	float denom = a * e - b * b;	//Zero if the segments are parallel, in which case any s will do
+	s = denom > 1e-12f ? Clamp01((b * f - c * e) / denom) : 0.0f;
+	t = Clamp01((b * s + f) / NonZero(e));
+	s = Clamp01((b * t - c) / NonZero(a));
+
+	closest1 = p1 + d1 * s;
+	closest2 = p2 + d2 * t;
+}
+
+/*
+The distance from a box to a point moving along a line only ever goes down
+and then back up, so we can narrow in on the closest point by searching. Each
+step checks 4 points spread along what's left of the segment at once using
+SSE, and keeps the part either side of the closest one, shrinking the search
+by 60% a step. A final step projects the closest point on the box back onto
+the segment, which can only ever bring the two closer together.
+*/
+float ClosestPoint::SegmentBox(const Vector3& a, const Vector3& b, const Vector3& halfSize,
+	Vector3& segmentPoint, Vector3& boxPoint) {
+	const int iterations = 10;
+
+	Vector3 d = b - a;
+
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 zero	= _mm_setzero_ps();
+	const __m128 ax		= _mm_set1_ps(a.x);
+	const __m128 ay		= _mm_set1_ps(a.y);
+	const __m128 az		= _mm_set1_ps(a.z);
+	const __m128 dx		= _mm_set1_ps(d.x);
+	const __m128 dy		= _mm_set1_ps(d.y);
+	const __m128 dz		= _mm_set1_ps(d.z);
+	const __m128 hx		= _mm_set1_ps(halfSize.x);
+	const __m128 hy		= _mm_set1_ps(halfSize.y);
+	const __m128 hz		= _mm_set1_ps(halfSize.z);
+	const __m128 steps	= _mm_setr_ps(0.2f, 0.4f, 0.6f, 0.8f);
+
+	float lo = 0.0f;
+	float hi = 1.0f;
+	for (int i = 0; i < iterations; ++i) {
+		__m128 t  = _mm_add_ps(_mm_set1_ps(lo), _mm_mul_ps(_mm_set1_ps(hi - lo), steps));
+
+		//How far outside the box each point is on each axis, or 0 if it's within the box's extent
+		__m128 ox = _mm_max_ps(_mm_sub_ps(_mm_and_ps(_mm_add_ps(ax, _mm_mul_ps(dx, t)), absMask), hx), zero);
+		__m128 oy = _mm_max_ps(_mm_sub_ps(_mm_and_ps(_mm_add_ps(ay, _mm_mul_ps(dy, t)), absMask), hy), zero);
+		__m128 oz = _mm_max_ps(_mm_sub_ps(_mm_and_ps(_mm_add_ps(az, _mm_mul_ps(dz, t)), absMask), hz), zero);
+		__m128 distSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(oz, oz));
+
+		float dists[4];
+		float ts[4];
+		_mm_storeu_ps(dists, distSq);
+		_mm_storeu_ps(ts, t);
+
+		int best = 0;
+		best = dists[1] < dists[best] ? 1 : best;
+		best = dists[2] < dists[best] ? 2 : best;
+		best = dists[3] < dists[best] ? 3 : best;
+
+		float newLo = best > 0 ? ts[best - 1] : lo;
+		float newHi = best < 3 ? ts[best + 1] : hi;
+		lo = newLo;
+		hi = newHi;
+	}
+	segmentPoint	= a + d * ((lo + hi) * 0.5f);
+	boxPoint		= ClampToBox(segmentPoint, halfSize);
+
+	SegmentPoint(a, b, boxPoint, segmentPoint);
+	boxPoint = ClampToBox(segmentPoint, halfSize);
+
+	return (segmentPoint - boxPoint).LengthSquared();
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "../../Common/Vector3.h"
+
+namespace NCL {
+	using namespace NCL::Maths;
+	/*
+	Closest point queries between lines, points and boxes, shared by all of the
+	capsule collision routines (a capsule is just a line segment with a radius).
+	They're written to avoid branching wherever possible - clamps are done with
+	min / max, and degenerate (zero length) segments are handled by the maths
+	rather than by special cases, so they run the same way every time.
+	*/
+	class ClosestPoint
+	{
+	public:
+		//Returns how far along segment a->b the closest point to p is, from 0 to 1
+		static float SegmentPoint(const Vector3& a, const Vector3& b, const Vector3& p, Vector3& closest);
+
+		//Closest points between segments p1->q1 and p2->q2, with how far along each one they are
+		static void SegmentSegment(const Vector3& p1, const Vector3& q1, const Vector3& p2, const Vector3& q2,
+			Vector3& closest1, Vector3& closest2, float& s, float& t);
+
+		/*
+		Closest points between segment a->b and a box centred on the origin,
+		so the segment has to be brought into the box's local space first.
+		Returns the squared distance between them, which is 0 if they overlap.
+		*/
+		static float SegmentBox(const Vector3& a, const Vector3& b, const Vector3& halfSize,
+			Vector3& segmentPoint, Vector3& boxPoint);
+
+	private:
+		ClosestPoint()	{}
+		~ClosestPoint()	{}
+	};
+}
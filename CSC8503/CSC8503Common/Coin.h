@@ -6,13 +6,15 @@ namespace NCL {
 		class Coin : public GameObject {
 		public:
 			Coin(std::string name = "Coin") : GameObject(name){
-				layer = Layer::DontResolveCollisions | Layer::AntiGravity;
+				layer		= Layer::AntiGravity;
+				isTrigger	= true;
+				AddCollisionFilter("Player"_sid);
 			};
-			virtual void OnCollisionBegin(GameObject* otherObject) override {
-				if (otherObject->GetName() == "Player") {
+			virtual void OnTriggerEnter(GameObject* otherObject) override {
+				if (otherObject->GetName() == "Player"_sid) {
 					//Hide the coin, ignore all subsequent collisions
-					isActive = false;
-					layer = Layer::IgnoreAllCollisions;
+					SetActive(false);
+					SetLayer(Layer::IgnoreAllCollisions);
 				}
 			}
 		};
@@ -3,6 +3,7 @@
 #include "AABBVolume.h"
 #include "OBBVolume.h"
 #include "SphereVolume.h"
+#include "ClosestPoint.h"
 #include "../../Common/Vector2.h"
 #include "../../Common/Window.h"
 #include "../../Common/Maths.h"
@@ -44,6 +45,7 @@ bool CollisionDetection::RayIntersection(const Ray& r,GameObject& object, RayCol
 		case VolumeType::OBB:		hasCollided = RayOBBIntersection(r, worldTransform, (const OBBVolume&)*volume	, collision); break;
 		case VolumeType::Sphere:	hasCollided = RaySphereIntersection(r, worldTransform, (const SphereVolume&)*volume	, collision); break;
 		case VolumeType::Capsule:	hasCollided = RayCapsuleIntersection(r, worldTransform, (const CapsuleVolume&)*volume, collision); break;
+		case VolumeType::Heightfield:	hasCollided = RayHeightfieldIntersection(r, worldTransform, (const HeightfieldVolume&)*volume, collision); break;
 	}
 
 	return hasCollided;
@@ -111,46 +113,27 @@ bool CollisionDetection::RayOBBIntersection(const Ray&r, const Transform& worldT
 	return collided;
 }
 
+/*
+Finds the point on the capsule's line that passes closest to the ray, and then
+does a ray / sphere test against a sphere of the capsule's radius placed there.
+The ray is treated as a segment just long enough to reach past the whole capsule.
+*/
 bool CollisionDetection::RayCapsuleIntersection(const Ray& r, const Transform& worldTransform, const CapsuleVolume& volume, RayCollision& collision) {
-	Quaternion orientation = worldTransform.GetOrientation();
-	Vector3 position = worldTransform.GetPosition();
-	Matrix3 transform = Matrix3(orientation);
-
-	Vector3 originToRayVec = position - r.GetPosition();
-	Vector3 capsuleUpVec = transform * Vector3(0, 1, 0);
-	Vector3 orthVec = Vector3::Cross(capsuleUpVec, originToRayVec);
-	Plane p = Plane::PlaneFromTri(position, position + capsuleUpVec, position + orthVec);
-
-	Vector3 topSpherePos = position + capsuleUpVec * (volume.GetHalfHeight() - volume.GetRadius());
-	Vector3 bottomSpherePos = position - capsuleUpVec * (volume.GetHalfHeight() - volume.GetRadius());
-
-	RayCollision rayC;
-	RayPlaneIntersection(r, p, rayC);
-	Vector3 planeCollision = rayC.collidedAt;
-
-	bool collided = false;
-
-	Vector3 bestSphereCheck;
-	if (Vector3::Dot(topSpherePos - position, topSpherePos - planeCollision) < 0) {
-		collided = Vector3::Distance(topSpherePos, planeCollision) < volume.GetRadius();
-		bestSphereCheck = topSpherePos;
-	}
-	else if (Vector3::Dot(bottomSpherePos - position, bottomSpherePos - planeCollision) < 0) {
-		collided = Vector3::Distance(bottomSpherePos, planeCollision) < volume.GetRadius();
-		bestSphereCheck = bottomSpherePos;
-	}
-	else { //Collision lies on cylinder part of capsule
-		Vector3 centralPoint = position + capsuleUpVec * (Vector3::Dot(planeCollision - position, capsuleUpVec));
-		collided = Vector3::Distance(centralPoint, planeCollision) < volume.GetRadius();
-		bestSphereCheck = centralPoint;
-	}
-
-	if (collided) {
-		//Collision, do a ray sphere intersection test to calculate collision details
-		return RaySphereIntersection(r, Transform().SetPosition(bestSphereCheck), SphereVolume(volume.GetRadius()), collision);
+	Vector3 position	= worldTransform.GetPosition();
+	Vector3 lineExtent	= worldTransform.GetOrientation() * Vector3(0, volume.GetHalfHeight() - volume.GetRadius(), 0);
+	float	rayLength	= (position - r.GetPosition()).Length() + volume.GetHalfHeight();
+
+	Vector3 closestOnRay;
+	Vector3 closestOnLine;
+	float s;
+	float t;
+	ClosestPoint::SegmentSegment(r.GetPosition(), r.GetPosition() + r.GetDirection() * rayLength, position - lineExtent, position + lineExtent,
+		closestOnRay, closestOnLine, s, t);
+
+	if ((closestOnRay - closestOnLine).LengthSquared() > volume.GetRadius() * volume.GetRadius()) {
+		return false;
 	}
-
-	return false;
+	return RaySphereIntersection(r, Transform().SetPosition(closestOnLine), SphereVolume(volume.GetRadius()), collision);
 }
 
 bool CollisionDetection::RaySphereIntersection(const Ray&r, const Transform& worldTransform, const SphereVolume& volume, RayCollision& collision) {
@@ -357,11 +340,37 @@ bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, Collis
 	collisionInfo.a = a;
 	collisionInfo.b = b;
 
-	Transform& transformA = a->GetTransform();
-	Transform& transformB = b->GetTransform();
+	return VolumeIntersection(volA, a->GetTransform(), volB, b->GetTransform(), collisionInfo);
+}
 
+/*
+The actual volume vs volume dispatch, split out from ObjectIntersection so that
+shapes which don't belong to any GameObject (such as world queries) can be tested
+too. If the pair has to be tested the other way round, a and b in the collision
+info get swapped, so the contact point still matches up with the objects.
+*/
+bool CollisionDetection::VolumeIntersection(const CollisionVolume* volA, const Transform& transformA,
+	const CollisionVolume* volB, const Transform& transformB, CollisionInfo& collisionInfo) {
 	VolumeType pairType = (VolumeType)((int)volA->type | (int)volB->type);
 
+	if (pairType == VolumeType::Heightfield) {
+		return false;	//Terrain never moves, so never needs testing against more terrain
+	}
+	if (volB->type == VolumeType::Heightfield) {
+		std::swap(collisionInfo.a, collisionInfo.b);
+		return VolumeIntersection(volB, transformB, volA, transformA, collisionInfo);
+	}
+	if (volA->type == VolumeType::Heightfield) {
+		const HeightfieldVolume& field = (const HeightfieldVolume&)*volA;
+		switch (volB->type) {
+			case VolumeType::Sphere:	return HeightfieldSphereIntersection(field, transformA, (const SphereVolume&)*volB, transformB, collisionInfo);
+			case VolumeType::Capsule:	return HeightfieldCapsuleIntersection(field, transformA, (const CapsuleVolume&)*volB, transformB, collisionInfo);
+			case VolumeType::OBB:		return HeightfieldOBBIntersection(field, transformA, (const OBBVolume&)*volB, transformB, collisionInfo);
+			case VolumeType::AABB:		return HeightfieldAABBIntersection(field, transformA, (const AABBVolume&)*volB, transformB, collisionInfo);
+			default:					return false;
+		}
+	}
+
 	if (pairType == VolumeType::AABB) {
 		return AABBIntersection((AABBVolume&)*volA, transformA, (AABBVolume&)*volB, transformB, collisionInfo);
 	}
@@ -382,8 +391,7 @@ bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, Collis
 		return AABBSphereIntersection((AABBVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
 	}
 	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::AABB) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
+		std::swap(collisionInfo.a, collisionInfo.b);
 		return AABBSphereIntersection((AABBVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
 	}
 
@@ -391,8 +399,7 @@ bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, Collis
 		return SphereCapsuleIntersection((CapsuleVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
 	}
 	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::Capsule) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
+		std::swap(collisionInfo.a, collisionInfo.b);
 		return SphereCapsuleIntersection((CapsuleVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
 	}
 
@@ -400,23 +407,101 @@ bool CollisionDetection::ObjectIntersection(GameObject* a, GameObject* b, Collis
 		return OBBSphereIntersection((OBBVolume&)*volA, transformA, (SphereVolume&)*volB, transformB, collisionInfo);
 	}
 	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::OBB) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
+		std::swap(collisionInfo.a, collisionInfo.b);
 		return OBBSphereIntersection((OBBVolume&)*volB, transformB, (SphereVolume&)*volA, transformA, collisionInfo);
 	}
 
+	if (volA->type == VolumeType::OBB && volB->type == VolumeType::Capsule) {
+		return OBBCapsuleIntersection((OBBVolume&)*volA, transformA, (CapsuleVolume&)*volB, transformB, collisionInfo);
+	}
+	if (volA->type == VolumeType::Capsule && volB->type == VolumeType::OBB) {
+		std::swap(collisionInfo.a, collisionInfo.b);
+		return OBBCapsuleIntersection((OBBVolume&)*volB, transformB, (CapsuleVolume&)*volA, transformA, collisionInfo);
+	}
+	if (volA->type == VolumeType::AABB && volB->type == VolumeType::Capsule) {
+		return OBBCapsuleIntersection(OBBVolume(((AABBVolume&)*volA).GetHalfDimensions()),
+			Transform(transformA).SetOrientation(Quaternion()), (CapsuleVolume&)*volB, transformB, collisionInfo);
+	}
+	if (volA->type == VolumeType::Capsule && volB->type == VolumeType::AABB) {
+		std::swap(collisionInfo.a, collisionInfo.b);
+		return OBBCapsuleIntersection(OBBVolume(((AABBVolume&)*volB).GetHalfDimensions()),
+			Transform(transformB).SetOrientation(Quaternion()), (CapsuleVolume&)*volA, transformA, collisionInfo);
+	}
+
 	if (volA->type == VolumeType::OBB && volB->type == VolumeType::AABB) {
 		return OBBAABBIntersection((OBBVolume&)* volA, transformA, (AABBVolume&)* volB, transformB, collisionInfo);
 	}
 	if (volA->type == VolumeType::AABB && volB->type == VolumeType::OBB) {
-		collisionInfo.a = b;
-		collisionInfo.b = a;
+		std::swap(collisionInfo.a, collisionInfo.b);
 		return OBBAABBIntersection((OBBVolume&)* volB, transformB, (AABBVolume&)* volA, transformA, collisionInfo);
 	}
 
 	return false;
 }
 
+/*
+A yes/no version of VolumeIntersection, for queries and triggers that only care
+whether two shapes touch. Spheres and boxes are by far the most common shapes for
+those, so they get their own cheap tests that never work out a contact point.
+Capsules against boxes only need the closest point between the capsule's line
+and the box, without working out which way to push them apart.
+*/
+bool CollisionDetection::VolumeOverlap(const CollisionVolume* volA, const Transform& transformA,
+	const CollisionVolume* volB, const Transform& transformB) {
+	bool aIsBox = volA->type == VolumeType::AABB || volA->type == VolumeType::OBB;
+	bool bIsBox = volB->type == VolumeType::AABB || volB->type == VolumeType::OBB;
+
+	if (aIsBox && volB->type == VolumeType::Capsule) {
+		return VolumeOverlap(volB, transformB, volA, transformA);
+	}
+	if (volA->type == VolumeType::Sphere && bIsBox) {
+		return VolumeOverlap(volB, transformB, volA, transformA);
+	}
+
+	if (volA->type == VolumeType::Sphere && volB->type == VolumeType::Sphere) {
+		float radii = ((const SphereVolume&)*volA).GetRadius() + ((const SphereVolume&)*volB).GetRadius();
+		return (transformB.GetPosition() - transformA.GetPosition()).LengthSquared() < radii * radii;
+	}
+	if (volA->type == VolumeType::AABB && volB->type == VolumeType::AABB) {
+		return AABBTest(transformA.GetPosition(), transformB.GetPosition(),
+			((const AABBVolume&)*volA).GetHalfDimensions(), ((const AABBVolume&)*volB).GetHalfDimensions());
+	}
+	if (aIsBox && volB->type == VolumeType::Sphere) {
+		bool	isAABB	= volA->type == VolumeType::AABB;
+		Vector3 boxSize = isAABB ?
+			((const AABBVolume&)*volA).GetHalfDimensions() : ((const OBBVolume&)*volA).GetHalfDimensions();
+		Vector3 delta	= transformB.GetPosition() - transformA.GetPosition();
+		if (!isAABB) {
+			delta = transformA.GetOrientation().Conjugate() * delta;
+		}
+		float radius = ((const SphereVolume&)*volB).GetRadius();
+		return (delta - Maths::Clamp(delta, -boxSize, boxSize)).LengthSquared() < radius * radius;
+	}
+
+	CollisionInfo info;
+	info.a = nullptr;
+	info.b = nullptr;
+
+	if (!(volA->type == VolumeType::Capsule && bIsBox)) {
+		return VolumeIntersection(volA, transformA, volB, transformB, info);
+	}
+	const CapsuleVolume& capsule = (const CapsuleVolume&)*volA;
+
+	Vector3 boxPos		= transformB.GetPosition();
+	Vector3 boxSize		= volB->type == VolumeType::AABB ?
+		((const AABBVolume&)*volB).GetHalfDimensions() : ((const OBBVolume&)*volB).GetHalfDimensions();
+	Quaternion boxRot	= volB->type == VolumeType::AABB ? Quaternion() : transformB.GetOrientation();
+	Matrix3 invBoxRot	= Matrix3(boxRot.Conjugate());
+
+	Vector3 lineExtent	= transformA.GetOrientation() * Vector3(0, capsule.GetHalfHeight() - capsule.GetRadius(), 0);
+	Vector3 lineStart	= invBoxRot * (transformA.GetPosition() - lineExtent - boxPos);
+	Vector3 lineEnd		= invBoxRot * (transformA.GetPosition() + lineExtent - boxPos);
+
+	Vector3 linePoint;
+	Vector3 boxPoint;
+	return ClosestPoint::SegmentBox(lineStart, lineEnd, boxSize, linePoint, boxPoint) < capsule.GetRadius() * capsule.GetRadius();
+}
+
 bool CollisionDetection::AABBTest(const Vector3& posA, const Vector3& posB, const Vector3& halfSizeA, const Vector3& halfSizeB) {
 		Vector3 delta = posB - posA;
 		Vector3 totalSize = halfSizeA + halfSizeB;
@@ -645,101 +730,78 @@ bool CollisionDetection::OBBAABBIntersection(const OBBVolume& volumeA, const Tra
 
 }
 
+/*
+The capsule's line is brought into the box's local space, where the box is just
+an AABB at the origin. If the line goes right through the box, it's pushed out
+through whichever face is closest to the point found.
+*/
 bool CollisionDetection::OBBCapsuleIntersection(
 	const OBBVolume& volumeA, const Transform& worldTransformA,
 	const CapsuleVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-
-	Quaternion boxRot = worldTransformA.GetOrientation();
-	Matrix3 boxInvTransform = Matrix3(boxRot.Conjugate());
-
-	Vector3 localBoxPos = boxInvTransform * worldTransformA.GetPosition();
-	Vector3 boxSize = volumeA.GetHalfDimensions();
-
-	Quaternion capRot= worldTransformB.GetOrientation();
-	Vector3 position = worldTransformA.GetPosition() - worldTransformB.GetPosition();
-	Matrix3 capInvTransform = Matrix3(capRot.Conjugate());
-
-	Vector3 capsuleUpVec = boxInvTransform * (capRot * Vector3(0, 1, 0));
-	Vector3 capTop = position + capsuleUpVec * (volumeB.GetHalfHeight() - volumeB.GetRadius());
-	Vector3 capBot = position - capsuleUpVec * (volumeB.GetHalfHeight() - volumeB.GetRadius());
-
-	//Project sphere's position onto capsuleline using dot product
-	float t = Vector3::Dot((position).Normalised(), capsuleUpVec.Normalised());
-	Vector3 closestPointOnLine = (position + capsuleUpVec * min(max(t, -1), 1));
-
-	Vector3 closestPointOnBox = Maths::Clamp(closestPointOnLine, -boxSize, boxSize);
-	Vector3 localPoint = (closestPointOnLine - closestPointOnBox);
-	float distance = Vector3::Distance(closestPointOnBox, closestPointOnLine);
-
-	Debug::DrawLine(closestPointOnBox, closestPointOnLine);
-
-	if (distance < volumeB.GetRadius()) {
-		Vector3 collisionNormal = boxRot * (localPoint.Normalised());
-		float penetration = (volumeB.GetRadius() - distance);
-
-		Vector3 localA = boxRot * closestPointOnBox;
-		Vector3 localB = capRot * closestPointOnLine;
-
-		collisionInfo.AddContactPoint(localA, localB, collisionNormal, penetration);
-		return true;
+	Vector3 boxPos		= worldTransformA.GetPosition();
+	Vector3 boxSize		= volumeA.GetHalfDimensions();
+	Quaternion boxRot	= worldTransformA.GetOrientation();
+	Matrix3 transform	= Matrix3(boxRot);
+	Matrix3 invTransform = Matrix3(boxRot.Conjugate());
+
+	Vector3 capPos		= worldTransformB.GetPosition();
+	float	radius		= volumeB.GetRadius();
+	Vector3 lineExtent	= worldTransformB.GetOrientation() * Vector3(0, volumeB.GetHalfHeight() - radius, 0);
+
+	Vector3 localBot = invTransform * (capPos - lineExtent - boxPos);
+	Vector3 localTop = invTransform * (capPos + lineExtent - boxPos);
+
+	Vector3 linePoint;
+	Vector3 boxPoint;
+	float distSq = ClosestPoint::SegmentBox(localBot, localTop, boxSize, linePoint, boxPoint);
+	if (distSq >= radius * radius) {
+		return false;
 	}
-	return false;
-
 
+	Vector3 localNormal;
+	float	penetration;
+	if (distSq > 0.0f) {
+		float distance	= sqrt(distSq);
+		localNormal		= (linePoint - boxPoint) / distance;
+		penetration		= radius - distance;
+	}
+	else {
+		Vector3 depths = boxSize - Vector3(abs(linePoint.x), abs(linePoint.y), abs(linePoint.z));
+		int axis = depths.x < depths.y ? (depths.x < depths.z ? 0 : 2) : (depths.y < depths.z ? 1 : 2);
+		localNormal[axis]	= linePoint[axis] < 0.0f ? -1.0f : 1.0f;
+		boxPoint[axis]		= boxSize[axis] * localNormal[axis];
+		penetration			= radius + depths[axis];
+	}
+	Vector3 normal = transform * localNormal;
 
-	return false;
+	Vector3 localA = transform * boxPoint;
+	Vector3 localB = (transform * linePoint + boxPos - capPos) - normal * radius;
+	collisionInfo.AddContactPoint(localA, localB, normal, penetration);
+	return true;
 }
 
 bool CollisionDetection::CapsuleIntersection(
 	const CapsuleVolume& volumeA, const Transform& worldTransformA,
 	const CapsuleVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	Quaternion rotA = worldTransformA.GetOrientation();
-	Matrix3 aInvTrans = Matrix3(rotA.Conjugate());
-	Vector3 posA = worldTransformA.GetPosition();	
-	Quaternion rotB = worldTransformB.GetOrientation();
-	Matrix3 bInvTrans = Matrix3(rotB.Conjugate());
+	Vector3 posA = worldTransformA.GetPosition();
 	Vector3 posB = worldTransformB.GetPosition();
-	Vector3 aAxis = (rotA * Vector3(0, 1, 0)).Normalised();
-	Vector3 bAxis = (rotB * Vector3(0, 1, 0)).Normalised();
-
-	//Closest point on two lines algorithm from: https://wickedengine.net/2020/04/26/capsule-collision-detection/
-	Vector3 aTop = posA + aAxis * (volumeA.GetHalfHeight() - volumeA.GetRadius());
-	Vector3 aBot = posA - aAxis * (volumeA.GetHalfHeight() - volumeA.GetRadius());
-	Vector3 bTop = posB + bAxis * (volumeB.GetHalfHeight() - volumeB.GetRadius());
-	Vector3 bBot = posB - bAxis * (volumeB.GetHalfHeight() - volumeB.GetRadius());
-	//Vectors between capsule endpoints
-	Vector3 bTaT = bTop - aTop;
-	Vector3 bBaT = bBot - aTop;
-	Vector3 bTaB = bTop - aBot;
-	Vector3 bBaB = bBot - aBot;
-	//Square Distances
-	float bTaTSqrDist = Vector3::Dot(bTaT, bTaT);
-	float bBaTSqrDist = Vector3::Dot(bBaT, bBaT);
-	float bTaBSqrDist = Vector3::Dot(bTaB, bTaB);
-	float bBaBSqrDist = Vector3::Dot(bBaB, bBaB);
-
-	//Finding closest points on vectors a and b
+	Vector3 aExtent = worldTransformA.GetOrientation() * Vector3(0, volumeA.GetHalfHeight() - volumeA.GetRadius(), 0);
+	Vector3 bExtent = worldTransformB.GetOrientation() * Vector3(0, volumeB.GetHalfHeight() - volumeB.GetRadius(), 0);
+
+	//Closest points on the two capsules' lines, then treat those as two spheres
 	Vector3 bestA;
-	if (bTaBSqrDist < bTaTSqrDist || bTaBSqrDist < bBaTSqrDist 
-		|| bBaBSqrDist < bTaTSqrDist || bBaBSqrDist < bBaTSqrDist)
-		bestA = aBot;
-	else
-		bestA = aTop;
-
-	float t = Vector3::Dot((bestA - posB), bAxis);
-	Vector3 bestB = posB + bAxis * min(max(t, -1), 1);
-	t = Vector3::Dot((bestB - posA), aAxis);
-	bestA = posA + aAxis * min(max(t, -1), 1);
-
-	//Sphere-Sphere Collision Detection
+	Vector3 bestB;
+	float s;
+	float t;
+	ClosestPoint::SegmentSegment(posA - aExtent, posA + aExtent, posB - bExtent, posB + bExtent, bestA, bestB, s, t);
+
 	float radii = volumeA.GetRadius() + volumeB.GetRadius();
 	Vector3 delta = bestB - bestA;
-	float deltaLength = Vector3::Distance(bestA, bestB);
+	float deltaLength = delta.Length();
 
-	//If within range, get details of collision by doing a sphere-sphere collision
 	if (deltaLength < radii) {
 		float penetration = (radii - deltaLength);
-		Vector3 normal = delta.Normalised();
+		Vector3 normal = deltaLength > 0.0f ? delta / deltaLength : Vector3(0, 1, 0);
 		Vector3 localA = bestA - posA + (normal) * volumeA.GetRadius();
 		Vector3 localB = bestB - posB - normal * volumeB.GetRadius();
 		collisionInfo.AddContactPoint(localA, localB, normal, penetration);
@@ -751,27 +813,20 @@ bool CollisionDetection::CapsuleIntersection(
 bool CollisionDetection::SphereCapsuleIntersection(
 	const CapsuleVolume& volumeA, const Transform& worldTransformA,
 	const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
-	Quaternion orientation = worldTransformA.GetOrientation();
-	Vector3 position = worldTransformA.GetPosition();
-	Matrix3 transform = Matrix3(orientation);
-	Matrix3 invTransform = Matrix3(orientation.Conjugate());
-
-	Vector3 capsuleUpVec = transform * Vector3(0, 1, 0);
-	Vector3 capTop = position + capsuleUpVec * (volumeA.GetHalfHeight() - volumeA.GetRadius());
-	Vector3 capBot = position - capsuleUpVec * (volumeA.GetHalfHeight() - volumeA.GetRadius());
-	
-	//Project sphere's position onto capsuleline using dot product
+	Vector3 position	= worldTransformA.GetPosition();
+	Vector3 lineExtent	= worldTransformA.GetOrientation() * Vector3(0, volumeA.GetHalfHeight() - volumeA.GetRadius(), 0);
 	Vector3 sphereCenter = worldTransformB.GetPosition();
-	float t = Vector3::Dot((sphereCenter - position).Normalised(), capsuleUpVec.Normalised());
-	Vector3 closestPointOnLine = position + capsuleUpVec * min(max(t,-1),1);
+
+	Vector3 closestPointOnLine;
+	ClosestPoint::SegmentPoint(position - lineExtent, position + lineExtent, sphereCenter, closestPointOnLine);
 
 	float radii = volumeA.GetRadius() + volumeB.GetRadius();
 	Vector3 delta = sphereCenter - closestPointOnLine;
-	float deltaLength = Vector3::Distance(sphereCenter, closestPointOnLine);
+	float deltaLength = delta.Length();
 	//If within range, get details of collision by doing a sphere-sphere collision
 	if (deltaLength < radii) {
 		float penetration = radii - deltaLength;
-		Vector3 normal = delta.Normalised();
+		Vector3 normal = deltaLength > 0.0f ? delta / deltaLength : Vector3(0, 1, 0);
 		Vector3 localA = closestPointOnLine - position + (normal * volumeA.GetRadius());
 		Vector3 localB = (-normal * volumeB.GetRadius());
 
@@ -779,4 +834,333 @@ bool CollisionDetection::SphereCapsuleIntersection(
 		return true;
 	}
 	return false;
-}
\ No newline at end of file
+}
+
+/*
+Heightfields. Every cell of the grid is made of two triangles, so finding the
+part of the terrain under any point is just a divide. Anything below the surface
+counts as being inside the terrain, so even fast moving objects that end up
+underneath it get pushed back out on top, rather than falling through.
+*/
+
+//Closest point to p on the triangle abc, from Real-Time Collision Detection (Ericson)
+static Vector3 ClosestPointOnTriangle(const Vector3& p, const Vector3& a, const Vector3& b, const Vector3& c) {
+	Vector3 ab = b - a;
+	Vector3 ac = c - a;
+	Vector3 ap = p - a;
+	float d1 = Vector3::Dot(ab, ap);
+	float d2 = Vector3::Dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f) {
+		return a;
+	}
+	Vector3 bp = p - b;
+	float d3 = Vector3::Dot(ab, bp);
+	float d4 = Vector3::Dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3) {
+		return b;
+	}
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+		return a + ab * (d1 / (d1 - d3));
+	}
+	Vector3 cp = p - c;
+	float d5 = Vector3::Dot(ab, cp);
+	float d6 = Vector3::Dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6) {
+		return c;
+	}
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+		return a + ac * (d2 / (d2 - d6));
+	}
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	}
+	float denom = 1.0f / (va + vb + vc);
+	return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+//Moller-Trumbore ray / triangle test, hitting either side of the triangle
+static bool RayTriangleIntersection(const Vector3& origin, const Vector3& dir, const Vector3& a, const Vector3& b, const Vector3& c, float& t) {
+	Vector3 e1	= b - a;
+	Vector3 e2	= c - a;
+	Vector3 p	= Vector3::Cross(dir, e2);
+	float det	= Vector3::Dot(e1, p);
+	if (abs(det) < 1e-8f) {
+		return false;
+	}
+	float invDet = 1.0f / det;
+	Vector3 s	= origin - a;
+	float u		= Vector3::Dot(s, p) * invDet;
+	if (u < 0.0f || u > 1.0f) {
+		return false;
+	}
+	Vector3 q	= Vector3::Cross(s, e1);
+	float v		= Vector3::Dot(dir, q) * invDet;
+	if (v < 0.0f || u + v > 1.0f) {
+		return false;
+	}
+	t = Vector3::Dot(e2, q) * invDet;
+	return t >= 0.0f;
+}
+
+static int ClampCell(int i, int maxCell) {
+	return i < 0 ? 0 : (i > maxCell ? maxCell : i);
+}
+
+//Finds the deepest point of contact between the terrain and a sphere at the given world position
+bool CollisionDetection::HeightfieldSphereContact(const HeightfieldVolume& volume, const Vector3& fieldPos, const Vector3& centre, float radius,
+	Vector3& contactPoint, Vector3& normal, float& penetration) {
+	if (volume.GetSamplesX() < 2 || volume.GetSamplesZ() < 2) {
+		return false;
+	}
+	Vector3 local = centre - fieldPos;
+
+	float	surfaceHeight;
+	Vector3 surfaceNormal;
+	if (volume.SampleSurface(local.x, local.z, surfaceHeight, surfaceNormal) && local.y < surfaceHeight) {
+		//Centre is under the surface, so push straight back out along the surface normal
+		normal			= surfaceNormal;
+		penetration		= radius + (surfaceHeight - local.y) * surfaceNormal.y;
+		contactPoint	= fieldPos + Vector3(local.x, surfaceHeight, local.z);
+		return true;
+	}
+
+	Vector3 halfSize = volume.GetHalfDimensions();
+	float	cellSize = volume.GetCellSize();
+	if (local.x + radius < -halfSize.x || local.x - radius > halfSize.x ||
+		local.z + radius < -halfSize.z || local.z - radius > halfSize.z ||
+		local.y - radius > volume.GetMaxHeight()) {
+		return false;
+	}
+	int minX = ClampCell((int)floor((local.x - radius + halfSize.x) / cellSize), volume.GetSamplesX() - 2);
+	int maxX = ClampCell((int)floor((local.x + radius + halfSize.x) / cellSize), volume.GetSamplesX() - 2);
+	int minZ = ClampCell((int)floor((local.z - radius + halfSize.z) / cellSize), volume.GetSamplesZ() - 2);
+	int maxZ = ClampCell((int)floor((local.z + radius + halfSize.z) / cellSize), volume.GetSamplesZ() - 2);
+
+	float	bestDistSq = radius * radius;
+	Vector3 bestPoint;
+	bool	found = false;
+	for (int z = minZ; z <= maxZ; ++z) {
+		for (int x = minX; x <= maxX; ++x) {
+			Vector3 p00 = volume.GetSamplePosition(x,	  z);
+			Vector3 p10 = volume.GetSamplePosition(x + 1, z);
+			Vector3 p01 = volume.GetSamplePosition(x,	  z + 1);
+			Vector3 p11 = volume.GetSamplePosition(x + 1, z + 1);
+
+			Vector3 points[2] = {
+				ClosestPointOnTriangle(local, p00, p01, p11),
+				ClosestPointOnTriangle(local, p00, p11, p10)
+			};
+			for (const Vector3& point : points) {
+				float distSq = (local - point).LengthSquared();
+				if (distSq < bestDistSq) {
+					bestDistSq	= distSq;
+					bestPoint	= point;
+					found		= true;
+				}
+			}
+		}
+	}
+	if (!found) {
+		return false;
+	}
+	float distance	= sqrt(bestDistSq);
+	normal			= distance > 0.0f ? (local - bestPoint) / distance : Vector3(0, 1, 0);
+	penetration		= radius - distance;
+	contactPoint	= fieldPos + bestPoint;
+	return true;
+}
+
+bool CollisionDetection::HeightfieldSphereIntersection(const HeightfieldVolume& volumeA, const Transform& worldTransformA,
+	const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	Vector3 contactPoint;
+	Vector3 normal;
+	float	penetration;
+	if (!HeightfieldSphereContact(volumeA, worldTransformA.GetPosition(), worldTransformB.GetPosition(), volumeB.GetRadius(),
+		contactPoint, normal, penetration)) {
+		return false;
+	}
+	Vector3 localA = contactPoint - worldTransformA.GetPosition();
+	Vector3 localB = -normal * volumeB.GetRadius();
+	collisionInfo.AddContactPoint(localA, localB, normal, penetration);
+	return true;
+}
+
+//Capsules are tested as a row of spheres along their inner line, spaced half a cell apart
+bool CollisionDetection::HeightfieldCapsuleIntersection(const HeightfieldVolume& volumeA, const Transform& worldTransformA,
+	const CapsuleVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	const int maxSpheres = 16;
+
+	Vector3 capsulePos	= worldTransformB.GetPosition();
+	float	radius		= volumeB.GetRadius();
+	Vector3 lineExtent	= worldTransformB.GetOrientation() * Vector3(0, volumeB.GetHalfHeight() - radius, 0);
+
+	int steps = (int)ceil((lineExtent.Length() * 2.0f) / (volumeA.GetCellSize() * 0.5f));
+	steps = steps < 1 ? 1 : (steps > maxSpheres ? maxSpheres : steps);
+
+	float	bestPenetration = 0.0f;
+	Vector3 bestPoint;
+	Vector3 bestNormal;
+	Vector3 bestCentre;
+	bool	found = false;
+	for (int i = 0; i <= steps; ++i) {
+		Vector3 centre = capsulePos - lineExtent + lineExtent * (2.0f * i / steps);
+		Vector3 contactPoint;
+		Vector3 normal;
+		float	penetration;
+		if (HeightfieldSphereContact(volumeA, worldTransformA.GetPosition(), centre, radius, contactPoint, normal, penetration) &&
+			penetration > bestPenetration) {
+			bestPenetration = penetration;
+			bestPoint		= contactPoint;
+			bestNormal		= normal;
+			bestCentre		= centre;
+			found			= true;
+		}
+	}
+	if (!found) {
+		return false;
+	}
+	Vector3 localA = bestPoint - worldTransformA.GetPosition();
+	Vector3 localB = (bestCentre - bestNormal * radius) - capsulePos;
+	collisionInfo.AddContactPoint(localA, localB, bestNormal, bestPenetration);
+	return true;
+}
+
+/*
+Boxes just check their corners against the surface, and use whichever is buried
+deepest. That's fine for terrain that's smooth compared to the size of the box,
+but a sharp peak could poke up through the middle of a large box unnoticed.
+*/
+bool CollisionDetection::HeightfieldBoxIntersection(const HeightfieldVolume& volumeA, const Transform& worldTransformA,
+	const Vector3& boxSize, const Quaternion& boxOrientation, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	Vector3 fieldPos	= worldTransformA.GetPosition();
+	Vector3 boxPos		= worldTransformB.GetPosition();
+	Matrix3 boxRot		= Matrix3(boxOrientation);
+
+	float	bestPenetration = 0.0f;
+	Vector3 bestCorner;
+	Vector3 bestNormal;
+	bool	found = false;
+	for (int i = 0; i < 8; ++i) {
+		Vector3 corner = boxPos + boxRot * Vector3(
+			(i & 1) ? boxSize.x : -boxSize.x,
+			(i & 2) ? boxSize.y : -boxSize.y,
+			(i & 4) ? boxSize.z : -boxSize.z);
+		Vector3 local = corner - fieldPos;
+
+		float	height;
+		Vector3 normal;
+		if (!volumeA.SampleSurface(local.x, local.z, height, normal)) {
+			continue;
+		}
+		float penetration = (height - local.y) * normal.y;
+		if (penetration > bestPenetration) {
+			bestPenetration = penetration;
+			bestCorner		= corner;
+			bestNormal		= normal;
+			found			= true;
+		}
+	}
+	if (!found) {
+		return false;
+	}
+	collisionInfo.AddContactPoint(bestCorner - fieldPos, bestCorner - boxPos, bestNormal, bestPenetration);
+	return true;
+}
+
+bool CollisionDetection::HeightfieldOBBIntersection(const HeightfieldVolume& volumeA, const Transform& worldTransformA,
+	const OBBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	return HeightfieldBoxIntersection(volumeA, worldTransformA, volumeB.GetHalfDimensions(), worldTransformB.GetOrientation(), worldTransformB, collisionInfo);
+}
+
+bool CollisionDetection::HeightfieldAABBIntersection(const HeightfieldVolume& volumeA, const Transform& worldTransformA,
+	const AABBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo) {
+	return HeightfieldBoxIntersection(volumeA, worldTransformA, volumeB.GetHalfDimensions(), Quaternion(), worldTransformB, collisionInfo);
+}
+
+/*
+Rays are first clipped to the heightfield's bounding box, and then walk across the
+grid one cell at a time (a 2D DDA), only testing the two triangles in each cell
+they pass over. As cells are visited in order along the ray, the first hit found
+is the closest one.
+*/
+bool CollisionDetection::RayHeightfieldIntersection(const Ray& r, const Transform& worldTransform, const HeightfieldVolume& volume, RayCollision& collision) {
+	if (volume.GetSamplesX() < 2 || volume.GetSamplesZ() < 2) {
+		return false;
+	}
+	Vector3 fieldPos	= worldTransform.GetPosition();
+	Vector3 origin		= r.GetPosition() - fieldPos;
+	Vector3 dir			= r.GetDirection();
+	Vector3 halfSize	= volume.GetHalfDimensions();
+	float	cellSize	= volume.GetCellSize();
+
+	Vector3 boxMin(-halfSize.x, volume.GetMinHeight(), -halfSize.z);
+	Vector3 boxMax( halfSize.x, volume.GetMaxHeight(),	halfSize.z);
+
+	float tEnter = 0.0f;
+	float tExit	 = FLT_MAX;
+	for (int axis = 0; axis < 3; ++axis) {
+		if (abs(dir[axis]) < 1e-8f) {
+			if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis]) {
+				return false;
+			}
+			continue;
+		}
+		float t1 = (boxMin[axis] - origin[axis]) / dir[axis];
+		float t2 = (boxMax[axis] - origin[axis]) / dir[axis];
+		tEnter	= max(tEnter, min(t1, t2));
+		tExit	= min(tExit, max(t1, t2));
+	}
+	if (tEnter > tExit) {
+		return false;
+	}
+
+	Vector3 start = origin + dir * tEnter;
+	int cellX = ClampCell((int)floor((start.x + halfSize.x) / cellSize), volume.GetSamplesX() - 2);
+	int cellZ = ClampCell((int)floor((start.z + halfSize.z) / cellSize), volume.GetSamplesZ() - 2);
+
+	int stepX = dir.x > 0.0f ? 1 : -1;
+	int stepZ = dir.z > 0.0f ? 1 : -1;
+
+	float nextX		= (cellX + (stepX > 0 ? 1 : 0)) * cellSize - halfSize.x;
+	float nextZ		= (cellZ + (stepZ > 0 ? 1 : 0)) * cellSize - halfSize.z;
+	float tMaxX		= abs(dir.x) > 1e-8f ? (nextX - origin.x) / dir.x : FLT_MAX;
+	float tMaxZ		= abs(dir.z) > 1e-8f ? (nextZ - origin.z) / dir.z : FLT_MAX;
+	float tDeltaX	= abs(dir.x) > 1e-8f ? cellSize / abs(dir.x) : FLT_MAX;
+	float tDeltaZ	= abs(dir.z) > 1e-8f ? cellSize / abs(dir.z) : FLT_MAX;
+
+	while (cellX >= 0 && cellZ >= 0 && cellX < volume.GetSamplesX() - 1 && cellZ < volume.GetSamplesZ() - 1) {
+		Vector3 p00 = volume.GetSamplePosition(cellX,	  cellZ);
+		Vector3 p10 = volume.GetSamplePosition(cellX + 1, cellZ);
+		Vector3 p01 = volume.GetSamplePosition(cellX,	  cellZ + 1);
+		Vector3 p11 = volume.GetSamplePosition(cellX + 1, cellZ + 1);
+
+		float bestT = FLT_MAX;
+		float t;
+		if (RayTriangleIntersection(origin, dir, p00, p01, p11, t) && t < bestT) {
+			bestT = t;
+		}
+		if (RayTriangleIntersection(origin, dir, p00, p11, p10, t) && t < bestT) {
+			bestT = t;
+		}
+		if (bestT < FLT_MAX) {
+			collision.rayDistance	= bestT;
+			collision.collidedAt	= r.GetPosition() + dir * bestT;
+			return true;
+		}
+		if (min(tMaxX, tMaxZ) > tExit) {
+			break;
+		}
+		if (tMaxX < tMaxZ) {
+			cellX += stepX;
+			tMaxX += tDeltaX;
+		}
+		else {
+			cellZ += stepZ;
+			tMaxZ += tDeltaZ;
+		}
+	}
+	return false;
+}
@@ -10,6 +10,7 @@
 #include "OBBVolume.h"
 #include "SphereVolume.h"
 #include "CapsuleVolume.h"
+#include "HeightfieldVolume.h"
 #include "Ray.h"
 
 using NCL::Camera;
@@ -71,6 +72,7 @@ namespace NCL {
 		static bool RayOBBIntersection(const Ray&r, const Transform& worldTransform, const OBBVolume&	volume, RayCollision& collision);
 		static bool RaySphereIntersection(const Ray&r, const Transform& worldTransform, const SphereVolume& volume, RayCollision& collision);
 		static bool RayCapsuleIntersection(const Ray& r, const Transform& worldTransform, const CapsuleVolume& volume, RayCollision& collision);
+		static bool RayHeightfieldIntersection(const Ray& r, const Transform& worldTransform, const HeightfieldVolume& volume, RayCollision& collision);
 
 
 		static bool RayPlaneIntersection(const Ray&r, const Plane&p, RayCollision& collisions);
@@ -79,6 +81,10 @@ namespace NCL {
 
 
 		static bool ObjectIntersection(GameObject* a, GameObject* b, CollisionInfo& collisionInfo);
+		static bool VolumeIntersection(const CollisionVolume* volA, const Transform& transformA,
+			const CollisionVolume* volB, const Transform& transformB, CollisionInfo& collisionInfo);
+		static bool VolumeOverlap(const CollisionVolume* volA, const Transform& transformA,
+			const CollisionVolume* volB, const Transform& transformB);
 
 
 		static bool AABBIntersection(	const AABBVolume& volumeA, const Transform& worldTransformA,
@@ -108,6 +114,18 @@ namespace NCL {
 		static bool SphereCapsuleIntersection(		const CapsuleVolume& volumeA, const Transform& worldTransformA,
 													const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
 
+		static bool HeightfieldSphereIntersection(const HeightfieldVolume& volumeA, const Transform& worldTransformA,
+			const SphereVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
+
+		static bool HeightfieldCapsuleIntersection(const HeightfieldVolume& volumeA, const Transform& worldTransformA,
+			const CapsuleVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
+
+		static bool HeightfieldOBBIntersection(const HeightfieldVolume& volumeA, const Transform& worldTransformA,
+			const OBBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
+
+		static bool HeightfieldAABBIntersection(const HeightfieldVolume& volumeA, const Transform& worldTransformA,
+			const AABBVolume& volumeB, const Transform& worldTransformB, CollisionInfo& collisionInfo);
+
 		static Vector3 Unproject(const Vector3& screenPos, const Camera& cam);
 
 		static Vector3 FindClosestPointOBB(const Vector3& massCenter1, const Vector3& massCenter2, const Vector3& pointA, const Vector3& pointB);
@@ -117,6 +135,10 @@ namespace NCL {
 		static Matrix4		GenerateInverseView(const Camera &c);
 
 	protected:
+		static bool HeightfieldSphereContact(const HeightfieldVolume& volume, const Vector3& fieldPos, const Vector3& centre, float radius,
+			Vector3& contactPoint, Vector3& normal, float& penetration);
+		static bool HeightfieldBoxIntersection(const HeightfieldVolume& volumeA, const Transform& worldTransformA,
+			const Vector3& boxSize, const Quaternion& boxOrientation, const Transform& worldTransformB, CollisionInfo& collisionInfo);
 	
 	private:
 		CollisionDetection()	{}
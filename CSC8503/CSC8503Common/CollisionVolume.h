@@ -1,4 +1,5 @@
 #pragma once
+#include "MemoryPool.h"
 
 using namespace NCL::CSC8503;
 
@@ -10,6 +11,7 @@ namespace NCL {
 		Mesh	= 8,
 		Capsule = 16,
 		Compound= 32,
+		Heightfield = 64,
 		Invalid = 256
 	};
 
@@ -19,7 +21,16 @@ namespace NCL {
 		CollisionVolume() {
 			type = VolumeType::Invalid;
 		}
-		~CollisionVolume() {}
+		virtual ~CollisionVolume() {}
+
+		//Volumes share the same pools as the objects they belong to
+		static void* operator new(size_t size) {
+			return PoolAllocator::Allocate(size);
+		}
+
+		static void operator delete(void* memory) {
+			PoolAllocator::Free(memory);
+		}
 
 		virtual Vector3 SupportFunction(const Transform& worldTransform, Vector3 axis) const = 0;
 
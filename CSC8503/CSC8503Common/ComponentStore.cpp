@@ -0,0 +1,31 @@
+#include "ComponentStore.h"
+#include "Transform.h"
+#include "PhysicsObject.h"
+#include "RenderObject.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	thread_local ComponentStores* currentStores = nullptr;
+}
+
+ComponentStores::ComponentStores() {
+}
+
+ComponentStores::~ComponentStores() {
+}
+
+ComponentStores& ComponentStores::GetCurrent() {
+	static ComponentStores defaultStores;
+	return currentStores ? *currentStores : defaultStores;
+}
+
+ComponentScope::ComponentScope(ComponentStores& stores) {
+	previous		= currentStores;
+	currentStores	= &stores;
+}
+
+ComponentScope::~ComponentScope() {
+	currentStores = previous;
+}
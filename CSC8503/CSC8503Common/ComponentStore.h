@@ -0,0 +1,262 @@
+#pragma once
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+namespace NCL {
+	namespace CSC8503 {
+		typedef unsigned int EntityID;
+
+		const EntityID NO_ENTITY = ~0u;
+
+		/*
+		Hands out the IDs every component store is keyed by. IDs are reused once
+		they're given back, so the stores' lookup tables stay as small as the
+		number of entities alive at once, rather than growing forever.
+		*/
+		class EntityRegistry	{
+		public:
+			static EntityID Create() {
+				EntityRegistry& r = Instance();
+				std::lock_guard<std::mutex> lock(r.mutex);
+				if (!r.freeIDs.empty()) {
+					EntityID e = r.freeIDs.back();
+					r.freeIDs.pop_back();
+					return e;
+				}
+				return r.nextID++;
+			}
+
+			static void Destroy(EntityID e) {
+				EntityRegistry& r = Instance();
+				std::lock_guard<std::mutex> lock(r.mutex);
+				r.freeIDs.emplace_back(e);
+			}
+
+		protected:
+			EntityRegistry() {
+				nextID = 0;
+			}
+
+			static EntityRegistry& Instance() {
+				static EntityRegistry registry;
+				return registry;
+			}
+
+			std::vector<EntityID>	freeIDs;
+			EntityID				nextID;
+			std::mutex				mutex;
+		};
+
+		/*
+		Keeps every component of one type together, in chunks of CHUNK_SIZE, rather
+		than each one being a separate allocation somewhere on the heap. Systems
+		that only care about one kind of component can then walk through them in
+		memory order, without dragging in the rest of each object.
+
+		Components never move once they've been added, so pointers to them (like
+		the Transform pointers held by physics and render objects) stay valid until
+		they're removed. Removing one leaves a gap that the next Add fills, so a
+		store only ever needs as many chunks as the most components it's held.
+
+		Add and Remove lock the store, so any thread can call them. A ForEach can
+		run at the same time, but only ever sees which entity owns each slot - it
+		mustn't touch any component another thread might be adding or removing
+		right then. GameWorld keeps to this by only visiting the components of its
+		own objects, which only it ever removes, and only between walks.
+		*/
+		template<class T>
+		class ComponentStore	{
+		public:
+			static const unsigned int CHUNK_SIZE = 256;
+
+			struct Chunk {
+				typename std::aligned_storage<sizeof(T), alignof(T)>::type data[CHUNK_SIZE];
+				std::atomic<EntityID> owners[CHUNK_SIZE];	//Set once the component's made, so ForEach never sees one half built
+
+				T* Get(unsigned int i) {
+					return reinterpret_cast<T*>(&data[i]);
+				}
+			};
+			typedef std::vector<Chunk*> ChunkList;
+
+			ComponentStore() {
+				count = 0;
+			}
+
+			~ComponentStore() {
+				for (Chunk* c : chunks) {
+					for (unsigned int i = 0; i < CHUNK_SIZE; ++i) {
+						if (c->owners[i] != NO_ENTITY) {
+							c->Get(i)->~T();
+						}
+					}
+					delete c;
+				}
+			}
+
+			template<class... Args>
+			T* Add(EntityID e, Args&&... args) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if (e >= entitySlots.size()) {
+					entitySlots.resize(e + 1, (unsigned int)NO_SLOT);
+				}
+				if (entitySlots[e] != NO_SLOT) {
+					return nullptr;		//Only one of each component per entity!
+				}
+				if (freeSlots.empty()) {
+					AddChunk();
+				}
+				unsigned int slot = freeSlots.back();
+				freeSlots.pop_back();
+
+				Chunk* c = chunks[slot / CHUNK_SIZE];
+				T* component = new (c->Get(slot % CHUNK_SIZE)) T(std::forward<Args>(args)...);
+				c->owners[slot % CHUNK_SIZE].store(e, std::memory_order_release);
+				entitySlots[e] = slot;
+				count++;
+				return component;
+			}
+
+			void Remove(EntityID e) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if (e >= entitySlots.size() || entitySlots[e] == NO_SLOT) {
+					return;
+				}
+				unsigned int slot = entitySlots[e];
+				Chunk* c = chunks[slot / CHUNK_SIZE];
+				c->owners[slot % CHUNK_SIZE].store(NO_ENTITY, std::memory_order_release);
+				c->Get(slot % CHUNK_SIZE)->~T();
+
+				entitySlots[e] = NO_SLOT;
+				freeSlots.emplace_back(slot);
+				count--;
+			}
+
+			T* Get(EntityID e) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if (e >= entitySlots.size() || entitySlots[e] == NO_SLOT) {
+					return nullptr;
+				}
+				unsigned int slot = entitySlots[e];
+				return chunks[slot / CHUNK_SIZE]->Get(slot % CHUNK_SIZE);
+			}
+
+			//Adds chunks until there's room for count more components without allocating
+			void Reserve(size_t count) {
+				std::lock_guard<std::mutex> lock(mutex);
+				while (freeSlots.size() < count) {
+					AddChunk();
+				}
+			}
+
+			//Visits every component in memory order, as func(EntityID, T&)
+			template<class F>
+			void ForEach(F func) {
+				ChunkList list = GetChunks();
+				ForEach(list, 0, list.size(), func);
+			}
+
+			//A copy of the chunk list, so a walk over the store can be split up between threads.
+			//Chunks are never freed, so it stays usable even if more are added meanwhile
+			ChunkList GetChunks() {
+				std::lock_guard<std::mutex> lock(mutex);
+				return chunks;
+			}
+
+			//Visits every component in chunks [first, last) of a list from GetChunks
+			template<class F>
+			static void ForEach(const ChunkList& list, size_t first, size_t last, F func) {
+				for (size_t c = first; c < last; ++c) {
+					Chunk* chunk = list[c];
+					for (unsigned int i = 0; i < CHUNK_SIZE; ++i) {
+						EntityID owner = chunk->owners[i].load(std::memory_order_acquire);
+						if (owner != NO_ENTITY) {
+							func(owner, *chunk->Get(i));
+						}
+					}
+				}
+			}
+
+			size_t Size() const {
+				return count;
+			}
+
+			size_t GetChunkCount() const {
+				return chunks.size();
+			}
+
+		protected:
+			static const unsigned int NO_SLOT = ~0u;
+
+			void AddChunk() {
+				Chunk* c = new Chunk();
+				unsigned int first = (unsigned int)chunks.size() * CHUNK_SIZE;
+				for (unsigned int i = 0; i < CHUNK_SIZE; ++i) {
+					c->owners[i] = NO_ENTITY;
+				}
+				//Pushed in reverse, so slots are handed out front to back
+				for (unsigned int i = CHUNK_SIZE; i > 0; --i) {
+					freeSlots.emplace_back(first + i - 1);
+				}
+				chunks.emplace_back(c);
+			}
+
+			std::vector<Chunk*>			chunks;
+			std::vector<unsigned int>	entitySlots;	//Where each entity's component is, indexed by EntityID
+			std::vector<unsigned int>	freeSlots;
+			std::atomic<size_t>			count;	//Read without the lock, by anything deciding whether a walk is worth it
+			std::mutex					mutex;
+		};
+
+		class Transform;
+		class PhysicsObject;
+		class RenderObject;
+
+		/*
+		A store for each kind of component a GameObject has. Every GameWorld owns a
+		set, so worlds stepped side by side on different threads never share chunks.
+		Objects take their components from whichever set has a ComponentScope open
+		on the thread making them (or a shared default set, if none is), and give
+		them back to that same set when they're deleted - so mustn't outlive it.
+		*/
+		class ComponentStores	{
+		public:
+			ComponentStores();
+			~ComponentStores();
+
+			ComponentStore<Transform>& GetTransforms() {
+				return transforms;
+			}
+
+			ComponentStore<PhysicsObject>& GetPhysicsObjects() {
+				return physicsObjects;
+			}
+
+			ComponentStore<RenderObject>& GetRenderObjects() {
+				return renderObjects;
+			}
+
+			//The set new objects made on this thread will use
+			static ComponentStores& GetCurrent();
+
+		protected:
+			ComponentStore<Transform>		transforms;
+			ComponentStore<PhysicsObject>	physicsObjects;
+			ComponentStore<RenderObject>	renderObjects;
+		};
+
+		//While one of these exists, objects made on this thread put their components in the given stores
+		class ComponentScope	{
+		public:
+			ComponentScope(ComponentStores& stores);
+			~ComponentScope();
+
+		protected:
+			ComponentStores* previous;
+		};
+	}
+}
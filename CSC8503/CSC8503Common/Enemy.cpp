@@ -3,13 +3,20 @@
 #include "StateMachine.h"
 #include "State.h"
 #include "PlayerObj.h"
+#include "GameWorld.h"
+#include "FlowField.h"
 
 using namespace NCL;
 using namespace CSC8503;
 
-Enemy::Enemy(std::vector<Vector3>& pathNodes, PlayerObj* player) : pathNodes(pathNodes) {
-	name = "Enemy";
-	pathFindingTarget = nullptr;
+Enemy::Enemy(std::vector<Vector3>& pathNodes, PlayerObj* player, GameWorld* world, const FlowField* playerField, const Vector3& fieldOffset)
+	: pathNodes(pathNodes) {
+	name = StringID::Intern("Enemy");
+	this->player		= player;
+	this->playerField	= playerField;
+	this->fieldOffset	= fieldOffset;
+	AddCollisionFilter("SpeedPowerup"_sid);
+	this->world = world;
 	stateMachine = new StateMachine();
 
 	State* stateA = new State([&](float dt)-> void
@@ -30,7 +37,8 @@ Enemy::Enemy(std::vector<Vector3>& pathNodes, PlayerObj* player) : pathNodes(pat
 		[&]()-> bool
 		{
 			//When the enemy has no idea where the player is, or there is a bonus around the stage
-		return Vector3::Distance(pathFindingTarget->GetTransform().GetPosition(), GetTransform().GetPosition()) < 20;
+			GameObject* target = GetTarget();
+			return target && Vector3::Distance(target->GetTransform().GetPosition(), GetTransform().GetPosition()) < 20;
 		}
 	));
 
@@ -38,7 +46,8 @@ Enemy::Enemy(std::vector<Vector3>& pathNodes, PlayerObj* player) : pathNodes(pat
 		[&]()-> bool
 		{
 			//When the enemy spots the player
-			return Vector3::Distance(pathFindingTarget->GetTransform().GetPosition(), GetTransform().GetPosition()) >= 20;
+			GameObject* target = GetTarget();
+			return !target || Vector3::Distance(target->GetTransform().GetPosition(), GetTransform().GetPosition()) >= 20;
 		}
 	));
 }
@@ -47,13 +56,28 @@ Enemy ::~Enemy() {
 	delete stateMachine;
 }
 
+GameObject* Enemy::GetTarget() const {
+	return world ? world->GetObject(pathFindingTarget) : nullptr;
+}
+
 void Enemy::Update(float dt) {
 	stateMachine->Update(dt);
 
 }
 
+bool Enemy::GetFlowDirection(Vector3& direction) const {
+	GameObject* target = GetTarget();
+	return playerField && target && target == (GameObject*)player
+		&& playerField->GetDirection(GetTransform().GetPosition() + fieldOffset, direction);
+}
+
 void Enemy::GoToTarget(float dt) {
 	//std::cout << "Walking to Target\n";
+	Vector3 flow;
+	if (GetFlowDirection(flow)) {
+		GetPhysicsObject()->AddForce(flow * moveSpeed * dt);
+		return;
+	}
 	if (pathNodes.size() == 0 || curNode >= pathNodes.size()-1) {
 		return;
 	}
@@ -76,6 +100,10 @@ void Enemy::GoToTarget(float dt) {
 
 void Enemy::HoneIn(float dt) {
 	//std::cout << "Close Chase\n";
-	Vector3 force = (pathFindingTarget->GetTransform().GetPosition() - GetTransform().GetPosition()).Normalised() * moveSpeed * dt;
+	GameObject* target = GetTarget();
+	if (!target) {
+		return;
+	}
+	Vector3 force = (target->GetTransform().GetPosition() - GetTransform().GetPosition()).Normalised() * moveSpeed * dt;
 	GetPhysicsObject()->AddForce(force);
 }
\ No newline at end of file
@@ -4,13 +4,17 @@
 namespace NCL {
 	namespace CSC8503 {
 		class PlayerObj;
+		class GameWorld;
+		class FlowField;
 		class Enemy : public StateGameObject {
 		public:
-			Enemy(std::vector<Vector3>& pathNodes, PlayerObj* player);
+			//The field, if there is one, leads to the player, from positions offset by fieldOffset
+			Enemy(std::vector<Vector3>& pathNodes, PlayerObj* player, GameWorld* world,
+				const FlowField* playerField = nullptr, const Vector3& fieldOffset = Vector3());
 			virtual ~Enemy();
 			virtual void OnCollisionBegin(GameObject* otherObject) override {
 				//Allow for temporary movement boost
-				if (otherObject->GetName() == "SpeedPowerup") {
+				if (otherObject->GetName() == "SpeedPowerup"_sid) {
 					moveSpeed += 10.0f;
 					speedTimer = 0;
 				}
@@ -20,23 +24,36 @@ namespace NCL {
 				canSeePlayer = canSee;
 			}
 
-			GameObject* GetTarget() { return pathFindingTarget; }
-			void SetTarget(GameObject* target) { this->pathFindingTarget = target; }
+			//Null if the target has since been removed from the world
+			GameObject* GetTarget() const;
+			void SetTarget(GameObject* target) {
+				pathFindingTarget = target ? target->GetHandle() : GameObjectHandle();
+			}
+
+			//While chasing the player along the flow field, the path nodes aren't needed
+			bool IsFollowingFlowField() const {
+				Vector3 direction;
+				return GetFlowDirection(direction);
+			}
 
 			virtual void Update(float dt) override;
 		protected:
+			bool GetFlowDirection(Vector3& direction) const;
 
 			void GoToTarget(float dt);
 			void HoneIn(float dt);
 
 			PlayerObj* player;
-			GameObject* pathFindingTarget;
+			GameWorld* world;
+			GameObjectHandle pathFindingTarget;
 			bool canSeePlayer;
 
 			StateMachine* stateMachine;
 			float speedTimer;
 
 			std::vector<Vector3>& pathNodes;
+			const FlowField* playerField;
+			Vector3 fieldOffset;
 			Vector3 currentNodePos;
 			int curNode;
 
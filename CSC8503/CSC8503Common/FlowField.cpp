@@ -0,0 +1,177 @@
+#include "FlowField.h"
+#include <climits>
+#include <utility>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	//Up, down, left and right like GridNode::connected, then the diagonals
+	const int	DIR_X[8]	= { 0, 0, -1, 1, -1, 1, -1, 1 };
+	const int	DIR_Z[8]	= { -1, 1, 0, 0, -1, -1, 1, 1 };
+	const float DIAGONAL	= 1.41421356f;
+}
+
+FlowField::FlowField(const NavigationGrid& grid, int nodesPerUpdate) : grid(grid) {
+	SetBudget(nodesPerUpdate);
+	current.targetNode	= -1;
+	current.gridVersion = 0;
+	next.targetNode		= -1;
+	next.gridVersion	= 0;
+	building			= false;
+	pendingTarget		= -1;
+	stage				= BuildStage::Integrating;
+	buildVersion		= 0;
+	queueHead			= 0;
+	directingNode		= 0;
+}
+
+void FlowField::SetTarget(const Vector3& target) {
+	int node = grid.GetNodeIndex(target);
+	if (node < 0) {
+		return;
+	}
+	int latest = pendingTarget >= 0 ? pendingTarget : (building ? next.targetNode : current.targetNode);
+	if (node == latest) {
+		return; //still in the same node, so nothing's changed
+	}
+	if (current.targetNode < 0) {
+		StartBuild(node);
+		Build(INT_MAX);
+		pendingTarget = -1;
+	}
+	else if (building) {
+		pendingTarget = node == next.targetNode ? -1 : node;	//picked up once this build is done
+	}
+	else {
+		StartBuild(node);
+	}
+}
+
+void FlowField::Update() {
+	if (building && buildVersion != grid.GetVersion()) {
+		//walls moved part way through, so start again, for the newest target
+		StartBuild(pendingTarget >= 0 ? pendingTarget : next.targetNode);
+		pendingTarget = -1;
+	}
+	else if (!building && current.targetNode >= 0 && current.gridVersion != grid.GetVersion()) {
+		StartBuild(current.targetNode);
+	}
+	if (building) {
+		Build(budget);
+		if (!building && pendingTarget >= 0) {
+			StartBuild(pendingTarget);
+			pendingTarget = -1;
+		}
+	}
+}
+
+void FlowField::StartBuild(int targetNode) {
+	int nodeCount = grid.GetWidth() * grid.GetHeight();
+	next.distances.assign(nodeCount, -1);
+	next.directions.assign(nodeCount, -1);
+	next.targetNode		= targetNode;
+	next.gridVersion	= grid.GetVersion();
+	buildVersion		= next.gridVersion;
+
+	queue.clear();
+	queueHead = 0;
+	if (grid.IsWalkable(targetNode % grid.GetWidth(), targetNode / grid.GetWidth())) {
+		next.distances[targetNode] = 0;
+		queue.emplace_back(targetNode);
+	}
+	stage			= BuildStage::Integrating;
+	directingNode	= 0;
+	building		= true;
+}
+
+/*
+Every node costs the same to cross, so spreading out breadth first from the
+target visits nodes in order of distance, exactly like Dijkstra would, without
+needing a priority queue. Directions can move diagonally, as long as neither
+of the nodes beside the diagonal is a wall, so agents don't zig-zag across
+open ground.
+*/
+void FlowField::Build(int nodeBudget) {
+	int width		= grid.GetWidth();
+	int nodeCount	= width * grid.GetHeight();
+	std::vector<int>& distances = next.distances;
+
+	while (nodeBudget > 0 && stage == BuildStage::Integrating) {
+		if (queueHead == queue.size()) {
+			stage = BuildStage::Directing;
+			break;
+		}
+		int node = queue[queueHead++];
+		int x = node % width;
+		int z = node / width;
+		for (int i = 0; i < 4; ++i) {
+			int nx = x + DIR_X[i];
+			int nz = z + DIR_Z[i];
+			if (!grid.IsWalkable(nx, nz) || distances[(nz * width) + nx] >= 0) {
+				continue;
+			}
+			distances[(nz * width) + nx] = distances[node] + 1;
+			queue.emplace_back((nz * width) + nx);
+		}
+		nodeBudget--;
+	}
+	while (nodeBudget > 0 && stage == BuildStage::Directing && directingNode < nodeCount) {
+		int node		= directingNode++;
+		int distance	= distances[node];
+		nodeBudget--;
+		if (distance <= 0) {
+			continue; //either the target, or can't reach it
+		}
+		int x = node % width;
+		int z = node / width;
+		int		best		= -1;
+		float	bestGain	= 0.0f;
+		for (int i = 0; i < 8; ++i) {
+			int nx = x + DIR_X[i];
+			int nz = z + DIR_Z[i];
+			if (!grid.IsWalkable(nx, nz)) {
+				continue;
+			}
+			if (i >= 4 && (!grid.IsWalkable(nx, z) || !grid.IsWalkable(x, nz))) {
+				continue; //would clip the corner of a wall
+			}
+			int neighbourDistance = distances[(nz * width) + nx];
+			float gain = (distance - neighbourDistance) / (i >= 4 ? DIAGONAL : 1.0f);
+			if (neighbourDistance >= 0 && gain > bestGain) {
+				best		= i;
+				bestGain	= gain;
+			}
+		}
+		next.directions[node] = (char)best;
+	}
+	if (stage == BuildStage::Directing && directingNode >= nodeCount) {
+		std::swap(current, next);
+		building = false;
+	}
+}
+
+bool FlowField::GetDirection(const Vector3& position, Vector3& direction) const {
+	int node = grid.GetNodeIndex(position);
+	if (node < 0 || current.targetNode < 0) {
+		return false;
+	}
+	if (node == current.targetNode) {
+		direction = Vector3(0, 0, 0); //already there
+		return true;
+	}
+	int i = current.directions[node];
+	if (i < 0) {
+		return false;
+	}
+	direction = Vector3((float)DIR_X[i], 0, (float)DIR_Z[i]).Normalised();
+	return true;
+}
+
+int FlowField::GetDistance(const Vector3& position) const {
+	int node = grid.GetNodeIndex(position);
+	if (node < 0 || current.targetNode < 0) {
+		return -1;
+	}
+	return current.distances[node];
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "NavigationGrid.h"
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		For lots of agents all heading to the same place. Rather than each one
+		searching for its own path, a single search spreads out from the target
+		over the whole grid, recording how many steps every node is from it (the
+		integration field). Each node then points at whichever neighbour gets
+		closest (the direction field), so any number of agents can just look up
+		which way to go from wherever they are.
+
+		Nothing's rebuilt while the target stays in the same node. Once it moves
+		on, both fields are built again from scratch rather than repaired - with
+		the target even one node over, nearly every node's distance changes, so a
+		repair would visit as much of the grid as a rebuild. Instead, the rebuild
+		is spread over the next few Updates, a budget of nodes at a time, while
+		agents carry on following the old fields - which still lead to where the
+		target just was, so are never far wrong. If the target
+		moves again before that build is done, the build still finishes, and
+		only the newest target is kept to be built next, so a target that never
+		stops still gets a new field every few Updates. Changes to the grid's
+		walls start a rebuild the same way.
+		*/
+		class FlowField	{
+		public:
+			FlowField(const NavigationGrid& grid, int nodesPerUpdate = 4096);
+			~FlowField() {}
+
+			//The first target is built straight away, so there's always something to follow
+			void SetTarget(const Vector3& target);
+
+			//Carries on with any rebuild
+			void Update();
+
+			//Which way to go from a position, flat on the XZ plane. False if there's no way to the target from there
+			bool GetDirection(const Vector3& position, Vector3& direction) const;
+
+			//How many nodes away from the target a position is, or -1 if it can't get there
+			int GetDistance(const Vector3& position) const;
+
+			bool IsUpToDate() const {
+				return !building && pendingTarget < 0;
+			}
+
+			void SetBudget(int nodesPerUpdate) {
+				budget = nodesPerUpdate > 0 ? nodesPerUpdate : 1;
+			}
+
+		protected:
+			enum class BuildStage {
+				Integrating,
+				Directing
+			};
+
+			struct Field {
+				std::vector<int>	distances;
+				std::vector<char>	directions;	//Index into the direction tables, or -1 for nowhere to go
+				int					targetNode;
+				unsigned int		gridVersion;
+			};
+
+			void StartBuild(int targetNode);
+			void Build(int nodeBudget);
+
+			const NavigationGrid&	grid;
+			int						budget;
+
+			Field					current;	//The one agents follow
+			Field					next;		//The one being built
+
+			bool					building;
+			int						pendingTarget;	//Where to build for once the current build swaps in, or -1
+			BuildStage				stage;
+			unsigned int			buildVersion;	//The grid version the one being built started from
+			std::vector<int>		queue;
+			size_t					queueHead;
+			int						directingNode;
+		};
+	}
+}
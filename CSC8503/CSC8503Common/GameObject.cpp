@@ -3,20 +3,40 @@
 
 using namespace NCL::CSC8503;
 
-GameObject::GameObject(string objectName, int layer)	{
-	name			= objectName;
+GameObject::GameObject(string objectName, int layer)
+	: entity(EntityRegistry::Create()), stores(ComponentStores::GetCurrent()), transform(*stores.GetTransforms().Add(entity))	{
+	name			= StringID::Intern(objectName);
 	worldID			= -1;
 	isActive		= true;
+	isTrigger		= false;
 	boundingVolume	= nullptr;
 	physicsObject	= nullptr;
 	renderObject	= nullptr;
+	journal			= nullptr;
 	this->layer = layer;
 }
 
 GameObject::~GameObject()	{
 	delete boundingVolume;
-	delete physicsObject;
-	delete renderObject;
+
+	stores.GetPhysicsObjects().Remove(entity);
+	stores.GetRenderObjects().Remove(entity);
+	stores.GetTransforms().Remove(entity);
+	EntityRegistry::Destroy(entity);
+}
+
+PhysicsObject* GameObject::AddPhysicsObject() {
+	ComponentStore<PhysicsObject>& store = stores.GetPhysicsObjects();
+	store.Remove(entity);	//In case one was already added
+	SetPhysicsObject(store.Add(entity, &transform, boundingVolume));
+	return physicsObject;
+}
+
+RenderObject* GameObject::AddRenderObject(MeshGeometry* mesh, TextureBase* tex, ShaderBase* shader) {
+	ComponentStore<RenderObject>& store = stores.GetRenderObjects();
+	store.Remove(entity);
+	SetRenderObject(store.Add(entity, &transform, mesh, tex, shader));
+	return renderObject;
 }
 
 bool GameObject::GetBroadphaseAABB(Vector3&outSize) const {
@@ -44,4 +64,13 @@ void GameObject::UpdateBroadphaseAABB() {
 		Vector3 halfSizes = ((OBBVolume&)*boundingVolume).GetHalfDimensions();
 		broadphaseAABB = mat * halfSizes;
 	}
+	else if (boundingVolume->type == VolumeType::Capsule) {
+		const CapsuleVolume& capsule = (CapsuleVolume&)*boundingVolume;
+		Vector3 lineExtent = transform.GetOrientation() * Vector3(0, capsule.GetHalfHeight() - capsule.GetRadius(), 0);
+		float	r = capsule.GetRadius();
+		broadphaseAABB = Vector3(abs(lineExtent.x) + r, abs(lineExtent.y) + r, abs(lineExtent.z) + r);
+	}
+	else if (boundingVolume->type == VolumeType::Heightfield) {
+		broadphaseAABB = ((HeightfieldVolume&)*boundingVolume).GetHalfDimensions();
+	}
 }
\ No newline at end of file
@@ -4,6 +4,11 @@
 
 #include "PhysicsObject.h"
 #include "RenderObject.h"
+#include "WorldJournal.h"
+#include "SlotMap.h"
+#include "ComponentStore.h"
+#include "MemoryPool.h"
+#include "StringID.h"
 
 #include <vector>
 
@@ -23,13 +28,25 @@ namespace NCL {
 
 		};
 
+		typedef SlotHandle GameObjectHandle;
+
 		class GameObject	{
 		public:
 			GameObject(string name = "", int layer = Layer::Other);
-			~GameObject();
+			virtual ~GameObject();
+
+			//Objects come from the shared pools, or the level arena while one is in scope
+			static void* operator new(size_t size) {
+				return PoolAllocator::Allocate(size);
+			}
+
+			static void operator delete(void* memory) {
+				PoolAllocator::Free(memory);
+			}
 
 			void SetBoundingVolume(CollisionVolume* vol) {
 				boundingVolume = vol;
+				LogChange();
 			}
 
 			const CollisionVolume* GetBoundingVolume() const {
@@ -40,6 +57,11 @@ namespace NCL {
 				return isActive;
 			}
 
+			void SetActive(bool state) {
+				isActive = state;
+				LogChange();
+			}
+
 			Transform& GetTransform() {
 				return transform;
 			}
@@ -52,18 +74,43 @@ namespace NCL {
 				return physicsObject;
 			}
 
-			void SetRenderObject(RenderObject* newObject) {
-				renderObject = newObject;
+			//These make the component in its type's ComponentStore, alongside those of
+			//every other object made for the same world, so systems can walk through them all at once
+			PhysicsObject*	AddPhysicsObject();
+			RenderObject*	AddRenderObject(MeshGeometry* mesh, TextureBase* tex, ShaderBase* shader);
+
+			EntityID GetEntity() const {
+				return entity;
 			}
 
-			void SetPhysicsObject(PhysicsObject* newObject) {
-				physicsObject = newObject;
+			//Where this object's components are kept, picked by the ComponentScope it was made in
+			ComponentStores& GetComponentStores() const {
+				return stores;
 			}
 
-			const string& GetName() const {
+			//Use GetName().GetString() to get the name back as text
+			StringID GetName() const {
 				return name;
 			}
 
+			//Once any are added, the collision and trigger functions are only called for
+			//objects with one of these names, so objects only hear about what they care about
+			void AddCollisionFilter(StringID otherName) {
+				collisionFilter.emplace_back(otherName);
+			}
+
+			bool PassesCollisionFilter(const GameObject* otherObject) const {
+				if (collisionFilter.empty()) {
+					return true;
+				}
+				for (StringID n : collisionFilter) {
+					if (n == otherObject->name) {
+						return true;
+					}
+				}
+				return false;
+			}
+
 			virtual void OnCollisionBegin(GameObject* otherObject) {
 				//std::cout << "OnCollisionBegin event occured!\n";
 			}
@@ -72,6 +119,16 @@ namespace NCL {
 				//std::cout << "OnCollisionEnd event occured!\n";
 			}
 
+			//Called on both objects when one of them is a trigger. Triggers only report
+			//overlaps, so by default these are passed on as an ordinary collision
+			virtual void OnTriggerEnter(GameObject* otherObject) {
+				OnCollisionBegin(otherObject);
+			}
+
+			virtual void OnTriggerExit(GameObject* otherObject) {
+				OnCollisionEnd(otherObject);
+			}
+
 			virtual void OnSelect() {
 
 			}
@@ -82,6 +139,15 @@ namespace NCL {
 
 			void SetLayer(int layer) {
 				this->layer = layer;
+				LogChange();
+			}
+
+			bool IsTrigger() const {
+				return isTrigger;
+			}
+
+			void SetTrigger(bool state) {
+				isTrigger = state;
 			}
 
 			bool GetBroadphaseAABB(Vector3&outsize) const;
@@ -96,17 +162,54 @@ namespace NCL {
 				return worldID;
 			}
 
+			//Set by the world the object is added to. Hold on to this rather than the
+			//object itself, and the world can tell you if the object has gone
+			void SetHandle(GameObjectHandle newHandle) {
+				handle = newHandle;
+			}
+
+			GameObjectHandle GetHandle() const {
+				return handle;
+			}
+
+			//Set by the world the object is added to, so it can log what happens to the object
+			void SetJournal(WorldJournal* newJournal) {
+				journal = newJournal;
+				transform.SetJournal(newJournal, this);
+			}
+
 		protected:
-			Transform			transform;
+			void SetRenderObject(RenderObject* newObject) {
+				renderObject = newObject;
+				LogChange();
+			}
+
+			void SetPhysicsObject(PhysicsObject* newObject) {
+				physicsObject = newObject;
+			}
+
+			void LogChange() {
+				if (journal) {
+					journal->ObjectChanged(this);
+				}
+			}
+
+			EntityID			entity;		//These must come before transform, which is made using them!
+			ComponentStores&	stores;
+			Transform&			transform;
+			WorldJournal*		journal;
+			GameObjectHandle	handle;
 
 			CollisionVolume*	boundingVolume;
 			PhysicsObject*		physicsObject;
 			RenderObject*		renderObject;
 
 			bool	isActive;
+			bool	isTrigger;
 			int		worldID;
-			string	name;
+			StringID name;
 			int layer;
+			std::vector<StringID> collisionFilter;
 
 			Vector3 broadphaseAABB;
 		};
@@ -1,6 +1,7 @@
 #include "GameWorld.h"
 #include "GameObject.h"
 #include "Constraint.h"
+#include "JobSystem.h"
 #include "CollisionDetection.h"
 #include "../../Common/Camera.h"
 #include <algorithm>
@@ -14,33 +15,75 @@ GameWorld::GameWorld()	{
 	shuffleConstraints	= false;
 	shuffleObjects		= false;
 	worldIDCounter		= 0;
+
+	staticTree			= nullptr;
+	dynamicTree			= nullptr;
+	treeOutsiders		= nullptr;
+	broadphaseValid		= false;
+	foreignObjects		= 0;
 }
 
 GameWorld::~GameWorld()	{
 }
 
 void GameWorld::Clear() {
-	gameObjects.clear();
+	journal.ObjectsDestroyed(gameObjects.Values());
+	for (GameObject* o : gameObjects) {
+		o->SetJournal(nullptr);
+		o->SetHandle(GameObjectHandle());
+	}
+	gameObjects.Clear();
+	entityObjects.clear();
 	constraints.clear();
+	broadphaseValid = false;
+	foreignObjects	= 0;
 }
 
 void GameWorld::ClearAndErase() {
+	journal.ObjectsDestroyed(gameObjects.Values());
 	for (auto& i : gameObjects) {
 		delete i;
 	}
 	for (auto& i : constraints) {
 		delete i;
 	}
+	gameObjects.Clear();
 	Clear();
+	levelArena.Release();	//Everything that was made in it has just been deleted
 }
 
 void GameWorld::AddGameObject(GameObject* o) {
-	gameObjects.emplace_back(o);
+	o->SetHandle(gameObjects.Insert(o));
 	o->SetWorldID(worldIDCounter++);
+	if (o->GetEntity() >= entityObjects.size()) {
+		entityObjects.resize(o->GetEntity() + 1, nullptr);
+	}
+	entityObjects[o->GetEntity()] = o;
+	o->SetJournal(&journal);
+	journal.ObjectCreated(o);
+	broadphaseValid = false;
+	if (&o->GetComponentStores() != &components) {
+		foreignObjects++;
+	}
 }
 
+/*
+Objects know their own handle, so removing one is just a swap with whatever
+object is at the end of the list - no searching needed. This does mean the
+order objects are iterated in changes whenever something is removed!
+*/
 void GameWorld::RemoveGameObject(GameObject* o, bool andDelete) {
-	gameObjects.erase(std::remove(gameObjects.begin(), gameObjects.end(), o), gameObjects.end());
+	if (GetObject(o->GetHandle()) == o) {	//Might not be in this world, or already removed
+		gameObjects.Remove(o->GetHandle());
+		entityObjects[o->GetEntity()] = nullptr;
+		o->SetHandle(GameObjectHandle());
+		journal.ObjectDestroyed(o);
+		o->SetJournal(nullptr);
+		broadphaseValid = false;
+		if (&o->GetComponentStores() != &components) {
+			foreignObjects--;
+		}
+	}
 	if (andDelete) {
 		delete o;
 	}
@@ -60,17 +103,123 @@ void GameWorld::OperateOnContents(GameObjectFunc f) {
 	}
 }
 
+void GameWorld::ParallelOperateOnContents(GameObjectFunc f, int grainSize) {
+	const std::vector<GameObject*>& objects = gameObjects.Values();
+	JobSystem::Instance().ParallelFor(0, (int)objects.size(), grainSize,
+		[&](int first, int last) {
+			for (int i = first; i < last; ++i) {
+				f(objects[i]);
+			}
+		}
+	);
+}
+
+/*
+The world's own stores can only be walked if every object in it keeps its
+components there - anything made outside of a ComponentScope for this world
+would be missed. Even then, it only pays off when most of what's in them is
+still in the world, rather than (say) cells a streamer has loaded but not yet
+put in, so otherwise the world goes through its own object list instead.
+*/
+bool GameWorld::WalkStore(size_t storeSize) const {
+	return foreignObjects == 0 && gameObjects.Size() * 2 >= storeSize;
+}
+
+void GameWorld::ParallelOperateOnPhysicsObjects(PhysicsObjectFunc f) {
+	typedef ComponentStore<PhysicsObject> Store;
+	Store& store = components.GetPhysicsObjects();
+	if (!WalkStore(store.Size())) {
+		ParallelOperateOnContents(
+			[&](GameObject* o) {
+				PhysicsObject* object = o->GetPhysicsObject();
+				if (object) {
+					f(o, *object);
+				}
+			}
+		);
+		return;
+	}
+	Store::ChunkList chunks = store.GetChunks();
+	JobSystem::Instance().ParallelFor(0, (int)chunks.size(), 1,
+		[&](int first, int last) {
+			Store::ForEach(chunks, first, last,
+				[&](EntityID e, PhysicsObject& object) {
+					GameObject* o = GetEntityObject(e);
+					if (o) {
+						f(o, object);
+					}
+				}
+			);
+		}
+	);
+}
+
+void GameWorld::OperateOnRenderObjects(RenderObjectFunc f) {
+	ComponentStore<RenderObject>& store = components.GetRenderObjects();
+	if (!WalkStore(store.Size())) {
+		for (GameObject* o : gameObjects) {
+			RenderObject* object = o->GetRenderObject();
+			if (object) {
+				f(o, *object);
+			}
+		}
+		return;
+	}
+	store.ForEach(
+		[&](EntityID e, RenderObject& object) {
+			GameObject* o = GetEntityObject(e);
+			if (o) {
+				f(o, object);
+			}
+		}
+	);
+}
+
 void GameWorld::UpdateWorld(float dt) {
 	if (shuffleObjects) {
-		std::random_shuffle(gameObjects.begin(), gameObjects.end());
+		gameObjects.Shuffle(randomGenerator);
 	}
 
 	if (shuffleConstraints) {
-		std::random_shuffle(constraints.begin(), constraints.end());
+		std::shuffle(constraints.begin(), constraints.end(), randomGenerator);
+	}
+
+	journal.EndFrame();
+}
+
+bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObject, int layerMask) const {
+	return RaycastMany(&r, &closestCollision, 1, closestObject, layerMask) > 0;
+}
+
+/*
+If the physics system has given us its broadphase trees, rays are sent through
+them in packets of up to 8 at a time, so only the objects in the leaves a ray
+actually passes through get a full ray intersection test. Anything too far out
+to fit in the trees is tested on its own. Otherwise we fall back to testing
+every object in the world, one ray at a time.
+*/
+int GameWorld::RaycastMany(const Ray* rays, RayCollision* collisions, int rayCount, bool closestObject, int layerMask) const {
+	int hits = 0;
+	if (!broadphaseValid) {
+		for (int i = 0; i < rayCount; ++i) {
+			collisions[i] = RayCollision();
+			if (RaycastLinear(rays[i], collisions[i], closestObject, layerMask)) {
+				hits++;
+			}
+		}
+		return hits;
+	}
+	for (int i = 0; i < rayCount; i += QuadTreeRayPacket::MAX_RAYS) {
+		int count = rayCount - i;
+		if (count > QuadTreeRayPacket::MAX_RAYS) {
+			count = QuadTreeRayPacket::MAX_RAYS;
+		}
+		hits += RaycastPacket(&rays[i], &collisions[i], count, closestObject, layerMask);
 	}
+	return hits;
 }
 
-bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObject) const {
+bool GameWorld::RaycastLinear(const Ray& r, RayCollision& closestCollision, bool closestObject, int layerMask) const {
 	//The simplest raycast just goes through each object and sees if there's a collision
 	RayCollision collision;
 
@@ -78,12 +227,15 @@ bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObje
 		if (!i->GetBoundingVolume()) { //objects might not be collideable etc...
 			continue;
 		}
+		if (!(i->GetLayer() & layerMask)) {
+			continue;
+		}
 		RayCollision thisCollision;
 		if (CollisionDetection::RayIntersection(r, *i, thisCollision)) {
 				
 			if (!closestObject) {	
-				closestCollision		= collision;
-				closestCollision.node = i;
+				closestCollision		= thisCollision;
+				closestCollision.node	= i;
 				return true;
 			}
 			else {
@@ -102,6 +254,226 @@ bool GameWorld::Raycast(Ray& r, RayCollision& closestCollision, bool closestObje
 	return false;
 }
 
+int GameWorld::RaycastPacket(const Ray* rays, RayCollision* collisions, int rayCount, bool closestObject, int layerMask) const {
+	QuadTreeRayPacket packet;
+	for (int i = 0; i < rayCount; ++i) {
+		packet.AddRay(rays[i].GetPosition(), rays[i].GetDirection());
+		collisions[i] = RayCollision();
+	}
+
+	//Cheap box test first, using the broadphase AABB, then a full test for each ray that hits it
+	auto testObject = [&](GameObject* o, const Vector3& pos, const Vector3& size, unsigned int activeMask) {
+		if (!(o->GetLayer() & layerMask)) {
+			return;
+		}
+		unsigned int rayMask = packet.TestBox(pos - size, pos + size, activeMask);
+
+		for (int i = 0; rayMask; ++i, rayMask >>= 1) {
+			if (!(rayMask & 1)) {
+				continue;
+			}
+			RayCollision thisCollision;
+			if (!CollisionDetection::RayIntersection(rays[i], *o, thisCollision)) {
+				continue;
+			}
+			if (thisCollision.rayDistance < collisions[i].rayDistance) {
+				collisions[i]		= thisCollision;
+				collisions[i].node	= o;
+				packet.maxT[i]		= thisCollision.rayDistance;
+			}
+			if (!closestObject) {
+				packet.finishedMask |= (1u << i);	//Any hit will do, so this ray is done
+			}
+		}
+	};
+	auto leafFunc = [&](const std::list<QuadTreeEntry<GameObject*>>& contents, unsigned int activeMask) {
+		for (const auto& entry : contents) {
+			testObject(entry.object, entry.pos, entry.size, activeMask);
+		}
+	};
+	//An object can sit in more than one leaf, but it'll only replace a hit if it's closer
+	staticTree->RayPacketCast(packet, leafFunc);
+	dynamicTree->RayPacketCast(packet, leafFunc);
+
+	if (treeOutsiders) {
+		for (GameObject* o : *treeOutsiders) {
+			Vector3 size;
+			if (o->GetBroadphaseAABB(size)) {
+				testObject(o, o->GetTransform().GetPosition(), size, ~0u);
+			}
+		}
+	}
+
+	int hits = 0;
+	for (int i = 0; i < rayCount; ++i) {
+		if (collisions[i].node) {
+			hits++;
+		}
+	}
+	return hits;
+}
+
+
+/*
+Shape queries. Just like the raycasts, these use the physics system's broadphase
+trees when they're up to date, to narrow down which objects need a proper
+intersection test. Results go into buffers owned by the caller, and the
+candidate gathering is all templated, so a query never allocates anything.
+*/
+template<class F>
+void GameWorld::GatherCandidates(const Vector3& position, const Vector3& halfSizes, int layerMask, F func) const {
+	if (broadphaseValid) {
+		auto visit = [&](const QuadTreeEntry<GameObject*>& entry) {
+			if (entry.object->GetLayer() & layerMask) {
+				func(entry.object);
+			}
+		};
+		staticTree->VisitOverlapping(position, halfSizes, visit);
+		dynamicTree->VisitOverlapping(position, halfSizes, visit);
+	}
+	auto testObject = [&](GameObject* o) {
+		Vector3 objectSize;
+		if (!o->GetBroadphaseAABB(objectSize) || !(o->GetLayer() & layerMask)) {
+			return;
+		}
+		if (CollisionDetection::AABBTest(position, o->GetTransform().GetPosition(), halfSizes, objectSize)) {
+			func(o);
+		}
+	};
+	if (!broadphaseValid) {
+		for (GameObject* o : gameObjects) {
+			testObject(o);
+		}
+	}
+	else if (treeOutsiders) {
+		for (GameObject* o : *treeOutsiders) {
+			testObject(o);
+		}
+	}
+}
+
+int GameWorld::OverlapVolume(const CollisionVolume* volume, const Transform& transform, const Vector3& halfSizes,
+	GameObject** results, int maxResults, int layerMask) const {
+	int found = 0;
+	GatherCandidates(transform.GetPosition(), halfSizes, layerMask, [&](GameObject* o) {
+		if (found >= maxResults) {
+			return;
+		}
+		//Large objects can sit in more than one leaf of the tree
+		for (int i = 0; i < found; ++i) {
+			if (results[i] == o) {
+				return;
+			}
+		}
+		if (CollisionDetection::VolumeOverlap(volume, transform, o->GetBoundingVolume(), o->GetTransform())) {
+			results[found++] = o;
+		}
+	});
+	return found;
+}
+
+int GameWorld::OverlapSphere(const Vector3& position, float radius, GameObject** results, int maxResults, int layerMask) const {
+	SphereVolume volume(radius);
+	Transform transform;
+	transform.SetPosition(position);
+	return OverlapVolume((CollisionVolume*)&volume, transform, Vector3(radius, radius, radius), results, maxResults, layerMask);
+}
+
+int GameWorld::OverlapBox(const Vector3& position, const Vector3& halfSizes, const Quaternion& orientation,
+	GameObject** results, int maxResults, int layerMask) const {
+	OBBVolume volume(halfSizes);
+	Transform transform;
+	transform.SetPosition(position);
+	transform.SetOrientation(orientation);
+
+	Vector3 boxExtents = Matrix3(orientation).Absolute() * halfSizes;
+	return OverlapVolume((CollisionVolume*)&volume, transform, boxExtents, results, maxResults, layerMask);
+}
+
+/*
+Sweeps are done by stepping the shape along its path, a fraction of its radius
+at a time, against everything the swept box touches. Once a step overlaps an
+object, we bisect between it and the previous step to find the first point of
+contact. Objects thinner than the step size can be missed at the very edges of
+the path, but anything the game uses is much larger than that.
+*/
+bool GameWorld::SweepVolume(const CollisionVolume* volume, const Quaternion& orientation, const Vector3& halfSizes,
+	const Vector3& from, const Vector3& to, float stepLength, SweepHit& hit, int layerMask) const {
+	const int	maxSteps		= 256;
+	const int	bisectionSteps	= 10;
+
+	Vector3 travel		= to - from;
+	Vector3 sweptPos	= (from + to) * 0.5f;
+	Vector3 sweptSize	= halfSizes + Vector3(abs(travel.x), abs(travel.y), abs(travel.z)) * 0.5f;
+
+	int steps = stepLength > 0.0f ? (int)ceil(travel.Length() / stepLength) : maxSteps;
+	if (steps > maxSteps) {
+		steps = maxSteps;
+	}
+
+	Transform transform;
+	transform.SetOrientation(orientation);
+
+	auto touchesAt = [&](GameObject* o, float fraction) {
+		transform.SetPosition(from + travel * fraction);
+		return CollisionDetection::VolumeOverlap(volume, transform, o->GetBoundingVolume(), o->GetTransform());
+	};
+
+	hit = SweepHit();
+	GatherCandidates(sweptPos, sweptSize, layerMask, [&](GameObject* o) {
+		float fraction = -1.0f;
+		if (touchesAt(o, 0.0f)) {
+			fraction = 0.0f;
+		}
+		else {
+			float lastClear = 0.0f;
+			for (int i = 1; i <= steps; ++i) {
+				if (hit.object && lastClear >= hit.fraction) {
+					return;		//Can't beat what we've already found
+				}
+				float next = (float)i / (float)steps;
+				if (!touchesAt(o, next)) {
+					lastClear = next;
+					continue;
+				}
+				for (int j = 0; j < bisectionSteps; ++j) {
+					float mid = (lastClear + next) * 0.5f;
+					if (touchesAt(o, mid)) {
+						next = mid;
+					}
+					else {
+						lastClear = mid;
+					}
+				}
+				fraction = next;
+				break;
+			}
+		}
+		if (fraction >= 0.0f && (!hit.object || fraction < hit.fraction)) {
+			hit.object		= o;
+			hit.fraction	= fraction;
+			hit.position	= from + travel * fraction;
+		}
+	});
+	return hit.object != nullptr;
+}
+
+bool GameWorld::SweepSphere(const Vector3& from, const Vector3& to, float radius, SweepHit& hit, int layerMask) const {
+	SphereVolume volume(radius);
+	return SweepVolume((CollisionVolume*)&volume, Quaternion(), Vector3(radius, radius, radius),
+		from, to, radius * 0.5f, hit, layerMask);
+}
+
+bool GameWorld::SweepCapsule(const Vector3& from, const Vector3& to, const Quaternion& orientation,
+	float halfHeight, float radius, SweepHit& hit, int layerMask) const {
+	CapsuleVolume volume(halfHeight, radius);
+
+	Vector3 lineExtent	= orientation * Vector3(0, halfHeight - radius, 0);
+	Vector3 halfSizes	= Vector3(abs(lineExtent.x) + radius, abs(lineExtent.y) + radius, abs(lineExtent.z) + radius);
+
+	return SweepVolume((CollisionVolume*)&volume, orientation, halfSizes, from, to, radius * 0.5f, hit, layerMask);
+}
+
 
 /*
 Constraint Tutorial Stuff
@@ -1,18 +1,39 @@
 #pragma once
 #include <vector>
+#include <random>
 #include "Ray.h"
 #include "CollisionDetection.h"
 #include "QuadTree.h"
+#include "WorldJournal.h"
+#include "SlotMap.h"
+#include "WorldCommandBuffer.h"
+#include "MemoryPool.h"
+#include "ComponentStore.h"
 namespace NCL {
 		class Camera;
 		using Maths::Ray;
 	namespace CSC8503 {
 		class GameObject;
 		class Constraint;
+		class PhysicsObject;
+		class RenderObject;
 
 		typedef std::function<void(GameObject*)> GameObjectFunc;
+		typedef std::function<void(GameObject*, PhysicsObject&)> PhysicsObjectFunc;
+		typedef std::function<void(GameObject*, RenderObject&)> RenderObjectFunc;
 		typedef std::vector<GameObject*>::const_iterator GameObjectIterator;
 
+		struct SweepHit {
+			GameObject* object;
+			float		fraction;	//How far along the sweep the first contact is, from 0 to 1
+			Vector3		position;	//Where the shape was when it first touched the object
+
+			SweepHit() {
+				object		= nullptr;
+				fraction	= 1.0f;
+			}
+		};
+
 		class GameWorld	{
 		public:
 			GameWorld();
@@ -24,9 +45,41 @@ namespace NCL {
 			void AddGameObject(GameObject* o);
 			void RemoveGameObject(GameObject* o, bool andDelete = false);
 
+			//Returns nullptr if the object has since been removed from the world
+			GameObject* GetObject(GameObjectHandle h) const {
+				GameObject* const* o = gameObjects.Get(h);
+				return o ? *o : nullptr;
+			}
+
+			//Makes room for count more objects, for when a lot are about to be added at once
+			void ReserveObjects(size_t count) {
+				gameObjects.Reserve(gameObjects.Size() + count);
+			}
+
 			void AddConstraint(Constraint* c);
 			void RemoveConstraint(Constraint* c, bool andDelete = false);
 
+			//Changes queued from callbacks or other threads, to be made at the next ApplyCommands
+			WorldCommandBuffer& GetCommands() {
+				return commands;
+			}
+
+			//Call once per frame, at a point where nothing else is using the world
+			void ApplyCommands() {
+				commands.Apply(*this);
+			}
+
+			//Use with an ArenaScope while building a level. It's released by ClearAndErase
+			LevelArena& GetLevelArena() {
+				return levelArena;
+			}
+
+			//Open a ComponentScope with these while making objects for this world, so the
+			//physics and render loops can walk their components without any other world's
+			ComponentStores& GetComponents() {
+				return components;
+			}
+
 			Camera* GetMainCamera() const {
 				return mainCamera;
 			}
@@ -39,12 +92,58 @@ namespace NCL {
 				shuffleObjects = state;
 			}
 
-			bool Raycast(Ray& r, RayCollision& closestCollision, bool closestObject = false) const;
+			//Each world shuffles with its own generator, so worlds never affect each other's results
+			void SetRandomSeed(unsigned int seed) {
+				randomGenerator.seed(seed);
+			}
+
+			bool Raycast(Ray& r, RayCollision& closestCollision, bool closestObject = false, int layerMask = ~0) const;
+			//Casts rayCount rays at once, filling in one collision per ray. Returns how many rays hit something
+			int RaycastMany(const Ray* rays, RayCollision* collisions, int rayCount, bool closestObject = false, int layerMask = ~0) const;
+
+			//Fills results with up to maxResults objects touching the given shape, and returns how many were found
+			int OverlapSphere(const Vector3& position, float radius, GameObject** results, int maxResults, int layerMask = ~0) const;
+			int OverlapBox(const Vector3& position, const Vector3& halfSizes, const Quaternion& orientation,
+				GameObject** results, int maxResults, int layerMask = ~0) const;
+
+			//Moves a shape from 'from' towards 'to', and reports the first object it would touch
+			bool SweepSphere(const Vector3& from, const Vector3& to, float radius, SweepHit& hit, int layerMask = ~0) const;
+			bool SweepCapsule(const Vector3& from, const Vector3& to, const Quaternion& orientation,
+				float halfHeight, float radius, SweepHit& hit, int layerMask = ~0) const;
+
+			//The physics system hands over its broadphase trees after each update, so
+			//that queries don't have to test every object in the world, along with
+			//the objects that didn't fit inside the trees, which are tested one by one
+			void SetBroadphase(const QuadTree<GameObject*>* staticObjects, const QuadTree<GameObject*>* dynamicObjects,
+				const std::vector<GameObject*>* outsideObjects = nullptr) {
+				staticTree			= staticObjects;
+				dynamicTree			= dynamicObjects;
+				treeOutsiders		= outsideObjects;
+				broadphaseValid		= staticObjects && dynamicObjects;
+			}
 
 			virtual void UpdateWorld(float dt);
 
+			//Everything created, destroyed or moved since each subsystem last checked
+			WorldJournal& GetJournal() {
+				return journal;
+			}
+
 			void OperateOnContents(GameObjectFunc f);
 
+			//Splits the objects up across the job system. f must only change the object it's given!
+			void ParallelOperateOnContents(GameObjectFunc f, int grainSize = 128);
+
+			//These visit every object in the world with that component, walking the component's store
+			//in memory order where they can, so the loop only pulls in the data it's working on
+			void ParallelOperateOnPhysicsObjects(PhysicsObjectFunc f);
+			void OperateOnRenderObjects(RenderObjectFunc f);
+
+			//Which of this world's objects has the given entity, if any
+			GameObject* GetEntityObject(EntityID e) const {
+				return e < entityObjects.size() ? entityObjects[e] : nullptr;
+			}
+
 			void GetObjectIterators(
 				GameObjectIterator& first,
 				GameObjectIterator& last) const;
@@ -54,14 +153,41 @@ namespace NCL {
 				std::vector<Constraint*>::const_iterator& last) const;
 
 		protected:
-			std::vector<GameObject*> gameObjects;
+			bool RaycastLinear(const Ray& r, RayCollision& closestCollision, bool closestObject, int layerMask) const;
+			int	 RaycastPacket(const Ray* rays, RayCollision* collisions, int rayCount, bool closestObject, int layerMask) const;
+
+			int	 OverlapVolume(const CollisionVolume* volume, const Transform& transform, const Vector3& halfSizes,
+				GameObject** results, int maxResults, int layerMask) const;
+			bool SweepVolume(const CollisionVolume* volume, const Quaternion& orientation, const Vector3& halfSizes,
+				const Vector3& from, const Vector3& to, float stepLength, SweepHit& hit, int layerMask) const;
+
+			template<class F>
+			void GatherCandidates(const Vector3& position, const Vector3& halfSizes, int layerMask, F func) const;
+
+			bool WalkStore(size_t storeSize) const;
+
+			SlotMap<GameObject*>	 gameObjects;
+			std::vector<GameObject*> entityObjects;	//Indexed by EntityID, for going from a component back to its object
 			std::vector<Constraint*> constraints;
 
+			WorldJournal		journal;
+			WorldCommandBuffer	commands;
+			LevelArena			levelArena;
+			ComponentStores		components;
+			size_t				foreignObjects;	//Objects in the world whose components are in some other stores
+
 			Camera* mainCamera;
 
 			bool	shuffleConstraints;
 			bool	shuffleObjects;
 			int		worldIDCounter;
+
+			std::mt19937 randomGenerator;
+
+			const QuadTree<GameObject*>* staticTree;
+			const QuadTree<GameObject*>* dynamicTree;
+			const std::vector<GameObject*>* treeOutsiders;
+			bool	broadphaseValid;	//Trees are out of date as soon as objects are added or removed
 		};
 	}
 }
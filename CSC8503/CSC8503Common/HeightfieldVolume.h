@@ -0,0 +1,138 @@
+#pragma once
+#include "CollisionVolume.h"
+#include "../../Common/Vector3.h"
+#include <vector>
+
+namespace NCL {
+	/*
+	A grid of height samples, centred on its transform's position in X and Z,
+	with each height measured up from the transform's position. Like an AABB,
+	the transform's orientation and scale are ignored. Each grid cell is split
+	into two triangles along its (0,0) -> (1,1) diagonal, so any point can be
+	mapped straight to the one triangle under it.
+	*/
+	class HeightfieldVolume : CollisionVolume
+	{
+	public:
+		using CollisionVolume::operator new;
+		using CollisionVolume::operator delete;
+
+		HeightfieldVolume(int samplesX, int samplesZ, float cellSize, const std::vector<float>& heights) {
+			type			= VolumeType::Heightfield;
+			this->samplesX	= samplesX;
+			this->samplesZ	= samplesZ;
+			this->cellSize	= cellSize;
+			this->heights	= heights;
+			this->heights.resize(samplesX * samplesZ, 0.0f);
+
+			minHeight = maxHeight = this->heights.empty() ? 0.0f : this->heights[0];
+			for (float h : this->heights) {
+				minHeight = h < minHeight ? h : minHeight;
+				maxHeight = h > maxHeight ? h : maxHeight;
+			}
+		}
+		~HeightfieldVolume() {}
+
+		Vector3 SupportFunction(const Transform& worldTransform, Vector3 axis) const override {
+			Vector3 halfSize = GetHalfDimensions();
+			return worldTransform.GetPosition() + Vector3(
+				axis.x < 0 ? -halfSize.x : halfSize.x,
+				axis.y < 0 ? minHeight : maxHeight,
+				axis.z < 0 ? -halfSize.z : halfSize.z);
+		}
+
+		int GetSamplesX() const {
+			return samplesX;
+		}
+
+		int GetSamplesZ() const {
+			return samplesZ;
+		}
+
+		float GetCellSize() const {
+			return cellSize;
+		}
+
+		float GetMinHeight() const {
+			return minHeight;
+		}
+
+		float GetMaxHeight() const {
+			return maxHeight;
+		}
+
+		//Symmetrical about the transform's position, so it can be used as a broadphase box.
+		//Everything under the surface counts as solid, so the box reaches well below the
+		//lowest point too, to keep catching objects that have sunk into the terrain
+		Vector3 GetHalfDimensions() const {
+			const float solidDepth = 10.0f;
+			float above = maxHeight + 0.01f;
+			float below = solidDepth - minHeight;
+			float halfY = above > below ? above : below;
+			return Vector3((samplesX - 1) * cellSize * 0.5f, halfY, (samplesZ - 1) * cellSize * 0.5f);
+		}
+
+		float GetHeight(int x, int z) const {
+			return heights[z * samplesX + x];
+		}
+
+		//Position of a sample, relative to the transform's position
+		Vector3 GetSamplePosition(int x, int z) const {
+			Vector3 halfSize = GetHalfDimensions();
+			return Vector3(x * cellSize - halfSize.x, GetHeight(x, z), z * cellSize - halfSize.z);
+		}
+
+		//Which cell a local position falls in. Returns false if it's off the edge of the grid
+		bool GetCell(float localX, float localZ, int& cellX, int& cellZ) const {
+			Vector3 halfSize = GetHalfDimensions();
+			float gridX = (localX + halfSize.x) / cellSize;
+			float gridZ = (localZ + halfSize.z) / cellSize;
+			if (gridX < 0.0f || gridZ < 0.0f || gridX > samplesX - 1 || gridZ > samplesZ - 1) {
+				return false;
+			}
+			cellX = (int)gridX < samplesX - 2 ? (int)gridX : samplesX - 2;
+			cellZ = (int)gridZ < samplesZ - 2 ? (int)gridZ : samplesZ - 2;
+			return true;
+		}
+
+		//Height and surface normal of the triangle under a local position
+		bool SampleSurface(float localX, float localZ, float& height, Vector3& normal) const {
+			int cellX;
+			int cellZ;
+			if (samplesX < 2 || samplesZ < 2 || !GetCell(localX, localZ, cellX, cellZ)) {
+				return false;
+			}
+			Vector3 halfSize = GetHalfDimensions();
+			float fx = (localX + halfSize.x) / cellSize - cellX;
+			float fz = (localZ + halfSize.z) / cellSize - cellZ;
+
+			float h00 = GetHeight(cellX,	 cellZ);
+			float h10 = GetHeight(cellX + 1, cellZ);
+			float h01 = GetHeight(cellX,	 cellZ + 1);
+			float h11 = GetHeight(cellX + 1, cellZ + 1);
+
+			float slopeX;
+			float slopeZ;
+			if (fx >= fz) {	//Triangle (0,0) (1,1) (1,0)
+				slopeX = h10 - h00;
+				slopeZ = h11 - h10;
+			}
+			else {			//Triangle (0,0) (0,1) (1,1)
+				slopeX = h11 - h01;
+				slopeZ = h01 - h00;
+			}
+			height = h00 + slopeX * fx + slopeZ * fz;
+			normal = Vector3(-slopeX / cellSize, 1.0f, -slopeZ / cellSize).Normalised();
+			return true;
+		}
+
+	protected:
+		std::vector<float> heights;
+
+		int		samplesX;
+		int		samplesZ;
+		float	cellSize;
+		float	minHeight;
+		float	maxHeight;
+	};
+}
@@ -0,0 +1,469 @@
+#include "HierarchicalGrid.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace NCL;
+using namespace CSC8503;
+
+const char WALL_NODE			= 'x';
+const int  WIDE_ENTRANCE		= 6;	//Openings at least this wide get an entrance at each end, rather than one in the middle
+
+HierarchicalGrid::HierarchicalGrid(const NavigationGrid& grid, int clusterSize) {
+	Init(grid.GetWidth(), grid.GetHeight(), grid.GetNodeSize(), clusterSize);
+	this->grid	= &grid;
+	gridVersion = grid.GetVersion();
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			walkable[(y * width) + x] = grid.IsWalkable(x, y) ? 1 : 0;
+		}
+	}
+	for (int i = 0; i < clustersX * clustersY; ++i) {
+		dirtyClusters.emplace_back(i);
+	}
+	Refresh();
+}
+
+HierarchicalGrid::HierarchicalGrid(int width, int height, int nodeSize, const std::string& types, int clusterSize) {
+	Init(width, height, nodeSize, clusterSize);
+	grid		= nullptr;
+	gridVersion = 0;
+	for (int i = 0; i < width * height; ++i) {
+		walkable[i] = (i < (int)types.size() && types[i] != WALL_NODE) ? 1 : 0;
+	}
+	for (int i = 0; i < clustersX * clustersY; ++i) {
+		dirtyClusters.emplace_back(i);
+	}
+	Refresh();
+}
+
+void HierarchicalGrid::Init(int width, int height, int nodeSize, int clusterSize) {
+	this->width			= width;
+	this->height		= height;
+	this->nodeSize		= nodeSize;
+	this->clusterSize	= clusterSize > 1 ? clusterSize : 2;
+	clustersX			= (width  + this->clusterSize - 1) / this->clusterSize;
+	clustersY			= (height + this->clusterSize - 1) / this->clusterSize;
+
+	walkable.assign(width * height, 0);
+	borders.assign(clustersX * clustersY * 2, std::vector<Transition>());
+	clusterNodes.assign(clustersX * clustersY, std::vector<int>());
+
+	clusterDistances.assign(this->clusterSize * this->clusterSize, -1);
+	clusterParents.assign(this->clusterSize * this->clusterSize, -1);
+	searchedCluster = -1;
+	searchCount		= 0;
+	expandedCount	= 0;
+	rebuildCount	= 0;
+}
+
+void HierarchicalGrid::SetNodeType(int x, int y, char type) {
+	if (grid || x < 0 || x > width - 1 || y < 0 || y > height - 1) {
+		return;
+	}
+	int cell = (y * width) + x;
+	char isWalkable = type != WALL_NODE ? 1 : 0;
+	if (walkable[cell] != isWalkable) {
+		walkable[cell] = isWalkable;
+		dirtyClusters.emplace_back(GetCluster(cell));
+	}
+}
+
+//Picks up any changes to the grid, and rebuilds only the clusters they were in
+void HierarchicalGrid::Refresh() {
+	if (grid && grid->GetVersion() != gridVersion) {
+		gridVersion = grid->GetVersion();
+		for (int y = 0; y < height; ++y) {
+			for (int x = 0; x < width; ++x) {
+				int cell = (y * width) + x;
+				char isWalkable = grid->IsWalkable(x, y) ? 1 : 0;
+				if (walkable[cell] != isWalkable) {
+					walkable[cell] = isWalkable;
+					dirtyClusters.emplace_back(GetCluster(cell));
+				}
+			}
+		}
+	}
+	if (dirtyClusters.empty()) {
+		return;
+	}
+	std::sort(dirtyClusters.begin(), dirtyClusters.end());
+	dirtyClusters.erase(std::unique(dirtyClusters.begin(), dirtyClusters.end()), dirtyClusters.end());
+	RebuildClusters(dirtyClusters);
+	dirtyClusters.clear();
+}
+
+int HierarchicalGrid::GetCluster(int cell) const {
+	return ((cell / width) / clusterSize) * clustersX + ((cell % width) / clusterSize);
+}
+
+/*
+A changed node can change the openings along any of its cluster's four borders,
+and every entrance on those borders has a partner in the neighbouring cluster,
+so the neighbours have their entrances rebuilt too. Their other borders can't
+have changed, so nothing further out needs touching.
+*/
+void HierarchicalGrid::RebuildClusters(const std::vector<int>& clusters) {
+	std::vector<int> changedBorders;
+	std::vector<int> changedClusters;
+	for (int c : clusters) {
+		int cx = c % clustersX;
+		int cy = c / clustersX;
+		changedBorders.emplace_back(c * 2);
+		changedBorders.emplace_back(c * 2 + 1);
+		changedClusters.emplace_back(c);
+		if (cx > 0) {
+			changedBorders.emplace_back((c - 1) * 2);
+			changedClusters.emplace_back(c - 1);
+		}
+		if (cy > 0) {
+			changedBorders.emplace_back((c - clustersX) * 2 + 1);
+			changedClusters.emplace_back(c - clustersX);
+		}
+		if (cx < clustersX - 1) {
+			changedClusters.emplace_back(c + 1);
+		}
+		if (cy < clustersY - 1) {
+			changedClusters.emplace_back(c + clustersX);
+		}
+	}
+	std::sort(changedBorders.begin(), changedBorders.end());
+	changedBorders.erase(std::unique(changedBorders.begin(), changedBorders.end()), changedBorders.end());
+	std::sort(changedClusters.begin(), changedClusters.end());
+	changedClusters.erase(std::unique(changedClusters.begin(), changedClusters.end()), changedClusters.end());
+
+	for (int b : changedBorders) {
+		BuildBorder(b / 2, b % 2);
+	}
+	for (int c : changedClusters) {
+		RebuildCluster(c);
+	}
+	rebuildCount += (int)changedClusters.size();
+}
+
+//Side 0 is the cluster's right edge, side 1 its bottom edge
+void HierarchicalGrid::BuildBorder(int cluster, int side) {
+	std::vector<Transition>& transitions = borders[cluster * 2 + side];
+	transitions.clear();
+
+	int cx = cluster % clustersX;
+	int cy = cluster / clustersX;
+	if ((side == 0 && cx == clustersX - 1) || (side == 1 && cy == clustersY - 1)) {
+		return; //edge of the map, so nothing on the other side
+	}
+	//Works along the border, cellA on this side of it and cellB on the other
+	int ax		= side == 0 ? ((cx + 1) * clusterSize) - 1 : cx * clusterSize;
+	int ay		= side == 0 ? cy * clusterSize : ((cy + 1) * clusterSize) - 1;
+	int stepX	= side == 0 ? 0 : 1;
+	int stepY	= side == 0 ? 1 : 0;
+	int length	= side == 0 ? std::min(clusterSize, height - ay) : std::min(clusterSize, width - ax);
+
+	auto addTransition = [&](int i) {
+		int x = ax + stepX * i;
+		int y = ay + stepY * i;
+		transitions.push_back({ (y * width) + x, ((y + stepX) * width) + x + stepY });
+	};
+	int runStart = -1;
+	for (int i = 0; i <= length; ++i) {
+		int x = ax + stepX * i;
+		int y = ay + stepY * i;
+		bool open = i < length && Walkable(x, y) && Walkable(x + stepY, y + stepX);
+		if (open && runStart < 0) {
+			runStart = i;
+		}
+		else if (!open && runStart >= 0) {
+			int runEnd = i - 1;
+			if (runEnd - runStart + 1 < WIDE_ENTRANCE) {
+				addTransition((runStart + runEnd) / 2);
+			}
+			else {
+				addTransition(runStart);
+				addTransition(runEnd);
+			}
+			runStart = -1;
+		}
+	}
+}
+
+void HierarchicalGrid::RebuildCluster(int cluster) {
+	for (int id : clusterNodes[cluster]) {
+		cellToNode.erase(nodes[id].cell);
+		nodes[id].cell = -1;
+		nodes[id].edges.clear();
+		freeNodes.emplace_back(id);
+	}
+	clusterNodes[cluster].clear();
+
+	//Entrances, and the edges across the border to their partners
+	auto addBorder = [&](int border, bool isSideA) {
+		for (const Transition& t : borders[border]) {
+			int id = AddEntrance(isSideA ? t.cellA : t.cellB, cluster);
+			nodes[id].edges.push_back({ isSideA ? t.cellB : t.cellA, 1 });
+		}
+	};
+	int cx = cluster % clustersX;
+	int cy = cluster / clustersX;
+	addBorder(cluster * 2, true);
+	addBorder(cluster * 2 + 1, true);
+	if (cx > 0) {
+		addBorder((cluster - 1) * 2, false);
+	}
+	if (cy > 0) {
+		addBorder((cluster - clustersX) * 2 + 1, false);
+	}
+
+	//Then how far apart they all are, going only through this cluster
+	const std::vector<int>& entrances = clusterNodes[cluster];
+	for (size_t i = 0; i < entrances.size(); ++i) {
+		SearchCluster(cluster, nodes[entrances[i]].cell);
+		for (size_t j = 0; j < entrances.size(); ++j) {
+			int distance = GetClusterDistance(nodes[entrances[j]].cell);
+			if (i != j && distance > 0) {
+				nodes[entrances[i]].edges.push_back({ nodes[entrances[j]].cell, distance });
+			}
+		}
+	}
+}
+
+int HierarchicalGrid::AddEntrance(int cell, int cluster) {
+	auto i = cellToNode.find(cell);
+	if (i != cellToNode.end()) {
+		return i->second; //on the corner, so already an entrance to another border
+	}
+	int id;
+	if (freeNodes.empty()) {
+		id = (int)nodes.size();
+		nodes.emplace_back(EntranceNode());
+	}
+	else {
+		id = freeNodes.back();
+		freeNodes.pop_back();
+	}
+	nodes[id].cell		= cell;
+	nodes[id].cluster	= cluster;
+	cellToNode[cell]	= id;
+	clusterNodes[cluster].emplace_back(id);
+	return id;
+}
+
+//Breadth first, as every node costs the same to cross, so the first route found to anything is a shortest one
+void HierarchicalGrid::SearchCluster(int cluster, int fromCell) {
+	int minX = (cluster % clustersX) * clusterSize;
+	int minY = (cluster / clustersX) * clusterSize;
+	int maxX = std::min(minX + clusterSize, width);
+	int maxY = std::min(minY + clusterSize, height);
+
+	std::fill(clusterDistances.begin(), clusterDistances.end(), -1);
+	searchedCluster = cluster;
+
+	int fromX = fromCell % width;
+	int fromY = fromCell / width;
+	clusterDistances[(fromY - minY) * clusterSize + (fromX - minX)] = 0;
+	clusterParents[(fromY - minY) * clusterSize + (fromX - minX)]	= -1;
+	clusterQueue.clear();
+	clusterQueue.emplace_back(fromCell);
+
+	const int offsetX[4] = { 0, 0, -1, 1 };
+	const int offsetY[4] = { -1, 1, 0, 0 };
+	for (size_t head = 0; head < clusterQueue.size(); ++head) {
+		int cell	= clusterQueue[head];
+		int x		= cell % width;
+		int y		= cell / width;
+		int distance = clusterDistances[(y - minY) * clusterSize + (x - minX)];
+		for (int i = 0; i < 4; ++i) {
+			int nx = x + offsetX[i];
+			int ny = y + offsetY[i];
+			if (nx < minX || nx >= maxX || ny < minY || ny >= maxY || !walkable[(ny * width) + nx]) {
+				continue;
+			}
+			int local = (ny - minY) * clusterSize + (nx - minX);
+			if (clusterDistances[local] >= 0) {
+				continue;
+			}
+			clusterDistances[local] = distance + 1;
+			clusterParents[local]	= cell;
+			clusterQueue.emplace_back((ny * width) + nx);
+		}
+	}
+}
+
+//How far the last SearchCluster got to a cell in the same cluster, or -1 if it couldn't
+int HierarchicalGrid::GetClusterDistance(int cell) const {
+	int minX = (searchedCluster % clustersX) * clusterSize;
+	int minY = (searchedCluster / clustersX) * clusterSize;
+	return clusterDistances[((cell / width) - minY) * clusterSize + ((cell % width) - minX)];
+}
+
+//Adds every node after fromCell, up to and including toCell
+void HierarchicalGrid::RefineLeg(int fromCell, int toCell, std::vector<int>& cells) {
+	if (fromCell == toCell) {
+		return; //started on an entrance
+	}
+	if (std::abs((fromCell % width) - (toCell % width)) + std::abs((fromCell / width) - (toCell / width)) <= 1) {
+		cells.emplace_back(toCell); //straight across a border
+		return;
+	}
+	SearchCluster(GetCluster(fromCell), fromCell);
+	int minX = (searchedCluster % clustersX) * clusterSize;
+	int minY = (searchedCluster / clustersX) * clusterSize;
+
+	size_t first = cells.size();
+	for (int cell = toCell; cell != fromCell && cell >= 0; ) {
+		cells.emplace_back(cell);
+		cell = clusterParents[((cell / width) - minY) * clusterSize + ((cell % width) - minX)];
+	}
+	std::reverse(cells.begin() + first, cells.end());
+}
+
+bool HierarchicalGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
+	return FindPath(from, to, outPath, -1);
+}
+
+bool HierarchicalGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, int refineLegs) {
+	Refresh();
+
+	int fromX	= ((int)from.x / nodeSize);
+	int fromZ	= ((int)from.z / nodeSize);
+	int toX		= ((int)to.x / nodeSize);
+	int toZ		= ((int)to.z / nodeSize);
+	if (fromX < 0 || fromX > width - 1 || fromZ < 0 || fromZ > height - 1 ||
+		toX < 0 || toX > width - 1 || toZ < 0 || toZ > height - 1) {
+		return false; //outside of map region!
+	}
+	int start	= (fromZ * width) + fromX;
+	int goal	= (toZ * width) + toX;
+	if (!walkable[goal]) {
+		return false;
+	}
+
+	//The start and goal get their own slots after the entrances
+	int startSlot	= (int)nodes.size();
+	int goalSlot	= startSlot + 1;
+	if (searchNodes.size() < nodes.size() + 2) {
+		SearchNode empty;
+		empty.f				= 0;
+		empty.g				= 0;
+		empty.heapIndex		= -1;
+		empty.parent		= -1;
+		empty.searchID		= 0;
+		empty.closed		= false;
+		empty.goalSearchID	= 0;
+		empty.goalCost		= 0;
+		openHeap.Clear();
+		searchNodes.resize(nodes.size() + 2, empty);
+	}
+	searchCount++;
+	if (searchCount == 0) {	//Wrapped around, so old stamps could look current again
+		for (SearchNode& n : searchNodes) {
+			n.searchID		= 0;
+			n.goalSearchID	= 0;
+		}
+		searchCount = 1;
+	}
+	openHeap.Clear();
+	expandedCount = 0;
+
+	//Hook the goal up to the entrances of its cluster...
+	int goalCluster = GetCluster(goal);
+	SearchCluster(goalCluster, goal);
+	for (int id : clusterNodes[goalCluster]) {
+		int distance = GetClusterDistance(nodes[id].cell);
+		if (distance >= 0) {
+			searchNodes[id].goalSearchID	= searchCount;
+			searchNodes[id].goalCost		= distance;
+		}
+	}
+	//...and the start to the entrances of its own, or maybe straight to the goal
+	std::vector<std::pair<int, int>> startEdges;
+	int startCluster = GetCluster(start);
+	SearchCluster(startCluster, start);
+	for (int id : clusterNodes[startCluster]) {
+		int distance = GetClusterDistance(nodes[id].cell);
+		if (distance >= 0) {
+			startEdges.emplace_back(id, distance);
+		}
+	}
+	if (startCluster == goalCluster && GetClusterDistance(goal) >= 0) {
+		startEdges.emplace_back(goalSlot, GetClusterDistance(goal));
+	}
+
+	auto slotCell = [&](int slot) {
+		return slot == startSlot ? start : (slot == goalSlot ? goal : nodes[slot].cell);
+	};
+	auto relax = [&](int fromSlot, int toSlot, int cost) {
+		SearchNode& n = searchNodes[toSlot];
+		bool seen = n.searchID == searchCount;
+		if (seen && n.closed) {
+			return;
+		}
+		float g = searchNodes[fromSlot].g + cost;
+		if (seen && g >= n.g) {
+			return;
+		}
+		int cell = slotCell(toSlot);
+		n.parent	= fromSlot;
+		n.g			= g;
+		n.f			= g + (float)(std::abs((cell % width) - toX) + std::abs((cell / width) - toZ));
+		if (!seen) {
+			n.searchID	= searchCount;
+			n.closed	= false;
+			openHeap.Push(&n);
+		}
+		else {
+			openHeap.DecreaseKey(&n);
+		}
+	};
+
+	SearchNode& startNode	= searchNodes[startSlot];
+	startNode.searchID		= searchCount;
+	startNode.closed		= false;
+	startNode.g				= 0;
+	startNode.f				= 0;
+	startNode.parent		= -1;
+	openHeap.Push(&startNode);
+
+	while (!openHeap.Empty()) {
+		SearchNode* current = openHeap.Pop();
+		int slot = (int)(current - searchNodes.data());
+		expandedCount++;
+
+		if (slot == goalSlot) {
+			std::vector<int> entrances;
+			for (int s = goalSlot; s >= 0; s = searchNodes[s].parent) {
+				entrances.emplace_back(slotCell(s));
+			}
+			std::reverse(entrances.begin(), entrances.end());
+
+			std::vector<int> cells(1, start);
+			for (size_t i = 0; i + 1 < entrances.size(); ++i) {
+				if (refineLegs < 0 || (int)i < refineLegs) {
+					RefineLeg(entrances[i], entrances[i + 1], cells);
+				}
+				else {
+					cells.emplace_back(entrances[i + 1]);
+				}
+			}
+			for (auto i = cells.rbegin(); i != cells.rend(); ++i) {
+				outPath.PushWaypoint(NodePosition(*i));
+			}
+			return true;
+		}
+		current->closed = true;
+
+		if (slot == startSlot) {
+			for (const std::pair<int, int>& e : startEdges) {
+				relax(slot, e.first, e.second);
+			}
+			continue;
+		}
+		for (const Edge& e : nodes[slot].edges) {
+			auto i = cellToNode.find(e.toCell);
+			if (i != cellToNode.end()) {
+				relax(slot, i->second, e.cost);
+			}
+		}
+		if (current->goalSearchID == searchCount) {
+			relax(slot, goalSlot, current->goalCost);
+		}
+	}
+	return false; //open list emptied out with no path!
+}
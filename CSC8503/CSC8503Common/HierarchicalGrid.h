@@ -0,0 +1,138 @@
+#pragma once
+#include "NavigationGrid.h"
+#include "IndexedHeap.h"
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Hierarchical pathfinding (HPA*) for grids too big to search node by node.
+		The grid is cut up into square clusters, and wherever two neighbouring
+		clusters share an opening along their border, a pair of entrance nodes
+		is placed across it - one in the middle of a narrow opening, or one at
+		each end of a wide one. How far each entrance is from every other one in
+		the same cluster is worked out up front, so the entrances form a much
+		smaller graph that gets searched instead of the grid itself.
+
+		A query hooks the start and goal up to the entrances of their clusters,
+		searches the entrance graph, then refines each leg of that back into
+		grid nodes with a search that never leaves a single cluster. Refining is
+		optional past the first few legs, for things that will ask again before
+		they get that far. Paths are almost always as short as the best possible,
+		but can be a few nodes longer, as they have to pass through entrances.
+
+		Walls can come from a NavigationGrid, which is checked for changes on each
+		query, or be given directly, so huge maps don't need a full NavigationGrid.
+		Either way, changing a node only rebuilds the clusters around it.
+		*/
+		class HierarchicalGrid : public NavigationMap	{
+		public:
+			HierarchicalGrid(const NavigationGrid& grid, int clusterSize = 16);
+			//types holds one character per node, row by row, in the same format as NavigationGrid's files
+			HierarchicalGrid(int width, int height, int nodeSize, const std::string& types, int clusterSize = 16);
+			~HierarchicalGrid() {}
+
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) override;
+
+			//Only the first refineLegs legs of the path are refined, the rest are left as entrance nodes
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, int refineLegs);
+
+			//Only for grids given directly - ones from a NavigationGrid follow its changes instead
+			void SetNodeType(int x, int y, char type);
+
+			int GetEntranceCount() const {
+				return (int)cellToNode.size();
+			}
+
+			//How many entrance nodes the last FindPath took off its open list
+			int GetExpandedCount() const {
+				return expandedCount;
+			}
+
+			//How many clusters have been rebuilt since this was made
+			int GetRebuildCount() const {
+				return rebuildCount;
+			}
+
+		protected:
+			struct Edge {
+				int toCell;
+				int cost;
+			};
+
+			struct EntranceNode {
+				int					cell;
+				int					cluster;
+				std::vector<Edge>	edges;
+			};
+
+			struct SearchNode {
+				float			f;
+				float			g;
+				int				heapIndex;
+				int				parent;
+				unsigned int	searchID;
+				bool			closed;
+				unsigned int	goalSearchID;	//goalCost is only meaningful while this matches the current search
+				int				goalCost;
+			};
+
+			struct Transition {
+				int cellA;	//Left of or above the border
+				int cellB;
+			};
+
+			void	Init(int width, int height, int nodeSize, int clusterSize);
+			void	Refresh();
+
+			int		GetCluster(int cell) const;
+			void	BuildBorder(int cluster, int side);
+			void	RebuildClusters(const std::vector<int>& clusters);
+			void	RebuildCluster(int cluster);
+			int		AddEntrance(int cell, int cluster);
+			void	SearchCluster(int cluster, int fromCell);
+			int		GetClusterDistance(int cell) const;
+			void	RefineLeg(int fromCell, int toCell, std::vector<int>& cells);
+
+			bool	Walkable(int x, int y) const {
+				return x >= 0 && x < width && y >= 0 && y < height && walkable[(y * width) + x];
+			}
+
+			Vector3	NodePosition(int cell) const {
+				return Vector3((float)((cell % width) * nodeSize), 0, (float)((cell / width) * nodeSize));
+			}
+
+			const NavigationGrid*	grid;	//Or nullptr, if the walls were given directly
+			unsigned int			gridVersion;
+
+			int width;
+			int height;
+			int nodeSize;
+			int clusterSize;
+			int clustersX;
+			int clustersY;
+
+			std::vector<char>						walkable;
+			std::vector<std::vector<Transition>>	borders;		//2 per cluster, for its right and bottom edges
+			std::vector<std::vector<int>>			clusterNodes;	//Which entrance nodes are in each cluster
+			std::vector<EntranceNode>				nodes;
+			std::vector<int>						freeNodes;
+			std::unordered_map<int, int>			cellToNode;
+			std::vector<int>						dirtyClusters;
+
+			std::vector<SearchNode>		searchNodes;	//One per entrance node, then the start and goal
+			IndexedHeap<SearchNode>		openHeap;
+			unsigned int				searchCount;
+			int							expandedCount;
+			int							rebuildCount;
+
+			//For searching within a single cluster
+			std::vector<int>			clusterDistances;
+			std::vector<int>			clusterParents;
+			std::vector<int>			clusterQueue;
+			int							searchedCluster;
+		};
+	}
+}
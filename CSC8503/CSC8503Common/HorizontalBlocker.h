@@ -1,22 +1,11 @@
 #pragma once
-#include "StateGameObject.h"
+#include "KinematicMover.h"
 namespace NCL {
 	namespace CSC8503 {
-		class StateMachine;
-		class HorizontalBlocker : public StateGameObject {
+		class HorizontalBlocker : public KinematicMover {
 		public:
 			HorizontalBlocker();
 			~HorizontalBlocker();
-
-			virtual void Update(float dt) override;
-
-		protected:
-			void MoveLeft(float dt);
-			void MoveRight(float dt);
-
-			StateMachine* stateMachine;
-			float counter;
-
 		};
 
 	}
@@ -0,0 +1,103 @@
+#pragma once
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A binary min-heap of node pointers, ordered by each node's f value, for
+		A* open lists. Every node remembers where it is in the heap (heapIndex),
+		so when a better route to a node already in the heap is found, it can be
+		moved up to its new place straight away, rather than being searched for.
+		Pushing, popping and updating are all O(log n).
+
+		T just needs a float f, and an int heapIndex that the heap can use as it
+		likes - it's -1 whenever the node isn't in the heap.
+		*/
+		template<class T>
+		class IndexedHeap	{
+		public:
+			void Push(T* node) {
+				node->heapIndex = (int)nodes.size();
+				nodes.emplace_back(node);
+				SiftUp(node->heapIndex);
+			}
+
+			T* Pop() {
+				T* top	= nodes.front();
+				T* last = nodes.back();
+				nodes.pop_back();
+				if (!nodes.empty()) {
+					nodes[0]		= last;
+					last->heapIndex = 0;
+					SiftDown(0);
+				}
+				top->heapIndex = -1;
+				return top;
+			}
+
+			//Call after lowering the f value of a node that's already in the heap
+			void DecreaseKey(T* node) {
+				SiftUp(node->heapIndex);
+			}
+
+			bool Contains(const T* node) const {
+				return node->heapIndex >= 0 && node->heapIndex < (int)nodes.size() && nodes[node->heapIndex] == node;
+			}
+
+			void Clear() {
+				for (T* n : nodes) {
+					n->heapIndex = -1;
+				}
+				nodes.clear();
+			}
+
+			bool Empty() const {
+				return nodes.empty();
+			}
+
+			size_t Size() const {
+				return nodes.size();
+			}
+
+		protected:
+			void SiftUp(int i) {
+				T* node = nodes[i];
+				while (i > 0) {
+					int parent = (i - 1) / 2;
+					if (!(node->f < nodes[parent]->f)) {
+						break;
+					}
+					nodes[i] = nodes[parent];
+					nodes[i]->heapIndex = i;
+					i = parent;
+				}
+				nodes[i]		= node;
+				node->heapIndex = i;
+			}
+
+			void SiftDown(int i) {
+				T* node		= nodes[i];
+				int count	= (int)nodes.size();
+				while (true) {
+					int child = i * 2 + 1;
+					if (child >= count) {
+						break;
+					}
+					if (child + 1 < count && nodes[child + 1]->f < nodes[child]->f) {
+						child++;
+					}
+					if (!(nodes[child]->f < node->f)) {
+						break;
+					}
+					nodes[i] = nodes[child];
+					nodes[i]->heapIndex = i;
+					i = child;
+				}
+				nodes[i]		= node;
+				node->heapIndex = i;
+			}
+
+			std::vector<T*> nodes;
+		};
+	}
+}
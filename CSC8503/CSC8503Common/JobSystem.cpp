@@ -0,0 +1,149 @@
+#include "JobSystem.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	//Which job system's worker this thread is, if any, and which queue is its own
+	thread_local JobSystem* workerOf	= nullptr;
+	thread_local int		workerQueue = -1;
+}
+
+JobSystem::JobSystem(int threadCount) {
+	threadCount		= threadCount > 1 ? threadCount : 1;
+	queuedJobs		= 0;
+	shuttingDown	= false;
+
+	for (int i = 0; i < threadCount; ++i) {
+		queues.emplace_back(new JobQueue());
+	}
+	for (int i = 0; i < threadCount - 1; ++i) {
+		threads.emplace_back(&JobSystem::WorkerLoop, this, i);
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		shuttingDown = true;
+	}
+	jobAdded.notify_all();
+	for (std::thread& t : threads) {
+		t.join();
+	}
+}
+
+JobSystem& JobSystem::Instance() {
+	static JobSystem system;
+	return system;
+}
+
+void JobSystem::Run(JobFunc func, JobCounter& counter) {
+	counter.count++;
+	Push({ func, &counter });
+}
+
+/*
+If the dependency still has jobs running, the new job is parked on it, and
+whichever job finishes the dependency off starts it. Both sides check the
+count under the dependency's lock, so the job can't slip through the gap.
+*/
+void JobSystem::RunAfter(JobCounter& dependency, JobFunc func, JobCounter& counter) {
+	counter.count++;
+	{
+		std::lock_guard<std::mutex> lock(dependency.mutex);
+		if (dependency.count > 0) {
+			dependency.dependents.push_back({ func, &counter });
+			return;
+		}
+	}
+	Push({ func, &counter });
+}
+
+void JobSystem::Push(Job job) {
+	int index = (workerOf == this) ? workerQueue : (int)queues.size() - 1;
+	{
+		std::lock_guard<std::mutex> lock(queues[index]->mutex);
+		queues[index]->jobs.emplace_back(std::move(job));
+	}
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);	//So a worker can't miss the wake up
+		queuedJobs++;
+	}
+	jobAdded.notify_one();
+}
+
+bool JobSystem::PopJob(Job& job) {
+	int own = (workerOf == this) ? workerQueue : -1;
+	if (own >= 0) {
+		JobQueue& q = *queues[own];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (!q.jobs.empty()) {
+			job = std::move(q.jobs.back());
+			q.jobs.pop_back();
+			queuedJobs--;
+			return true;
+		}
+	}
+	//Start looking just after our own queue, so thieves don't all pick on the same worker
+	int count = (int)queues.size();
+	for (int i = 1; i <= count; ++i) {
+		JobQueue& q = *queues[(own + count + i) % count];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (!q.jobs.empty()) {
+			job = std::move(q.jobs.front());
+			q.jobs.pop_front();
+			queuedJobs--;
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::Execute(Job& job) {
+	job.func();
+
+	JobCounter* counter = job.counter;
+	std::vector<Job> ready;
+	{
+		std::lock_guard<std::mutex> lock(counter->mutex);
+		if (--counter->count == 0) {
+			ready.swap(counter->dependents);
+		}
+	}
+	for (Job& j : ready) {
+		Push(std::move(j));
+	}
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+	Job job;
+	while (counter.count > 0) {
+		if (PopJob(job)) {
+			Execute(job);
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+	//The last job might still be letting go of the counter's lock
+	std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void JobSystem::WorkerLoop(int index) {
+	workerOf	= this;
+	workerQueue = index;
+
+	Job job;
+	while (true) {
+		if (PopJob(job)) {
+			Execute(job);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		jobAdded.wait(lock, [&]() { return shuttingDown || queuedJobs > 0; });
+		if (shuttingDown) {
+			return;
+		}
+	}
+}
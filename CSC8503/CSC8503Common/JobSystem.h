@@ -0,0 +1,115 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+namespace NCL {
+	namespace CSC8503 {
+		class JobCounter;
+
+		typedef std::function<void()> JobFunc;
+
+		struct Job {
+			JobFunc		func;
+			JobCounter* counter;
+		};
+
+		/*
+		Counts how many jobs that were started with it haven't finished yet. Jobs
+		can also be told to wait on a counter, and they'll only be started once
+		it's reached zero, which is how one set of jobs can depend on another.
+		A counter must outlive every job using it - waiting on it makes sure of that.
+		*/
+		class JobCounter	{
+		public:
+			JobCounter() {
+				count = 0;
+			}
+
+			bool IsDone() const {
+				return count == 0;
+			}
+
+		protected:
+			friend class JobSystem;
+
+			std::atomic<int>	count;
+			std::mutex			mutex;
+			std::vector<Job>	dependents;	//Jobs that can't start until this counter is done
+		};
+
+		/*
+		A pool of worker threads, each with its own queue of jobs. A worker takes
+		the newest job from its own queue, which is likely to still be in cache,
+		and once that's empty, steals the oldest job from another worker's queue,
+		which is likely to be the biggest chunk of work left. Threads that aren't
+		workers (like the main thread) put their jobs in a shared queue, and help
+		out with any jobs they can find while they wait for their own to finish.
+		*/
+		class JobSystem	{
+		public:
+			//threadCount includes the thread that waits on the jobs, so 1 runs everything on the caller
+			JobSystem(int threadCount = (int)std::thread::hardware_concurrency());
+			~JobSystem();
+
+			//The job system shared by the whole engine
+			static JobSystem& Instance();
+
+			void Run(JobFunc func, JobCounter& counter);
+			void RunAfter(JobCounter& dependency, JobFunc func, JobCounter& counter);
+
+			//Runs other jobs while waiting, so waiting from inside a job is fine
+			void Wait(JobCounter& counter);
+
+			/*
+			Splits [first, last) into chunks of grainSize, calling func(chunkFirst, chunkLast)
+			for each one across the workers, and only returns once they're all done.
+			Ranges no bigger than one chunk are just run straight away on the caller.
+			*/
+			template<class F>
+			void ParallelFor(int first, int last, int grainSize, F func) {
+				grainSize = grainSize > 1 ? grainSize : 1;
+				if (last - first <= grainSize || queues.size() == 1) {
+					if (last > first) {
+						func(first, last);
+					}
+					return;
+				}
+				JobCounter counter;
+				for (int start = first; start < last; start += grainSize) {
+					int end = last - start > grainSize ? start + grainSize : last;
+					Run([&func, start, end]() { func(start, end); }, counter);
+				}
+				Wait(counter);
+			}
+
+			int GetThreadCount() const {
+				return (int)threads.size() + 1;
+			}
+
+		protected:
+			struct JobQueue {
+				std::deque<Job> jobs;
+				std::mutex		mutex;
+			};
+
+			void Push(Job job);
+			bool PopJob(Job& job);
+			void Execute(Job& job);
+			void WorkerLoop(int index);
+
+			std::vector<std::unique_ptr<JobQueue>>	queues;	//One per worker, then the shared one
+			std::vector<std::thread>				threads;
+
+			std::atomic<int>		queuedJobs;
+			std::atomic<bool>		shuttingDown;
+			std::mutex				sleepMutex;
+			std::condition_variable	jobAdded;
+		};
+	}
+}
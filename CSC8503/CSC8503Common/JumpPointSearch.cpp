@@ -0,0 +1,287 @@
+#include "JumpPointSearch.h"
+#include <cstdlib>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	//Same order as GridNode::connected - up, down, left, right
+	const int DIR_X[4] = { 0, 0, -1, 1 };
+	const int DIR_Y[4] = { -1, 1, 0, 0 };
+
+	bool IsHorizontal(int direction) {
+		return direction >= 2;
+	}
+
+	int Opposite(int direction) {
+		return direction ^ 1;
+	}
+}
+
+JumpPointSearch::JumpPointSearch(const NavigationGrid& grid, Mode mode) : grid(grid) {
+	this->mode			= mode;
+	gridVersion			= grid.GetVersion() + 1;	//So the first Refresh always copies the grid
+	width				= 0;
+	height				= 0;
+	nodeSize			= 0;
+	jumpDistancesBuilt	= false;
+	searchCount			= 0;
+	expandedCount		= 0;
+	Refresh();
+}
+
+void JumpPointSearch::Refresh() {
+	if (gridVersion == grid.GetVersion()) {
+		return;
+	}
+	gridVersion = grid.GetVersion();
+	width		= grid.GetWidth();
+	height		= grid.GetHeight();
+	nodeSize	= grid.GetNodeSize();
+
+	walkable.resize(width * height);
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			walkable[(y * width) + x] = grid.IsWalkable(x, y) ? 1 : 0;
+		}
+	}
+	JumpNode empty;
+	empty.f			= 0;
+	empty.g			= 0;
+	empty.heapIndex = -1;
+	empty.parent	= -1;
+	empty.searchID	= 0;
+	empty.closed	= false;
+	empty.direction = -1;
+	nodes.assign(width * height, empty);
+	searchCount = 0;
+
+	jumpDistancesBuilt = false;
+	jumpDistances.clear();
+	if (mode == Mode::JumpPlus) {
+		BuildJumpDistances();
+	}
+}
+
+/*
+Each direction is swept from the far side of the grid, so every node's distance
+comes straight from the one it would step on to next. Sideways first, as whether
+an up or down jump stops at a node depends on whether it can jump sideways.
+*/
+void JumpPointSearch::BuildJumpDistances() {
+	jumpDistances.assign(width * height * 4, 0);
+
+	auto sweep = [&](int x, int y, int direction, bool isJumpPoint) {
+		int next = ((y + DIR_Y[direction]) * width) + x + DIR_X[direction];
+		int& distance = jumpDistances[((y * width) + x) * 4 + direction];
+		if (!Walkable(x + DIR_X[direction], y + DIR_Y[direction])) {
+			distance = 0;
+		}
+		else if (isJumpPoint) {
+			distance = 1;
+		}
+		else {
+			int further = jumpDistances[next * 4 + direction];
+			distance = further > 0 ? further + 1 : further - 1;
+		}
+	};
+	for (int y = 0; y < height; ++y) {
+		for (int x = 0; x < width; ++x) {
+			sweep(x, y, 2, IsForced(x - 1, y, 2));
+		}
+		for (int x = width - 1; x >= 0; --x) {
+			sweep(x, y, 3, IsForced(x + 1, y, 3));
+		}
+	}
+	auto hasSidewaysJump = [&](int x, int y) {
+		int index = ((y * width) + x) * 4;
+		return Walkable(x, y) && (jumpDistances[index + 2] > 0 || jumpDistances[index + 3] > 0);
+	};
+	for (int x = 0; x < width; ++x) {
+		for (int y = 0; y < height; ++y) {
+			sweep(x, y, 0, hasSidewaysJump(x, y - 1));
+		}
+		for (int y = height - 1; y >= 0; --y) {
+			sweep(x, y, 1, hasSidewaysJump(x, y + 1));
+		}
+	}
+	jumpDistancesBuilt = true;
+}
+
+//Moving sideways, does the row above or below open up here, having been walled off just behind?
+bool JumpPointSearch::IsForced(int x, int y, int direction) const {
+	int behindX = x - DIR_X[direction];
+	return (Walkable(x, y - 1) && !Walkable(behindX, y - 1)) ||
+		(Walkable(x, y + 1) && !Walkable(behindX, y + 1));
+}
+
+int JumpPointSearch::Jump(int x, int y, int direction, int goalX, int goalY) const {
+	if (mode == Mode::JumpPlus) {
+		return JumpPlus(x, y, direction, goalX, goalY);
+	}
+	return IsHorizontal(direction) ? JumpHorizontal(x, y, direction, goalX, goalY) : JumpVertical(x, y, direction, goalX, goalY);
+}
+
+int JumpPointSearch::JumpHorizontal(int x, int y, int direction, int goalX, int goalY) const {
+	while (true) {
+		x += DIR_X[direction];
+		if (!Walkable(x, y)) {
+			return -1;
+		}
+		if ((x == goalX && y == goalY) || IsForced(x, y, direction)) {
+			return (y * width) + x;
+		}
+	}
+}
+
+int JumpPointSearch::JumpVertical(int x, int y, int direction, int goalX, int goalY) const {
+	while (true) {
+		y += DIR_Y[direction];
+		if (!Walkable(x, y)) {
+			return -1;
+		}
+		if ((x == goalX && y == goalY) ||
+			JumpHorizontal(x, y, 2, goalX, goalY) >= 0 ||
+			JumpHorizontal(x, y, 3, goalX, goalY) >= 0) {
+			return (y * width) + x;
+		}
+	}
+}
+
+/*
+The stored distances know nothing about the goal, so that's checked for first:
+if it's in reach along this row, go straight there, and if its row is in reach
+going up or down, stop on that row, so the next sideways jump can find it.
+*/
+int JumpPointSearch::JumpPlus(int x, int y, int direction, int goalX, int goalY) const {
+	int distance	= jumpDistances[((y * width) + x) * 4 + direction];
+	int reach		= distance > 0 ? distance : -distance;
+
+	if (IsHorizontal(direction)) {
+		int toGoal = (goalX - x) * DIR_X[direction];
+		if (goalY == y && toGoal > 0 && toGoal <= reach) {
+			return (goalY * width) + goalX;
+		}
+	}
+	else {
+		int toGoal = (goalY - y) * DIR_Y[direction];
+		if (toGoal > 0 && toGoal <= reach) {
+			return (goalY * width) + x;
+		}
+	}
+	if (distance <= 0) {
+		return -1;
+	}
+	return ((y + DIR_Y[direction] * distance) * width) + x + DIR_X[direction] * distance;
+}
+
+bool JumpPointSearch::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
+	Refresh();
+	if (mode == Mode::JumpPlus && !jumpDistancesBuilt) {
+		BuildJumpDistances();
+	}
+	int start	= grid.GetNodeIndex(from);
+	int goal	= grid.GetNodeIndex(to);
+	if (start < 0 || goal < 0 || !walkable[goal]) {
+		return false;
+	}
+	int goalX = goal % width;
+	int goalY = goal / width;
+
+	searchCount++;
+	if (searchCount == 0) {	//Wrapped around, so old stamps could look current again
+		for (JumpNode& n : nodes) {
+			n.searchID = 0;
+		}
+		searchCount = 1;
+	}
+	openHeap.Clear();
+	expandedCount = 0;
+
+	JumpNode& startNode = nodes[start];
+	startNode.searchID	= searchCount;
+	startNode.closed	= false;
+	startNode.g			= 0;
+	startNode.f			= 0;
+	startNode.parent	= -1;
+	startNode.direction = -1;
+	openHeap.Push(&startNode);
+
+	while (!openHeap.Empty()) {
+		JumpNode* current = openHeap.Pop();
+		int index = (int)(current - nodes.data());
+		expandedCount++;
+
+		if (index == goal) {
+			BuildPath(goal, outPath);
+			return true;
+		}
+		current->closed = true;
+
+		int x = index % width;
+		int y = index / width;
+		int arrived = current->direction;
+		for (int d = 0; d < 4; ++d) {
+			if (arrived >= 0 && d == Opposite(arrived)) {
+				continue; //never worth going straight back
+			}
+			if (arrived >= 0 && IsHorizontal(arrived) && !IsHorizontal(d) &&
+				!(Walkable(x, y + DIR_Y[d]) && !Walkable(x - DIR_X[arrived], y + DIR_Y[d]))) {
+				continue; //could have turned this way a node earlier, so that path is someone else's
+			}
+			int next = Jump(x, y, d, goalX, goalY);
+			if (next >= 0) {
+				AddSuccessor(index, next, d, goalX, goalY);
+			}
+		}
+	}
+	return false; //open list emptied out with no path!
+}
+
+void JumpPointSearch::AddSuccessor(int from, int to, int direction, int goalX, int goalY) {
+	JumpNode& n = nodes[to];
+	bool seen = n.searchID == searchCount;
+	if (seen && n.closed) {
+		return;
+	}
+	int toX = to % width;
+	int toY = to / width;
+	int distance = IsHorizontal(direction) ? (to - from) * DIR_X[direction] : (toY - (from / width)) * DIR_Y[direction];
+
+	float g = nodes[from].g + distance;
+	if (seen && g >= n.g) {
+		return;
+	}
+	n.parent	= from;
+	n.direction = direction;
+	n.g			= g;
+	n.f			= g + (float)(abs(goalX - toX) + abs(goalY - toY));	//Manhattan distance never overestimates on a 4 way grid
+
+	if (!seen) {
+		n.searchID	= searchCount;
+		n.closed	= false;
+		openHeap.Push(&n);
+	}
+	else {
+		openHeap.DecreaseKey(&n);
+	}
+}
+
+//Jump points are joined by straight lines, so every node in between is filled back in
+void JumpPointSearch::BuildPath(int goal, NavigationPath& outPath) const {
+	int node = goal;
+	while (nodes[node].parent >= 0) {
+		int parent	= nodes[node].parent;
+		int x		= node % width;
+		int y		= node / width;
+		int stepX	= (parent % width) > x ? 1 : ((parent % width) < x ? -1 : 0);
+		int stepY	= (parent / width) > y ? 1 : ((parent / width) < y ? -1 : 0);
+		while ((y * width) + x != parent) {
+			outPath.PushWaypoint(NodePosition((y * width) + x));
+			x += stepX;
+			y += stepY;
+		}
+		node = parent;
+	}
+	outPath.PushWaypoint(NodePosition(node));
+}
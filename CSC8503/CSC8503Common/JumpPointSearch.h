@@ -0,0 +1,102 @@
+#pragma once
+#include "NavigationGrid.h"
+#include "IndexedHeap.h"
+#include <vector>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Jump Point Search, over the same walls as a NavigationGrid. Every floor
+		node costs the same to cross, so most of the routes A* tries are really
+		the same route with the turns in different places. JPS only ever turns
+		where a wall forces it to, and skips straight along everything else, so
+		it only has to put the odd node on its open list - on open maps it looks
+		at a tiny fraction of the nodes A* does, but finds paths just as short.
+
+		The grid only moves in 4 directions, so paths are kept in one order:
+		go up or down as early as possible. Moving left or right, a node only
+		matters if the row above or below opens up where it was walled off just
+		behind (a 'forced' turn). Moving up or down, a node matters if a sideways
+		jump from it would find one of those.
+
+		In JumpPlus mode, how far each node can jump in each direction is worked
+		out up front (JPS+), so each jump is a single lookup rather than a walk.
+		Either way, the walls are copied out of the grid, and copied again if the
+		grid's version changes.
+
+		Paths come out with every node along them, exactly like NavigationGrid's.
+		*/
+		class JumpPointSearch : public NavigationMap	{
+		public:
+			enum class Mode {
+				Jump,
+				JumpPlus
+			};
+
+			JumpPointSearch(const NavigationGrid& grid, Mode mode = Mode::JumpPlus);
+			~JumpPointSearch() {}
+
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) override;
+
+			void SetMode(Mode m) {
+				mode = m;
+			}
+
+			Mode GetMode() const {
+				return mode;
+			}
+
+			//How many jump points the last FindPath took off its open list
+			int GetExpandedCount() const {
+				return expandedCount;
+			}
+
+		protected:
+			struct JumpNode {
+				float			f;
+				float			g;
+				int				heapIndex;
+				int				parent;
+				unsigned int	searchID;
+				bool			closed;
+				int				direction;	//Which way the search was going when it got here, or -1 for the start
+			};
+
+			void	Refresh();
+			void	BuildJumpDistances();
+
+			bool	Walkable(int x, int y) const {
+				return x >= 0 && x < width && y >= 0 && y < height && walkable[(y * width) + x];
+			}
+			bool	IsForced(int x, int y, int direction) const;
+
+			int		Jump(int x, int y, int direction, int goalX, int goalY) const;
+			int		JumpHorizontal(int x, int y, int direction, int goalX, int goalY) const;
+			int		JumpVertical(int x, int y, int direction, int goalX, int goalY) const;
+			int		JumpPlus(int x, int y, int direction, int goalX, int goalY) const;
+
+			void	AddSuccessor(int from, int to, int direction, int goalX, int goalY);
+			void	BuildPath(int goal, NavigationPath& outPath) const;
+
+			Vector3	NodePosition(int index) const {
+				return Vector3((float)((index % width) * nodeSize), 0, (float)((index / width) * nodeSize));
+			}
+
+			const NavigationGrid&	grid;
+			Mode					mode;
+			unsigned int			gridVersion;
+			int						width;
+			int						height;
+			int						nodeSize;
+
+			std::vector<char>		walkable;
+			std::vector<int>		jumpDistances;	//4 per node. Positive is how far to the next jump point, otherwise minus how far to a wall
+			bool					jumpDistancesBuilt;
+
+			std::vector<JumpNode>	nodes;
+			IndexedHeap<JumpNode>	openHeap;
+			unsigned int			searchCount;
+			int						expandedCount;
+		};
+	}
+}
@@ -0,0 +1,60 @@
+#include "KinematicMover.h"
+#include "StateTransition.h"
+#include "StateMachine.h"
+#include "State.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+KinematicMover::KinematicMover(const Vector3& direction, float acceleration, float counter) {
+	this->direction		= direction;
+	this->acceleration	= acceleration;
+	this->counter		= counter;
+	stateMachine = new StateMachine();
+
+	State* stateA = new State([&](float dt)-> void
+		{
+			this->Accelerate(this->direction * this->acceleration, dt);
+			this->counter += dt;
+		}
+	);
+	State* stateB = new State([&](float dt)-> void
+		{
+			this->Accelerate(-this->direction * this->acceleration, dt);
+			this->counter -= dt;
+		}
+	);
+
+	stateMachine->AddState(stateA);
+	stateMachine->AddState(stateB);
+
+	stateMachine->AddTransition(new StateTransition(stateA, stateB,
+		[&]()-> bool
+		{
+			return this->counter > 3.0f;
+		}
+	));
+
+	stateMachine->AddTransition(new StateTransition(stateB, stateA,
+		[&]()-> bool
+		{
+			return this->counter < 0.0f;
+		}
+	));
+}
+
+KinematicMover::~KinematicMover() {
+	delete stateMachine;
+}
+
+void KinematicMover::Update(float dt) {
+	stateMachine->Update(dt);
+}
+
+//Damped in the same way the physics system damps dynamic objects, so
+//movers follow the same paths they did when they were pushed by forces
+void KinematicMover::Accelerate(const Vector3& accel, float dt) {
+	velocity += accel * dt;
+	velocity = velocity * (1.0f - (0.4f * dt));
+	GetPhysicsObject()->MoveKinematicTo(GetTransform().GetPosition() + velocity * dt, dt);
+}
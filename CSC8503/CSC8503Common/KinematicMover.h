@@ -0,0 +1,31 @@
+#pragma once
+#include "StateGameObject.h"
+namespace NCL {
+	namespace CSC8503 {
+		class StateMachine;
+		/*
+		Something moved by a script rather than by forces, going back and forth
+		along a line. It speeds up one way for a while, then the other, and each
+		update asks the physics system to move it to wherever that takes it, so
+		it pushes dynamic objects out of the way without being pushed back.
+		*/
+		class KinematicMover : public StateGameObject {
+		public:
+			//Starts off heading along direction, with counter partway through its 0 to 3 swing
+			KinematicMover(const Vector3& direction, float acceleration, float counter);
+			virtual ~KinematicMover();
+
+			virtual void Update(float dt) override;
+
+		protected:
+			void Accelerate(const Vector3& accel, float dt);
+
+			StateMachine* stateMachine;
+			float counter;
+
+			Vector3 direction;
+			Vector3 velocity;
+			float	acceleration;
+		};
+	}
+}
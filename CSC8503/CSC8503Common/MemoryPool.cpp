@@ -0,0 +1,202 @@
+#include "MemoryPool.h"
+#include <iostream>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	//Every allocation starts with one of these, keeping anything after it 16 byte aligned
+	struct alignas(16) AllocationHeader {
+		unsigned int source;
+	};
+
+	const unsigned int	SOURCE_HEAP		= 0xFFFFFFFF;
+	const unsigned int	SOURCE_ARENA	= 0xFFFFFFFE;
+	const size_t		HEADER_SIZE		= sizeof(AllocationHeader);
+	const size_t		ALIGNMENT		= 16;
+
+	const size_t		sizeClasses[]	= { 64, 128, 256, 512, 1024 };
+	const unsigned int	sizeClassCount	= sizeof(sizeClasses) / sizeof(sizeClasses[0]);
+
+	std::atomic<size_t> statRequests(0);
+	std::atomic<size_t> statFrees(0);
+	std::atomic<size_t> statHeapCalls(0);
+	std::atomic<size_t> statArenaRequests(0);
+
+	thread_local LevelArena* currentArena = nullptr;
+
+	MemoryPool& GetPool(unsigned int sizeClass) {
+		static MemoryPool pools[] = {
+			{ sizeClasses[0] }, { sizeClasses[1] }, { sizeClasses[2] }, { sizeClasses[3] }, { sizeClasses[4] }
+		};
+		return pools[sizeClass];
+	}
+
+	size_t RoundUp(size_t size) {
+		return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	}
+}
+
+MemoryPool::MemoryPool(size_t blockSize, size_t blocksPerChunk) {
+	this->blockSize			= RoundUp(blockSize > sizeof(FreeBlock) ? blockSize : sizeof(FreeBlock));
+	this->blocksPerChunk	= blocksPerChunk;
+	freeList				= nullptr;
+}
+
+MemoryPool::~MemoryPool() {
+	for (char* c : chunks) {
+		delete[] c;
+	}
+}
+
+void MemoryPool::AddChunk() {
+	char* chunk = new char[blockSize * blocksPerChunk];
+	statHeapCalls++;
+	chunks.emplace_back(chunk);
+	for (size_t i = blocksPerChunk; i > 0; --i) {
+		FreeBlock* b	= (FreeBlock*)(chunk + (i - 1) * blockSize);
+		b->next			= freeList;
+		freeList		= b;
+	}
+}
+
+void* MemoryPool::Allocate() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!freeList) {
+		AddChunk();
+	}
+	FreeBlock* b	= freeList;
+	freeList		= b->next;
+	return b;
+}
+
+void MemoryPool::Free(void* block) {
+	std::lock_guard<std::mutex> lock(mutex);
+	FreeBlock* b	= (FreeBlock*)block;
+	b->next			= freeList;
+	freeList		= b;
+}
+
+LevelArena::LevelArena(size_t blockSize) {
+	this->blockSize = blockSize;
+	currentBlock	= 0;
+	offset			= 0;
+	bytesUsed		= 0;
+}
+
+LevelArena::~LevelArena() {
+	for (Block& b : blocks) {
+		delete[] b.memory;
+	}
+}
+
+void* LevelArena::Allocate(size_t size) {
+	size = RoundUp(size);
+	Reserve(size);
+	void* memory = blocks[currentBlock].memory + offset;
+	offset		+= size;
+	bytesUsed	+= size;
+	return memory;
+}
+
+/*
+Walks along the blocks kept from earlier levels before asking the heap for
+any more. Anything too big for a normal block gets a block of its own.
+*/
+void LevelArena::Reserve(size_t size) {
+	size = RoundUp(size);
+	while (currentBlock < blocks.size() && offset + size > blocks[currentBlock].size) {
+		currentBlock++;
+		offset = 0;
+	}
+	if (currentBlock == blocks.size()) {
+		Block b;
+		b.size		= size > blockSize ? size : blockSize;
+		b.memory	= new char[b.size];
+		statHeapCalls++;
+		blocks.emplace_back(b);
+		offset = 0;
+	}
+}
+
+void LevelArena::Release() {
+	currentBlock	= 0;
+	offset			= 0;
+	bytesUsed		= 0;
+}
+
+ArenaScope::ArenaScope(LevelArena& arena) {
+	previous		= currentArena;
+	currentArena	= &arena;
+}
+
+ArenaScope::~ArenaScope() {
+	currentArena = previous;
+}
+
+LevelArena* ArenaScope::GetCurrentArena() {
+	return currentArena;
+}
+
+void* PoolAllocator::Allocate(size_t size) {
+	statRequests++;
+	size_t total = size + HEADER_SIZE;
+
+	AllocationHeader* header = nullptr;
+	if (currentArena) {
+		header			= (AllocationHeader*)currentArena->Allocate(total);
+		header->source	= SOURCE_ARENA;
+		statArenaRequests++;
+		return header + 1;
+	}
+	for (unsigned int i = 0; i < sizeClassCount; ++i) {
+		if (total <= sizeClasses[i]) {
+			header			= (AllocationHeader*)GetPool(i).Allocate();
+			header->source	= i;
+			return header + 1;
+		}
+	}
+	header			= (AllocationHeader*)new char[total];
+	header->source	= SOURCE_HEAP;
+	statHeapCalls++;
+	return header + 1;
+}
+
+void PoolAllocator::Free(void* memory) {
+	if (!memory) {
+		return;
+	}
+	statFrees++;
+	AllocationHeader* header = (AllocationHeader*)memory - 1;
+	if (header->source == SOURCE_ARENA) {
+		return;	//Given back when the arena is released
+	}
+	if (header->source == SOURCE_HEAP) {
+		delete[] (char*)header;
+		return;
+	}
+	GetPool(header->source).Free(header);
+}
+
+AllocationStats PoolAllocator::GetStats() {
+	AllocationStats s;
+	s.requests		= statRequests;
+	s.frees			= statFrees;
+	s.heapCalls		= statHeapCalls;
+	s.arenaRequests = statArenaRequests;
+	return s;
+}
+
+void PoolAllocator::PrintStats(const std::string& label, const AllocationStats& since) {
+	AllocationStats now = GetStats();
+	size_t requests = now.requests - since.requests;
+	size_t heapCalls = now.heapCalls - since.heapCalls;
+
+	std::cout << label << ": " << requests << " requested (" << (now.arenaRequests - since.arenaRequests)
+		<< " from the level arena), " << (now.frees - since.frees) << " freed, "
+		<< heapCalls << " went to the heap";
+	if (requests > 0) {
+		std::cout << " - " << (int)(100.0f * (1.0f - (float)heapCalls / (float)requests)) << "% fewer than without pooling";
+	}
+	std::cout << std::endl;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Hands out blocks of one fixed size, carved out of larger chunks that are
+		only ever allocated from the heap when every block handed out so far is
+		in use. Freed blocks go on a list, ready to be handed out again.
+		*/
+		class MemoryPool	{
+		public:
+			MemoryPool(size_t blockSize, size_t blocksPerChunk = 64);
+			~MemoryPool();
+
+			void* Allocate();
+			void  Free(void* block);
+
+			size_t GetBlockSize() const {
+				return blockSize;
+			}
+
+			size_t GetChunkCount() const {
+				return chunks.size();
+			}
+
+		protected:
+			void AddChunk();
+
+			struct FreeBlock {
+				FreeBlock* next;
+			};
+
+			std::vector<char*>	chunks;
+			FreeBlock*			freeList;
+			size_t				blockSize;
+			size_t				blocksPerChunk;
+			std::mutex			mutex;
+		};
+
+		/*
+		A simple bump allocator for things that all live for exactly as long as a
+		level does. Allocating just moves a pointer along, and freeing individual
+		allocations does nothing at all - everything is released in one go by
+		Release, once every object using it has been destroyed. The memory blocks
+		themselves are kept around, so reloading a level doesn't go to the heap.
+		An arena is only meant to be used from one thread at a time.
+		*/
+		class LevelArena	{
+		public:
+			LevelArena(size_t blockSize = 64 * 1024);
+			~LevelArena();
+
+			void* Allocate(size_t size);
+			void  Release();
+
+			//Makes sure the next size bytes can be allocated from one block, without going to the heap
+			void  Reserve(size_t size);
+
+			size_t GetBytesUsed() const {
+				return bytesUsed;
+			}
+
+		protected:
+			struct Block {
+				char*	memory;
+				size_t	size;
+			};
+			std::vector<Block>	blocks;
+			size_t				currentBlock;
+			size_t				offset;
+			size_t				blockSize;
+			size_t				bytesUsed;
+		};
+
+		//While one of these exists, pooled allocations made on this thread come from the given arena
+		class ArenaScope	{
+		public:
+			ArenaScope(LevelArena& arena);
+			~ArenaScope();
+
+			static LevelArena* GetCurrentArena();
+
+		protected:
+			LevelArena* previous;
+		};
+
+		struct AllocationStats {
+			size_t requests;		//Allocations asked for
+			size_t frees;
+			size_t heapCalls;		//How many of those actually needed memory from the heap
+			size_t arenaRequests;	//Requests served from a level arena
+		};
+
+		/*
+		Where GameObjects and CollisionVolumes get their memory from. Each request
+		is rounded up to one of a few size classes, each with its own MemoryPool,
+		or served from the current level arena if there is one. Every allocation
+		remembers where it came from, so it can always be freed the right way.
+		*/
+		class PoolAllocator	{
+		public:
+			static void* Allocate(size_t size);
+			static void  Free(void* memory);
+
+			static AllocationStats GetStats();
+			static void PrintStats(const std::string& label, const AllocationStats& since);
+		};
+	}
+}
@@ -19,6 +19,7 @@ NavigationGrid::NavigationGrid()	{
 	gridWidth	= 0;
 	gridHeight	= 0;
 	allNodes	= nullptr;
+	version		= 0;
 }
 
 NavigationGrid::NavigationGrid(const std::string&filename) : NavigationGrid() {
@@ -28,14 +29,28 @@ NavigationGrid::NavigationGrid(const std::string&filename) : NavigationGrid() {
 	infile >> gridWidth;
 	infile >> gridHeight;
 
+	std::string types(gridWidth * gridHeight, WALL_NODE);
+	for (char& type : types) {
+		infile >> type;
+	}
+	BuildNodes(types);
+}
+
+NavigationGrid::NavigationGrid(int width, int height, int nodeSize, const std::string& types) : NavigationGrid() {
+	this->nodeSize	= nodeSize;
+	gridWidth		= width;
+	gridHeight		= height;
+	BuildNodes(types);
+}
+
+void NavigationGrid::BuildNodes(const std::string& types) {
 	allNodes = new GridNode[gridWidth * gridHeight];
 
 	for (int y = 0; y < gridHeight; ++y) {
 		for (int x = 0; x < gridWidth; ++x) {
 			GridNode&n = allNodes[(gridWidth * y) + x];
-			char type = 0;
-			infile >> type;
-			n.type = type;
+			size_t index = (size_t)(gridWidth * y) + x;
+			n.type = index < types.size() ? types[index] : WALL_NODE;
 			n.position = Vector3((float)(x * nodeSize), 0, (float)(y * nodeSize));
 		}
 	}
@@ -43,39 +58,78 @@ NavigationGrid::NavigationGrid(const std::string&filename) : NavigationGrid() {
 	//now to build the connectivity between the nodes
 	for (int y = 0; y < gridHeight; ++y) {
 		for (int x = 0; x < gridWidth; ++x) {
-			GridNode&n = allNodes[(gridWidth * y) + x];		
+			ConnectNode(x, y);
+		}
+	}
+}
 
-			if (y > 0) { //get the above node
-				n.connected[0] = &allNodes[(gridWidth * (y - 1)) + x];
-			}
-			if (y < gridHeight - 1) { //get the below node
-				n.connected[1] = &allNodes[(gridWidth * (y + 1)) + x];
-			}
-			if (x > 0) { //get left node
-				n.connected[2] = &allNodes[(gridWidth * (y)) + (x - 1)];
-			}
-			if (x < gridWidth - 1) { //get right node
-				n.connected[3] = &allNodes[(gridWidth * (y)) + (x + 1)];
+void NavigationGrid::ConnectNode(int x, int y) {
+	GridNode&n = allNodes[(gridWidth * y) + x];
+	for (int i = 0; i < 4; ++i) {
+		n.connected[i]	= nullptr;
+		n.costs[i]		= 0;
+	}
+
+	if (y > 0) { //get the above node
+		n.connected[0] = &allNodes[(gridWidth * (y - 1)) + x];
+	}
+	if (y < gridHeight - 1) { //get the below node
+		n.connected[1] = &allNodes[(gridWidth * (y + 1)) + x];
+	}
+	if (x > 0) { //get left node
+		n.connected[2] = &allNodes[(gridWidth * (y)) + (x - 1)];
+	}
+	if (x < gridWidth - 1) { //get right node
+		n.connected[3] = &allNodes[(gridWidth * (y)) + (x + 1)];
+	}
+	for (int i = 0; i < 4; ++i) {
+		if (n.connected[i]) {
+			if (n.connected[i]->type == '.') {
+				n.costs[i]		= 1;
 			}
-			for (int i = 0; i < 4; ++i) {
-				if (n.connected[i]) {
-					if (n.connected[i]->type == '.') {
-						n.costs[i]		= 1;
-					}
-					if (n.connected[i]->type == 'x') {
-						n.connected[i] = nullptr; //actually a wall, disconnect!
-					}
-				}
+			if (n.connected[i]->type == 'x') {
+				n.connected[i] = nullptr; //actually a wall, disconnect!
 			}
-		}	
+		}
+	}
+}
+
+void NavigationGrid::SetNodeType(int x, int y, char type) {
+	if (x < 0 || x > gridWidth - 1 || y < 0 || y > gridHeight - 1) {
+		return;
+	}
+	allNodes[(gridWidth * y) + x].type = type;
+
+	//Its neighbours' links to it depend on its type, so they need redoing too
+	ConnectNode(x, y);
+	if (y > 0)				{ ConnectNode(x, y - 1); }
+	if (y < gridHeight - 1) { ConnectNode(x, y + 1); }
+	if (x > 0)				{ ConnectNode(x - 1, y); }
+	if (x < gridWidth - 1)	{ ConnectNode(x + 1, y); }
+	version++;
+}
+
+bool NavigationGrid::IsWalkable(int x, int y) const {
+	if (x < 0 || x > gridWidth - 1 || y < 0 || y > gridHeight - 1) {
+		return false;
+	}
+	return allNodes[(gridWidth * y) + x].type != WALL_NODE;
+}
+
+int NavigationGrid::GetNodeIndex(const Vector3& position) const {
+	int x = ((int)position.x / nodeSize);
+	int z = ((int)position.z / nodeSize);
+	if (x < 0 || x > gridWidth - 1 || z < 0 || z > gridHeight - 1) {
+		return -1;
 	}
+	return (z * gridWidth) + x;
 }
 
 NavigationGrid::~NavigationGrid()	{
 	delete[] allNodes;
 }
 
-bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
+bool NavigationGrid::GetEndNodes(const Vector3& from, const Vector3& to, GridNode*& startNode, GridNode*& endNode) const {
 	//need to work out which node 'from' sits in, and 'to' sits in
 	int fromX = ((int)from.x / nodeSize);
 	int fromZ = ((int)from.z / nodeSize);
@@ -93,29 +147,140 @@ bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, Navigation
 		return false; //outside of map region!
 	}
 
-	GridNode* startNode = &allNodes[(fromZ * gridWidth) + fromX];
-	GridNode* endNode	= &allNodes[(toZ * gridWidth) + toX];
+	startNode	= &allNodes[(fromZ * gridWidth) + fromX];
+	endNode		= &allNodes[(toZ * gridWidth) + toX];
+	return true;
+}
+
+void NavigationGrid::BuildPath(int endNode, const GridSearch& search, NavigationPath& outPath) const {
+	int node = endNode;
+	while (node >= 0) {
+		outPath.PushWaypoint(allNodes[node].position);
+		node = search.nodes[node].parent;
+	}
+}
+
+//Gets a search ready to use on this grid, making room for every node the first time it's used here
+void NavigationGrid::StartSearch(GridSearch& search) const {
+	size_t nodeCount = (size_t)gridWidth * gridHeight;
+	search.searchCount++;
+	if (search.nodes.size() != nodeCount || search.searchCount == 0) {	//A different grid, or the stamps wrapped around
+		GridSearch::SearchNode empty;
+		empty.f			= 0;
+		empty.g			= 0;
+		empty.heapIndex = -1;
+		empty.parent	= -1;
+		empty.searchID	= 0;
+		empty.closed	= false;
+		search.nodes.assign(nodeCount, empty);
+		search.searchCount = 1;
+	}
+	search.openHeap.Clear();
+	search.expandedCount = 0;
+}
+
+bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
+	return FindPath(from, to, outPath, defaultSearch);
+}
+
+/*
+Rather than clearing every node before each search, or keeping a closed list
+to search through, each node is stamped with the search that last touched it.
+Any node with an older stamp simply hasn't been seen yet this search, so
+working out whether a node is new, open or closed is just a couple of compares.
+All of that lives in the GridSearch rather than the nodes, so the grid is
+never written to.
+*/
+bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, GridSearch& search) const {
+	GridNode* startNode = nullptr;
+	GridNode* endNode	= nullptr;
+	if (!GetEndNodes(from, to, startNode, endNode)) {
+		return false;
+	}
+	StartSearch(search);
+	unsigned int searchID			= search.searchCount;
+	GridSearch::SearchNode* nodes	= search.nodes.data();
+	int endIndex					= GetIndex(endNode);
+
+	GridSearch::SearchNode& start = nodes[GetIndex(startNode)];
+	start.searchID	= searchID;
+	start.closed	= false;
+	start.g			= 0;
+	start.f			= 0;
+	start.parent	= -1;
+	search.openHeap.Push(&start);
+
+	while (!search.openHeap.Empty()) {
+		GridSearch::SearchNode* best = search.openHeap.Pop();
+		int bestIndex = (int)(best - nodes);
+		search.expandedCount++;
+
+		if (bestIndex == endIndex) {			//we've found the path!
+			BuildPath(endIndex, search, outPath);
+			return true;
+		}
+		best->closed = true;
+
+		const GridNode& currentBestNode = allNodes[bestIndex];
+		for (int i = 0; i < 4; ++i) {
+			const GridNode* neighbourNode = currentBestNode.connected[i];
+			if (!neighbourNode) { //might not be connected...
+				continue;
+			}
+			GridSearch::SearchNode& neighbour = nodes[GetIndex(neighbourNode)];
+			bool seen = neighbour.searchID == searchID;
+			if (seen && neighbour.closed) {
+				continue; //already discarded this neighbour...
+			}
+			float g = best->g + currentBestNode.costs[i];
+			if (seen && g >= neighbour.g) {
+				continue; //already have a route here that's at least as good
+			}
+			neighbour.parent	= bestIndex;
+			neighbour.g			= g;
+			neighbour.f			= g + Heuristic(neighbourNode, endNode);
+
+			if (!seen) { //first time we've seen this neighbour
+				neighbour.searchID	= searchID;
+				neighbour.closed	= false;
+				search.openHeap.Push(&neighbour);
+			}
+			else {
+				search.openHeap.DecreaseKey(&neighbour);
+			}
+		}
+	}
+	return false; //open list emptied out with no path!
+}
+
+bool NavigationGrid::FindPathSimple(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
+	GridNode* startNode = nullptr;
+	GridNode* endNode	= nullptr;
+	if (!GetEndNodes(from, to, startNode, endNode)) {
+		return false;
+	}
+
+	StartSearch(defaultSearch);
+	std::vector<GridSearch::SearchNode>& nodes = defaultSearch.nodes;
 
 	std::vector<GridNode*>  openList;
 	std::vector<GridNode*>  closedList;
 
 	openList.emplace_back(startNode);
 
-	startNode->f = 0;
-	startNode->g = 0;
-	startNode->parent = nullptr;
+	GridSearch::SearchNode& start = nodes[GetIndex(startNode)];
+	start.f = 0;
+	start.g = 0;
+	start.parent = -1;
 
 	GridNode* currentBestNode = nullptr;
 
 	while (!openList.empty()) {
-		currentBestNode = RemoveBestNode(openList);
+		currentBestNode = RemoveBestNode(openList, defaultSearch);
+		GridSearch::SearchNode& best = nodes[GetIndex(currentBestNode)];
 
 		if (currentBestNode == endNode) {			//we've found the path!
-			GridNode* node = endNode;
-			while (node != nullptr) {
-				outPath.PushWaypoint(node->position);
-				node = node->parent;
-			}
+			BuildPath(GetIndex(endNode), defaultSearch, outPath);
 			return true;
 		}
 		else {
@@ -130,18 +295,19 @@ bool NavigationGrid::FindPath(const Vector3& from, const Vector3& to, Navigation
 				}
 
 				float h = Heuristic(neighbour, endNode);				
-				float g = currentBestNode->g + currentBestNode->costs[i];
+				float g = best.g + currentBestNode->costs[i];
 				float f = h + g;
 
 				bool inOpen		= NodeInList(neighbour, openList);
 
+				GridSearch::SearchNode& n = nodes[GetIndex(neighbour)];
 				if (!inOpen) { //first time we've seen this neighbour
 					openList.emplace_back(neighbour);
 				}
-				if (!inOpen || f < neighbour->f) {//might be a better route to this neighbour
-					neighbour->parent = currentBestNode;
-					neighbour->f = f;
-					neighbour->g = g;
+				if (!inOpen || f < n.f) {//might be a better route to this neighbour
+					n.parent = GetIndex(currentBestNode);
+					n.f = f;
+					n.g = g;
 				}
 			}
 			closedList.emplace_back(currentBestNode);
@@ -155,13 +321,13 @@ bool NavigationGrid::NodeInList(GridNode* n, std::vector<GridNode*>& list) const
 	return i == list.end() ? false : true;
 }
 
-GridNode*  NavigationGrid::RemoveBestNode(std::vector<GridNode*>& list) const {
+GridNode*  NavigationGrid::RemoveBestNode(std::vector<GridNode*>& list, const GridSearch& search) const {
 	std::vector<GridNode*>::iterator bestI = list.begin();
 
 	GridNode* bestNode = *list.begin();
 
 	for (auto i = list.begin(); i != list.end(); ++i) {
-		if ((*i)->f < bestNode->f) {
+		if (search.nodes[GetIndex(*i)].f < search.nodes[GetIndex(bestNode)].f) {
 			bestNode	= (*i);
 			bestI		= i;
 		}
@@ -171,6 +337,7 @@ GridNode*  NavigationGrid::RemoveBestNode(std::vector<GridNode*>& list) const {
 	return bestNode;
 }
 
-float NavigationGrid::Heuristic(GridNode* hNode, GridNode* endNode) const {
-	return (hNode->position - endNode->position).Length();
+//Measured in nodes, the same as the costs, so it never overestimates and every path found is a shortest one
+float NavigationGrid::Heuristic(const GridNode* hNode, const GridNode* endNode) const {
+	return (hNode->position - endNode->position).Length() / nodeSize;
 }
\ No newline at end of file
@@ -1,19 +1,16 @@
 #pragma once
 #include "NavigationMap.h"
+#include "IndexedHeap.h"
 #include <string>
+#include <vector>
 namespace NCL {
 	namespace CSC8503 {
 		struct GridNode {
-			GridNode* parent;
-
 			GridNode* connected[4];
 			int		  costs[4];
 
 			Vector3		position;
 
-			float f;
-			float g;
-
 			int type;
 
 			GridNode() {
@@ -21,31 +18,120 @@ namespace NCL {
 					connected[i] = nullptr;
 					costs[i] = 0;
 				}
-				f = 0;
-				g = 0;
 				type = 0;
-				parent = nullptr;
 			}
 			~GridNode() {	}
 		};
 
+		/*
+		Everything A* has to remember about each node while it searches a
+		NavigationGrid. Searches only ever read the grid itself, so any number of
+		agents (or threads) can search the same grid at once, as long as each one
+		has its own GridSearch to work in.
+		*/
+		class GridSearch	{
+		public:
+			GridSearch() {
+				searchCount		= 0;
+				expandedCount	= 0;
+			}
+
+			//How many nodes the last search took off its open list
+			int GetExpandedCount() const {
+				return expandedCount;
+			}
+
+		protected:
+			friend class NavigationGrid;
+
+			//Only meaningful while searchID matches the current search
+			struct SearchNode {
+				float			f;
+				float			g;
+				int				heapIndex;
+				int				parent;		//Index of the node we got here from, or -1 for the start
+				unsigned int	searchID;
+				bool			closed;
+			};
+
+			std::vector<SearchNode>	nodes;		//One per grid node
+			IndexedHeap<SearchNode>	openHeap;
+			unsigned int			searchCount;	//Nodes stamped with an older search count haven't been seen yet
+			int						expandedCount;
+		};
+
 		class NavigationGrid : public NavigationMap	{
 		public:
 			NavigationGrid();
 			NavigationGrid(const std::string&filename);
+			//types holds one character per node, row by row, in the same format as the files
+			NavigationGrid(int width, int height, int nodeSize, const std::string& types);
 			~NavigationGrid();
 
+			//Searches using the grid's own GridSearch, so only one of these can run at a time
 			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) override;
+
+			//Leaves the grid untouched, so can run alongside any other search with its own GridSearch
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath, GridSearch& search) const;
+
+			//The original search, using plain lists for the open and closed sets. Much slower
+			//on anything but tiny grids, and only kept around to benchmark against
+			bool FindPathSimple(const Vector3& from, const Vector3& to, NavigationPath& outPath);
+
+			int GetWidth() const {
+				return gridWidth;
+			}
+
+			int GetHeight() const {
+				return gridHeight;
+			}
+
+			int GetNodeSize() const {
+				return nodeSize;
+			}
+
+			//Which node a position is in, or -1 if it's outside the grid
+			int GetNodeIndex(const Vector3& position) const;
+
+			//Anything off the edge of the grid counts as a wall
+			bool IsWalkable(int x, int y) const;
+
+			//How many nodes the last FindPath using the grid's own GridSearch took off its open list
+			int GetExpandedCount() const {
+				return defaultSearch.GetExpandedCount();
+			}
+
+			//Changes one node (say, to open or close a door), and reconnects it to its neighbours
+			void SetNodeType(int x, int y, char type);
+
+			//Goes up every time the grid changes, so anything remembering paths knows to forget them
+			unsigned int GetVersion() const {
+				return version;
+			}
 				
 		protected:
+			void		BuildNodes(const std::string& types);
+			void		ConnectNode(int x, int y);
+			bool		GetEndNodes(const Vector3& from, const Vector3& to, GridNode*& startNode, GridNode*& endNode) const;
+			void		StartSearch(GridSearch& search) const;
+			void		BuildPath(int endNode, const GridSearch& search, NavigationPath& outPath) const;
+
 			bool		NodeInList(GridNode* n, std::vector<GridNode*>& list) const;
-			GridNode*	RemoveBestNode(std::vector<GridNode*>& list) const;
-			float		Heuristic(GridNode* hNode, GridNode* endNode) const;
+			GridNode*	RemoveBestNode(std::vector<GridNode*>& list, const GridSearch& search) const;
+			float		Heuristic(const GridNode* hNode, const GridNode* endNode) const;
+
+			int			GetIndex(const GridNode* n) const {
+				return (int)(n - allNodes);
+			}
+
 			int nodeSize;
 			int gridWidth;
 			int gridHeight;
 
 			GridNode* allNodes;
+
+			GridSearch		defaultSearch;
+			unsigned int	version;
 		};
 	}
 }
@@ -1,15 +1,42 @@
 #include "NavigationMesh.h"
 #include "../../Common/Assets.h"
 #include <fstream>
+#include <map>
+#include <tuple>
+#include <cmath>
+#include <algorithm>
 using namespace NCL;
 using namespace CSC8503;
 using namespace std;
 
+namespace {
+	//Twice the signed area of abc on the XZ plane, its sign saying which side of a->b c is on
+	float TriArea2(const Vector3& a, const Vector3& b, const Vector3& c) {
+		float ax = b.x - a.x;
+		float az = b.z - a.z;
+		float bx = c.x - a.x;
+		float bz = c.z - a.z;
+		return bx * az - ax * bz;
+	}
+
+	bool SamePoint(const Vector3& a, const Vector3& b) {
+		return (a - b).LengthSquared() < 0.0001f * 0.0001f;
+	}
+}
+
 NavigationMesh::NavigationMesh()
 {
+	triGridMinX		= 0;
+	triGridMinZ		= 0;
+	triGridCellSize = 1;
+	triGridWidth	= 0;
+	triGridHeight	= 0;
+	searchCount		= 0;
+	expandedCount	= 0;
+	corridorLength	= 0;
 }
 
-NavigationMesh::NavigationMesh(const std::string&filename)
+NavigationMesh::NavigationMesh(const std::string&filename) : NavigationMesh()
 {
 	ifstream file(Assets::DATADIR + filename);
 
@@ -33,12 +60,322 @@ NavigationMesh::NavigationMesh(const std::string&filename)
 		file >> x;
 		allIndices.emplace_back(x);
 	}
+
+	WeldVertices();
+	BuildTris();
+	BuildTriGrid();
 }
 
 NavigationMesh::~NavigationMesh()
 {
 }
 
+/*
+Each triangle in the file has its own copies of its vertices, so before any
+edges can be matched up, vertices in the same place are merged into one.
+*/
+void NavigationMesh::WeldVertices() {
+	std::map<std::tuple<int, int, int>, int> welded;
+	std::vector<Vector3>	verts;
+	std::vector<int>		remap(allVerts.size());
+
+	for (size_t i = 0; i < allVerts.size(); ++i) {
+		const Vector3& v = allVerts[i];
+		auto key = std::make_tuple((int)std::floor(v.x * 1000.0f + 0.5f), (int)std::floor(v.y * 1000.0f + 0.5f), (int)std::floor(v.z * 1000.0f + 0.5f));
+		auto w = welded.find(key);
+		if (w == welded.end()) {
+			w = welded.emplace(key, (int)verts.size()).first;
+			verts.emplace_back(v);
+		}
+		remap[i] = w->second;
+	}
+	for (int& i : allIndices) {
+		i = (i >= 0 && i < (int)remap.size()) ? remap[i] : 0;
+	}
+	allVerts.swap(verts);
+}
+
+//Any edge used by two triangles is the way from one to the other
+void NavigationMesh::BuildTris() {
+	allTris.resize(allIndices.size() / 3);
+
+	std::map<std::pair<int, int>, std::pair<int, int>> openEdges; //Which triangle and edge first used each pair of vertices
+	for (size_t t = 0; t < allTris.size(); ++t) {
+		NavTri& tri = allTris[t];
+		for (int i = 0; i < 3; ++i) {
+			tri.indices[i] = allIndices[(t * 3) + i];
+		}
+		tri.centroid = (allVerts[tri.indices[0]] + allVerts[tri.indices[1]] + allVerts[tri.indices[2]]) / 3.0f;
+
+		for (int i = 0; i < 3; ++i) {
+			int a = tri.indices[i];
+			int b = tri.indices[(i + 1) % 3];
+			if (a == b) {
+				continue; //squashed flat, so not really an edge
+			}
+			auto key = std::make_pair(std::min(a, b), std::max(a, b));
+			auto e = openEdges.find(key);
+			if (e == openEdges.end()) {
+				openEdges.emplace(key, std::make_pair((int)t, i));
+				continue;
+			}
+			NavTri& other = allTris[e->second.first];
+			if (other.neighbours[e->second.second] == nullptr) {
+				other.neighbours[e->second.second]	= &tri;
+				tri.neighbours[i]					= &other;
+			}
+		}
+	}
+}
+
+//The cells are sized so there's around one triangle to each
+void NavigationMesh::BuildTriGrid() {
+	triGrid.clear();
+	if (allTris.empty()) {
+		return;
+	}
+	float minX = allVerts[0].x;
+	float maxX = allVerts[0].x;
+	float minZ = allVerts[0].z;
+	float maxZ = allVerts[0].z;
+	for (const Vector3& v : allVerts) {
+		minX = std::min(minX, v.x);
+		maxX = std::max(maxX, v.x);
+		minZ = std::min(minZ, v.z);
+		maxZ = std::max(maxZ, v.z);
+	}
+	float area		= (maxX - minX) * (maxZ - minZ);
+	triGridCellSize = area > 0.0f ? std::sqrt(area / allTris.size()) : 1.0f;
+	triGridMinX		= minX;
+	triGridMinZ		= minZ;
+	triGridWidth	= (int)((maxX - minX) / triGridCellSize) + 1;
+	triGridHeight	= (int)((maxZ - minZ) / triGridCellSize) + 1;
+	triGrid.resize(triGridWidth * triGridHeight);
+
+	for (size_t t = 0; t < allTris.size(); ++t) {
+		const Vector3& a = allVerts[allTris[t].indices[0]];
+		const Vector3& b = allVerts[allTris[t].indices[1]];
+		const Vector3& c = allVerts[allTris[t].indices[2]];
+		int startX	= (int)((std::min(a.x, std::min(b.x, c.x)) - minX) / triGridCellSize);
+		int endX	= (int)((std::max(a.x, std::max(b.x, c.x)) - minX) / triGridCellSize);
+		int startZ	= (int)((std::min(a.z, std::min(b.z, c.z)) - minZ) / triGridCellSize);
+		int endZ	= (int)((std::max(a.z, std::max(b.z, c.z)) - minZ) / triGridCellSize);
+		for (int z = startZ; z <= endZ; ++z) {
+			for (int x = startX; x <= endX; ++x) {
+				triGrid[(z * triGridWidth) + x].emplace_back((int)t);
+			}
+		}
+	}
+}
+
+bool NavigationMesh::GetHeightInTri(const NavTri& t, const Vector3& pos, float& height) const {
+	const Vector3& a = allVerts[t.indices[0]];
+	const Vector3& b = allVerts[t.indices[1]];
+	const Vector3& c = allVerts[t.indices[2]];
+
+	float abX = b.x - a.x;
+	float abZ = b.z - a.z;
+	float acX = c.x - a.x;
+	float acZ = c.z - a.z;
+	float apX = pos.x - a.x;
+	float apZ = pos.z - a.z;
+
+	float det = abX * acZ - acX * abZ;
+	if (std::abs(det) < 0.000001f) {
+		return false;
+	}
+	float u = (apX * acZ - acX * apZ) / det;
+	float v = (abX * apZ - apX * abZ) / det;
+
+	const float tolerance = 0.0001f; //so points right on an edge still count
+	if (u < -tolerance || v < -tolerance || u + v > 1.0f + tolerance) {
+		return false;
+	}
+	height = a.y + u * (b.y - a.y) + v * (c.y - a.y);
+	return true;
+}
+
+//Where floors overlap, the one closest in height to the position wins
+int NavigationMesh::GetTriForPosition(const Vector3& pos) const {
+	if (triGrid.empty()) {
+		return -1;
+	}
+	int x = (int)std::floor((pos.x - triGridMinX) / triGridCellSize);
+	int z = (int)std::floor((pos.z - triGridMinZ) / triGridCellSize);
+	if (x < 0 || x > triGridWidth - 1 || z < 0 || z > triGridHeight - 1) {
+		return -1;
+	}
+	int		best		= -1;
+	float	bestHeight	= 0.0f;
+	for (int t : triGrid[(z * triGridWidth) + x]) {
+		float height = 0.0f;
+		if (GetHeightInTri(allTris[t], pos, height) && (best < 0 || std::abs(height - pos.y) < std::abs(bestHeight - pos.y))) {
+			best		= t;
+			bestHeight	= height;
+		}
+	}
+	return best;
+}
+
 bool NavigationMesh::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
-	return false;
+	int startIndex	= GetTriForPosition(from);
+	int endIndex	= GetTriForPosition(to);
+	if (startIndex < 0 || endIndex < 0) {
+		return false; //not on the mesh!
+	}
+	NavTri* startTri	= &allTris[startIndex];
+	NavTri* endTri		= &allTris[endIndex];
+
+	searchCount++;
+	if (searchCount == 0) {	//Wrapped around, so old stamps could look current again
+		for (NavTri& t : allTris) {
+			t.searchID = 0;
+		}
+		searchCount = 1;
+	}
+	openHeap.Clear();
+	expandedCount	= 0;
+	corridorLength	= 0;
+
+	startTri->searchID	= searchCount;
+	startTri->closed	= false;
+	startTri->g			= 0;
+	startTri->f			= (to - from).Length();
+	startTri->parent	= nullptr;
+	openHeap.Push(startTri);
+
+	while (!openHeap.Empty()) {
+		NavTri* current = openHeap.Pop();
+		expandedCount++;
+
+		if (current == endTri) {
+			std::vector<const NavTri*> corridor;
+			for (const NavTri* t = endTri; t != nullptr; t = t->parent) {
+				corridor.emplace_back(t);
+			}
+			std::reverse(corridor.begin(), corridor.end());
+			corridorLength = (int)corridor.size();
+
+			StringPull(from, to, corridor, outPath);
+			return true;
+		}
+		current->closed = true;
+
+		//Costs go between triangle centres, except from the start, which could be anywhere in its triangle
+		Vector3 currentPos = current == startTri ? from : current->centroid;
+		for (int i = 0; i < 3; ++i) {
+			NavTri* neighbour = current->neighbours[i];
+			if (!neighbour) {
+				continue;
+			}
+			bool seen = neighbour->searchID == searchCount;
+			if (seen && neighbour->closed) {
+				continue;
+			}
+			float g = current->g + (neighbour->centroid - currentPos).Length();
+			if (seen && g >= neighbour->g) {
+				continue;
+			}
+			neighbour->parent	= current;
+			neighbour->g		= g;
+			neighbour->f		= g + (to - neighbour->centroid).Length();
+
+			if (!seen) {
+				neighbour->searchID = searchCount;
+				neighbour->closed	= false;
+				openHeap.Push(neighbour);
+			}
+			else {
+				openHeap.DecreaseKey(neighbour);
+			}
+		}
+	}
+	return false; //open list emptied out with no path!
+}
+
+/*
+The 'simple stupid funnel algorithm'. Every edge crossed on the way is a portal
+with a left and a right end. Working forwards from the current corner (the
+apex), the funnel's two sides are narrowed down to each portal in turn, for as
+long as they don't cross over. Once a side would have to cross the other, the
+other side's end is a corner the path must turn, so it becomes the new apex,
+and the funnel starts again from there.
+*/
+void NavigationMesh::StringPull(const Vector3& from, const Vector3& to, const std::vector<const NavTri*>& corridor, NavigationPath& outPath) const {
+	std::vector<Vector3> lefts(1, from);
+	std::vector<Vector3> rights(1, from);
+	for (size_t i = 0; i + 1 < corridor.size(); ++i) {
+		const NavTri* t = corridor[i];
+		for (int e = 0; e < 3; ++e) {
+			if (t->neighbours[e] != corridor[i + 1]) {
+				continue;
+			}
+			const Vector3& a = allVerts[t->indices[e]];
+			const Vector3& b = allVerts[t->indices[(e + 1) % 3]];
+			bool aIsLeft = TriArea2(t->centroid, a, b) > 0.0f;
+			lefts.emplace_back(aIsLeft ? a : b);
+			rights.emplace_back(aIsLeft ? b : a);
+			break;
+		}
+	}
+	lefts.emplace_back(to);
+	rights.emplace_back(to);
+
+	std::vector<Vector3> points(1, from);
+	Vector3 apex		= from;
+	Vector3 funnelLeft	= from;
+	Vector3 funnelRight = from;
+	size_t	apexIndex	= 0;
+	size_t	leftIndex	= 0;
+	size_t	rightIndex	= 0;
+
+	for (size_t i = 1; i < lefts.size(); ++i) {
+		const Vector3& left		= lefts[i];
+		const Vector3& right	= rights[i];
+
+		if (TriArea2(apex, funnelRight, right) <= 0.0f) {
+			if (SamePoint(apex, funnelRight) || TriArea2(apex, funnelLeft, right) > 0.0f) {
+				funnelRight = right; //narrows the funnel
+				rightIndex	= i;
+			}
+			else { //crosses the left side, so that's a corner
+				apex = funnelLeft;
+				apexIndex = leftIndex;
+				if (!SamePoint(points.back(), apex)) { //portals sharing a vertex would turn the same corner again
+					points.emplace_back(apex);
+				}
+				funnelLeft	= apex;
+				funnelRight = apex;
+				leftIndex	= apexIndex;
+				rightIndex	= apexIndex;
+				i = apexIndex;
+				continue;
+			}
+		}
+		if (TriArea2(apex, funnelLeft, left) >= 0.0f) {
+			if (SamePoint(apex, funnelLeft) || TriArea2(apex, funnelRight, left) < 0.0f) {
+				funnelLeft	= left;
+				leftIndex	= i;
+			}
+			else {
+				apex = funnelRight;
+				apexIndex = rightIndex;
+				if (!SamePoint(points.back(), apex)) { //portals sharing a vertex would turn the same corner again
+					points.emplace_back(apex);
+				}
+				funnelLeft	= apex;
+				funnelRight = apex;
+				leftIndex	= apexIndex;
+				rightIndex	= apexIndex;
+				i = apexIndex;
+				continue;
+			}
+		}
+	}
+	if (!SamePoint(points.back(), to)) {
+		points.emplace_back(to);
+	}
+	for (auto i = points.rbegin(); i != points.rend(); ++i) {
+		outPath.PushWaypoint(*i);
+	}
 }
@@ -1,9 +1,19 @@
 #pragma once
 #include "NavigationMap.h"
+#include "IndexedHeap.h"
 #include <string>
 #include <vector>
 namespace NCL {
 	namespace CSC8503 {
+		/*
+		Pathfinding over a mesh of walkable triangles. A* finds which triangles
+		to pass through, then the funnel algorithm pulls that corridor tight, so
+		the path only has a waypoint where it has to turn a corner - crossing a
+		big open room takes one straight line rather than a node per tile.
+
+		Triangles are found from positions with a grid over the XZ plane, each
+		cell of which lists the triangles overlapping it.
+		*/
 		class NavigationMesh : public NavigationMap	{
 		public:
 			NavigationMesh();
@@ -11,22 +21,78 @@ namespace NCL {
 			~NavigationMesh();
 
 			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) override;
-		
+
+			int GetTriCount() const {
+				return (int)allTris.size();
+			}
+
+			//Somewhere in the middle of a triangle, for picking test positions
+			Vector3 GetTriCentre(int i) const {
+				return allTris[i].centroid;
+			}
+
+			//How many triangles the last FindPath took off its open list, and how many the path went through
+			int GetExpandedCount() const {
+				return expandedCount;
+			}
+
+			int GetCorridorLength() const {
+				return corridorLength;
+			}
+
 		protected:
 
 			struct NavTri {
-				NavTri* neighbours[3];
+				NavTri* neighbours[3];	//neighbours[i] shares the edge from indices[i] to indices[i + 1]
+				int		indices[3];
+				Vector3 centroid;
+
+				//Search state, only meaningful while searchID matches the mesh's current search
+				NavTri*			parent;
+				float			f;
+				float			g;
+				int				heapIndex;
+				unsigned int	searchID;
+				bool			closed;
 
 				NavTri() {
 					neighbours[0] = nullptr;
 					neighbours[1] = nullptr;
 					neighbours[2] = nullptr;
+					parent		= nullptr;
+					f			= 0;
+					g			= 0;
+					heapIndex	= -1;
+					searchID	= 0;
+					closed		= false;
 				}
 			};
 
+			void	WeldVertices();
+			void	BuildTris();
+			void	BuildTriGrid();
+
+			int		GetTriForPosition(const Vector3& pos) const;	//Index into allTris, or -1 if off the mesh
+			bool	GetHeightInTri(const NavTri& t, const Vector3& pos, float& height) const;
+
+			void	StringPull(const Vector3& from, const Vector3& to, const std::vector<const NavTri*>& corridor, NavigationPath& outPath) const;
+
 			std::vector<NavTri>		allTris;
 			std::vector<Vector3>	allVerts;
 			std::vector<int>		allIndices;
+
+			//Which triangles overlap each cell of a grid over the mesh
+			std::vector<std::vector<int>>	triGrid;
+			float							triGridMinX;
+			float							triGridMinZ;
+			float							triGridCellSize;
+			int								triGridWidth;
+			int								triGridHeight;
+
+			IndexedHeap<NavTri>	openHeap;
+			unsigned int		searchCount;
+			int					expandedCount;
+			int					corridorLength;
 		};
 	}
-}
\ No newline at end of file
+}
@@ -25,6 +25,15 @@ namespace NCL {
 				return true;
 			}
 
+			//Stored goal first, so the next waypoint to pop is at the back
+			const std::vector<Vector3>& GetWaypoints() const {
+				return waypoints;
+			}
+
+			void SetWaypoints(const std::vector<Vector3>& newWaypoints) {
+				waypoints = newWaypoints;
+			}
+
 		protected:
 
 			std::vector <Vector3> waypoints;
@@ -0,0 +1,110 @@
+#include "NavigationPathCache.h"
+#include <cstdlib>
+
+using namespace NCL;
+using namespace CSC8503;
+
+NavigationPathCache::NavigationPathCache(const NavigationGrid& grid, size_t maxPaths, int repairRadius) : grid(grid) {
+	this->maxPaths		= maxPaths > 0 ? maxPaths : 1;
+	this->repairRadius	= repairRadius;
+	gridVersion			= grid.GetVersion();
+	lastEndNode			= -1;
+	ResetStats();
+}
+
+void NavigationPathCache::Clear() {
+	paths.clear();
+	storeOrder.clear();
+	lastPath.clear();
+	lastEndNode = -1;
+}
+
+bool NavigationPathCache::FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath) {
+	if (grid.GetVersion() != gridVersion) {
+		Clear();
+		gridVersion = grid.GetVersion();
+	}
+	int startNode	= grid.GetNodeIndex(from);
+	int endNode		= grid.GetNodeIndex(to);
+	if (startNode < 0 || endNode < 0) {
+		return false; //outside of map region!
+	}
+	PathKey key = MakeKey(startNode, endNode);
+
+	auto i = paths.find(key);
+	if (i != paths.end()) {
+		hits++;
+		outPath.SetWaypoints(i->second.waypoints);
+		if (i->second.found) {
+			lastPath	= i->second.waypoints;
+			lastEndNode = endNode;
+		}
+		return i->second.found;
+	}
+
+	std::vector<Vector3> waypoints;
+	if (RepairLastPath(startNode, endNode, to, waypoints)) {
+		repairs++;
+		Store(key, waypoints, true);
+		outPath.SetWaypoints(waypoints);
+		lastPath	= waypoints;
+		lastEndNode = endNode;
+		return true;
+	}
+
+	misses++;
+	NavigationPath path;
+	bool found = grid.FindPath(from, to, path, search);
+	Store(key, path.GetWaypoints(), found);
+	outPath.SetWaypoints(path.GetWaypoints());
+	if (found) {
+		lastPath	= path.GetWaypoints();
+		lastEndNode = endNode;
+	}
+	return found;
+}
+
+bool NavigationPathCache::RepairLastPath(int startNode, int endNode, const Vector3& to, std::vector<Vector3>& outWaypoints) {
+	if (lastPath.empty() || lastEndNode < 0) {
+		return false;
+	}
+	int width = grid.GetWidth();
+	if (std::abs((endNode % width) - (lastEndNode % width)) > repairRadius ||
+		std::abs((endNode / width) - (lastEndNode / width)) > repairRadius) {
+		return false; //goal has moved too far for the old path to be much use
+	}
+
+	//The start has to be somewhere along the old path, so everything after it can be kept
+	int startIndex = -1;
+	for (int i = (int)lastPath.size() - 1; i >= 0; --i) {
+		if (grid.GetNodeIndex(lastPath[i]) == startNode) {
+			startIndex = i;
+			break;
+		}
+	}
+	if (startIndex < 0) {
+		return false;
+	}
+
+	//Back off a few nodes from the old goal, as the way into the new one might need to bend earlier
+	int splice = startIndex < repairRadius * 2 ? startIndex : repairRadius * 2;
+
+	NavigationPath newEnd;
+	if (!grid.FindPath(lastPath[splice], to, newEnd, search)) {
+		return false;
+	}
+	outWaypoints = newEnd.GetWaypoints();	//Already ends with the splice node itself
+	outWaypoints.insert(outWaypoints.end(), lastPath.begin() + splice + 1, lastPath.begin() + startIndex + 1);
+	return true;
+}
+
+void NavigationPathCache::Store(PathKey key, const std::vector<Vector3>& waypoints, bool found) {
+	while (paths.size() >= maxPaths && !storeOrder.empty()) {
+		paths.erase(storeOrder.front());
+		storeOrder.pop_front();
+	}
+	CachedPath& p	= paths[key];
+	p.waypoints		= waypoints;
+	p.found			= found;
+	storeOrder.emplace_back(key);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "NavigationGrid.h"
+#include <vector>
+#include <deque>
+#include <unordered_map>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		Remembers the paths a grid has already worked out, keyed on the nodes the
+		path starts and ends in, so asking for the same route again (like an enemy
+		chasing a player who's standing still) costs a lookup rather than a search.
+		Everything remembered is forgotten as soon as the grid's version changes.
+
+		When there's no exact match, but the start is somewhere along the last path
+		handed out and the goal has only moved a node or two, the rest of that path
+		is reused, and only its last few nodes are searched for again. The repaired
+		path won't always be the shortest possible, but it's always a valid one.
+		*/
+		class NavigationPathCache	{
+		public:
+			NavigationPathCache(const NavigationGrid& grid, size_t maxPaths = 64, int repairRadius = 2);
+			~NavigationPathCache() {}
+
+			bool FindPath(const Vector3& from, const Vector3& to, NavigationPath& outPath);
+
+			void Clear();
+
+			int GetHits() const {
+				return hits;
+			}
+
+			int GetRepairs() const {
+				return repairs;
+			}
+
+			int GetMisses() const {
+				return misses;
+			}
+
+			void ResetStats() {
+				hits	= 0;
+				repairs = 0;
+				misses	= 0;
+			}
+
+		protected:
+			typedef long long PathKey;
+
+			struct CachedPath {
+				std::vector<Vector3>	waypoints;	//Goal first, same as NavigationPath
+				bool					found;		//Failed searches are worth remembering too
+			};
+
+			static PathKey MakeKey(int startNode, int endNode) {
+				return ((PathKey)startNode << 32) | (PathKey)(unsigned int)endNode;
+			}
+
+			bool RepairLastPath(int startNode, int endNode, const Vector3& to, std::vector<Vector3>& outWaypoints);
+			void Store(PathKey key, const std::vector<Vector3>& waypoints, bool found);
+
+			const NavigationGrid&	grid;
+			GridSearch				search;	//Its own, so caches for different agents never share search state
+			size_t					maxPaths;
+			int						repairRadius;
+			unsigned int			gridVersion;
+
+			std::unordered_map<PathKey, CachedPath> paths;
+			std::deque<PathKey>	storeOrder;	//Oldest first, for throwing paths away once there's too many
+
+			std::vector<Vector3>	lastPath;
+			int						lastEndNode;
+
+			int hits;
+			int repairs;
+			int misses;
+		};
+	}
+}
@@ -5,6 +5,9 @@ namespace NCL {
 	class OBBVolume : CollisionVolume
 	{
 	public:
+		using CollisionVolume::operator new;
+		using CollisionVolume::operator delete;
+
 		OBBVolume(const Maths::Vector3& halfDims) {
 			type		= VolumeType::OBB;
 			halfSizes	= halfDims;
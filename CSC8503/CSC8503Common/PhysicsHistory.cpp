@@ -0,0 +1,268 @@
+#include "PhysicsHistory.h"
+#include "GameWorld.h"
+#include "GameObject.h"
+#include "PhysicsObject.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+using namespace NCL;
+using namespace CSC8503;
+
+PhysicsHistory::PhysicsHistory(int capacity, int keyframeInterval) {
+	//A delta frame is no use without its keyframe, so the buffer
+	//always has to be able to hold at least one full run of them
+	if (capacity <= keyframeInterval) {
+		capacity = keyframeInterval + 1;
+	}
+	frames.resize(capacity);
+	this->keyframeInterval = keyframeInterval;
+	Reset();
+}
+
+PhysicsHistory::~PhysicsHistory() {
+}
+
+void PhysicsHistory::Reset() {
+	for (Frame& f : frames) {
+		f.frameID		= -1;
+		f.keyframeID	= -1;
+		f.bodies.clear();
+		f.states.clear();
+		f.changed.clear();
+		f.contacts.clear();
+	}
+	lastStates.clear();
+	nextFrameID		= 0;
+	currentKeyframe = -1;
+}
+
+/*
+Each keyframe's bodies are packed down to just the ones still around, and the
+deltas that follow it have their body indices moved to match. Deltas whose
+keyframe has already been overwritten can't be restored anyway, so they're
+marked as gone rather than patched up.
+*/
+void PhysicsHistory::Forget(const std::vector<GameObject*>& removed) {
+	auto isRemoved = [&](GameObject* o) {
+		return std::binary_search(removed.begin(), removed.end(), o);
+	};
+
+	//Where each of a keyframe's bodies ends up, or -1 if it's been removed
+	std::unordered_map<int, std::vector<int>> remaps;
+	for (const Frame& f : frames) {
+		if (f.frameID < 0 || f.frameID != f.keyframeID) {
+			continue;
+		}
+		std::vector<int>& remap = remaps[f.frameID];
+		remap.resize(f.bodies.size());
+		int next = 0;
+		for (size_t i = 0; i < f.bodies.size(); ++i) {
+			remap[i] = isRemoved(f.bodies[i]) ? -1 : next++;
+		}
+	}
+
+	for (Frame& f : frames) {
+		if (f.frameID < 0) {
+			continue;
+		}
+		auto remap = remaps.find(f.keyframeID);
+		if (remap == remaps.end()) {
+			f.frameID		= -1;
+			f.keyframeID	= -1;
+			continue;
+		}
+		if (f.frameID == f.keyframeID) {
+			size_t kept = 0;
+			for (size_t i = 0; i < f.bodies.size(); ++i) {
+				if (remap->second[i] >= 0) {
+					f.bodies[kept] = f.bodies[i];
+					f.states[kept] = f.states[i];
+					kept++;
+				}
+			}
+			f.bodies.resize(kept);
+			f.states.resize(kept);
+		}
+		else {
+			size_t kept = 0;
+			for (size_t i = 0; i < f.changed.size(); ++i) {
+				int to = remap->second[f.changed[i]];
+				if (to >= 0) {
+					f.changed[kept] = to;
+					f.states[kept]	= f.states[i];
+					kept++;
+				}
+			}
+			f.changed.resize(kept);
+			f.states.resize(kept);
+		}
+		f.contacts.erase(std::remove_if(f.contacts.begin(), f.contacts.end(),
+			[&](const CollisionDetection::CollisionInfo& c) {
+				return isRemoved(c.a) || isRemoved(c.b);
+			}), f.contacts.end());
+	}
+
+	auto current = remaps.find(currentKeyframe);
+	if (current == remaps.end()) {
+		lastStates.clear();
+		currentKeyframe = -1;
+		return;
+	}
+	size_t kept = 0;
+	for (size_t i = 0; i < lastStates.size(); ++i) {
+		if (current->second[i] >= 0) {
+			lastStates[kept++] = lastStates[i];
+		}
+	}
+	lastStates.resize(kept);
+}
+
+void PhysicsHistory::CaptureBody(GameObject* o, BodyState& state) {
+	Transform& t		= o->GetTransform();
+	state.position		= t.GetPosition();
+	state.orientation	= t.GetOrientation();
+
+	PhysicsObject* p = o->GetPhysicsObject();
+	if (p) {
+		state.linearVelocity	= p->GetLinearVelocity();
+		state.angularVelocity	= p->GetAngularVelocity();
+	}
+	else {
+		state.linearVelocity	= Vector3();
+		state.angularVelocity	= Vector3();
+	}
+}
+
+void PhysicsHistory::ApplyBody(GameObject* o, const BodyState& state) {
+	o->GetTransform().SetPosition(state.position).SetOrientation(state.orientation);
+
+	PhysicsObject* p = o->GetPhysicsObject();
+	if (p) {
+		p->SetLinearVelocity(state.linearVelocity);
+		p->SetAngularVelocity(state.angularVelocity);
+		p->ClearForces();
+	}
+}
+
+/*
+If the world's objects are exactly the ones the current keyframe saw, only the
+bodies whose state differs from the last save are stored. Anything else (objects
+added, removed or shuffled) just forces a new keyframe, so a delta can always
+be matched up with the right bodies.
+*/
+int PhysicsHistory::Save(GameWorld& world, const std::set<CollisionDetection::CollisionInfo>& contacts, float dTOffset) {
+	GameObjectIterator first;
+	GameObjectIterator last;
+	world.GetObjectIterators(first, last);
+	size_t bodyCount = last - first;
+
+	bool needsKeyframe = currentKeyframe < 0 || (nextFrameID - currentKeyframe) >= keyframeInterval;
+	if (!needsKeyframe) {
+		const std::vector<GameObject*>& keyBodies = GetFrame(currentKeyframe).bodies;
+		needsKeyframe = keyBodies.size() != bodyCount || !std::equal(first, last, keyBodies.begin());
+	}
+
+	Frame& frame	= GetFrame(nextFrameID);
+	frame.frameID	= nextFrameID;
+	frame.dTOffset	= dTOffset;
+	frame.contacts.assign(contacts.begin(), contacts.end());
+	frame.bodies.clear();
+	frame.states.clear();
+	frame.changed.clear();
+
+	if (needsKeyframe) {
+		frame.bodies.assign(first, last);
+		lastStates.resize(bodyCount);
+		for (size_t i = 0; i < bodyCount; ++i) {
+			CaptureBody(frame.bodies[i], lastStates[i]);
+		}
+		frame.states	= lastStates;
+		currentKeyframe = nextFrameID;
+	}
+	else {
+		BodyState state;
+		int i = 0;
+		for (auto it = first; it != last; ++it, ++i) {
+			CaptureBody(*it, state);
+			if (memcmp(&state, &lastStates[i], sizeof(BodyState)) != 0) {
+				lastStates[i] = state;
+				frame.changed.emplace_back(i);
+				frame.states.emplace_back(state);
+			}
+		}
+	}
+	frame.keyframeID = currentKeyframe;
+	return nextFrameID++;
+}
+
+bool PhysicsHistory::HasFrame(int frameID) const {
+	if (frameID < 0 || frameID >= nextFrameID || frameID < nextFrameID - (int)frames.size()) {
+		return false;
+	}
+	const Frame& frame = GetFrame(frameID);
+	if (frame.frameID != frameID) {
+		return false;
+	}
+	return GetFrame(frame.keyframeID).frameID == frame.keyframeID;
+}
+
+/*
+Restoring a frame makes it the latest one, so that anything simulated
+afterwards gets saved on top of it, replacing the old future.
+*/
+bool PhysicsHistory::Restore(int frameID, GameWorld& world, std::set<CollisionDetection::CollisionInfo>& contacts, float& dTOffset) {
+	if (!HasFrame(frameID)) {
+		return false;
+	}
+	const Frame& frame		= GetFrame(frameID);
+	const Frame& keyframe	= GetFrame(frame.keyframeID);
+
+	//Checked against the world's own list, so we never touch a body that's been deleted.
+	//Removing objects can shuffle the world's order, so only what's in it has to match
+	GameObjectIterator first;
+	GameObjectIterator last;
+	world.GetObjectIterators(first, last);
+	if ((size_t)(last - first) != keyframe.bodies.size()) {
+		return false;
+	}
+	if (!std::equal(first, last, keyframe.bodies.begin())) {
+		std::vector<GameObject*> worldBodies(first, last);
+		std::vector<GameObject*> keyBodies(keyframe.bodies);
+		std::sort(worldBodies.begin(), worldBodies.end());
+		std::sort(keyBodies.begin(), keyBodies.end());
+		if (worldBodies != keyBodies) {
+			return false;
+		}
+	}
+
+	lastStates = keyframe.states;
+	for (int i = frame.keyframeID + 1; i <= frameID; ++i) {
+		const Frame& delta = GetFrame(i);
+		for (size_t j = 0; j < delta.changed.size(); ++j) {
+			lastStates[delta.changed[j]] = delta.states[j];
+		}
+	}
+
+	for (size_t i = 0; i < lastStates.size(); ++i) {
+		ApplyBody(keyframe.bodies[i], lastStates[i]);
+	}
+	contacts.clear();
+	contacts.insert(frame.contacts.begin(), frame.contacts.end());
+	dTOffset = frame.dTOffset;
+
+	currentKeyframe = frame.keyframeID;
+	nextFrameID		= frameID + 1;
+	return true;
+}
+
+size_t PhysicsHistory::GetMemoryUsed() const {
+	size_t total = sizeof(Frame) * frames.capacity() + sizeof(BodyState) * lastStates.capacity();
+	for (const Frame& f : frames) {
+		total += f.bodies.capacity()	* sizeof(GameObject*);
+		total += f.states.capacity()	* sizeof(BodyState);
+		total += f.changed.capacity()	* sizeof(int);
+		total += f.contacts.capacity()	* sizeof(CollisionDetection::CollisionInfo);
+	}
+	return total;
+}
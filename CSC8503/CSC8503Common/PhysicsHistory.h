@@ -0,0 +1,80 @@
+#pragma once
+#include "../../Common/Vector3.h"
+#include "../../Common/Quaternion.h"
+#include "CollisionDetection.h"
+#include <vector>
+#include <set>
+
+namespace NCL {
+	namespace CSC8503 {
+		class GameWorld;
+		class GameObject;
+
+		//Everything needed to put a body back where it was
+		struct BodyState {
+			Vector3		position;
+			Quaternion	orientation;
+			Vector3		linearVelocity;
+			Vector3		angularVelocity;
+		};
+
+		/*
+		A fixed size ring buffer of past physics states. Every so often a full
+		keyframe of every body is stored, and the frames in between only store
+		the bodies that changed since the frame before. Restoring a frame copies
+		its keyframe back in one go, and then replays the deltas on top.
+		*/
+		class PhysicsHistory	{
+		public:
+			PhysicsHistory(int capacity = 120, int keyframeInterval = 10);
+			~PhysicsHistory();
+
+			void Reset();
+
+			//Drops the given objects from every stored frame, so the rest can still be restored. Must be sorted
+			void Forget(const std::vector<GameObject*>& removed);
+
+			//Returns the ID of the new snapshot
+			int  Save(GameWorld& world, const std::set<CollisionDetection::CollisionInfo>& contacts, float dTOffset);
+			//Fails if the frame has fallen out of the buffer, or the world's objects have changed since
+			bool Restore(int frameID, GameWorld& world, std::set<CollisionDetection::CollisionInfo>& contacts, float& dTOffset);
+
+			bool HasFrame(int frameID) const;
+
+			int GetLatestFrame() const {
+				return nextFrameID - 1;
+			}
+
+			size_t GetMemoryUsed() const;
+
+		protected:
+			struct Frame {
+				int		frameID;
+				int		keyframeID;
+				float	dTOffset;
+
+				std::vector<GameObject*>	bodies;		//Only filled in for keyframes
+				std::vector<BodyState>		states;		//Every body for keyframes, only the changed ones otherwise
+				std::vector<int>			changed;	//Which body each delta state belongs to
+				std::vector<CollisionDetection::CollisionInfo> contacts;
+			};
+
+			static void CaptureBody(GameObject* o, BodyState& state);
+			static void ApplyBody(GameObject* o, const BodyState& state);
+
+			Frame& GetFrame(int frameID) {
+				return frames[frameID % frames.size()];
+			}
+			const Frame& GetFrame(int frameID) const {
+				return frames[frameID % frames.size()];
+			}
+
+			std::vector<Frame>		frames;
+			std::vector<BodyState>	lastStates;	//What the previous save looked like, to find deltas against
+
+			int keyframeInterval;
+			int nextFrameID;
+			int currentKeyframe;
+		};
+	}
+}
@@ -9,15 +9,30 @@ PhysicsObject::PhysicsObject(Transform* parentTransform, const CollisionVolume*
 	volume		= parentVolume;
 
 	inverseMass = 1.0f;
+	kinematic	= false;
 	elasticity	= 0.8f;
 	friction	= 0.8f;
+
+	lodRate				= 1;
+	lodPromotedFrames	= 0;
+	forceUpdates		= 1;
+	forcesUsed			= false;
 }
 
 PhysicsObject::~PhysicsObject()	{
 
 }
 
+void PhysicsObject::MoveKinematicTo(const Vector3& target, float time) {
+	if (time > 0.0f) {
+		linearVelocity = (target - transform->GetPosition()) / time;
+	}
+}
+
 void PhysicsObject::ApplyAngularImpulse(const Vector3& force) {
+	if (kinematic) {
+		return;
+	}
 	if (force.Length() > 0) {
 		bool a = true;
 	}
@@ -25,6 +40,9 @@ void PhysicsObject::ApplyAngularImpulse(const Vector3& force) {
 }
 
 void PhysicsObject::ApplyLinearImpulse(const Vector3& force) {
+	if (kinematic) {
+		return;
+	}
 	linearVelocity += force * inverseMass;
 }
 
@@ -46,6 +64,8 @@ void PhysicsObject::AddTorque(const Vector3& addedTorque) {
 void PhysicsObject::ClearForces() {
 	force				= Vector3();
 	torque				= Vector3();
+	forceUpdates		= 1;
+	forcesUsed			= false;
 }
 
 void PhysicsObject::InitCubeInertia() {
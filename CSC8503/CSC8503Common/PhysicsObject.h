@@ -39,6 +39,24 @@ namespace NCL {
 				return inverseMass;
 			}
 
+			//Kinematic objects ignore forces, and are moved purely by whatever velocity
+			//they're given. To anything they hit, they behave as if infinitely heavy
+			void SetKinematic(bool state) {
+				kinematic = state;
+			}
+
+			bool IsKinematic() const {
+				return kinematic;
+			}
+
+			//Sets the velocity needed to reach the target position in the given time
+			void MoveKinematicTo(const Vector3& target, float time);
+
+			//The mass the collision solver sees
+			float GetSolverInverseMass() const {
+				return kinematic ? 0.0f : inverseMass;
+			}
+
 			void SetElasticity(float elas) {
 				elasticity = elas;
 			}
@@ -47,6 +65,14 @@ namespace NCL {
 				return elasticity;
 			}
 
+			void SetFriction(float f) {
+				friction = f;
+			}
+
+			float GetFriction() const {
+				return friction;
+			}
+
 			void ApplyAngularImpulse(const Vector3& force);
 			void ApplyLinearImpulse(const Vector3& force);
 			
@@ -72,15 +98,62 @@ namespace NCL {
 
 			void UpdateInertiaTensor();
 
+			//Normally worked out by the Init functions, but can be copied from one object to another
+			void SetInverseInertia(const Vector3& i) {
+				inverseInertia = i;
+			}
+
+			Vector3 GetInverseInertia() const {
+				return inverseInertia;
+			}
+
 			Matrix3 GetInertiaTensor() const {
 				return inverseInteriaTensor;
 			}
 
+			//How many physics substeps pass between each step of this object
+			int GetLODRate() const {
+				return lodRate;
+			}
+
+			void SetLODRate(int rate) {
+				lodRate = rate;
+			}
+
+			//While this is above zero, the object is kept at the full rate
+			int GetLODPromotedFrames() const {
+				return lodPromotedFrames;
+			}
+
+			void SetLODPromotedFrames(int frames) {
+				lodPromotedFrames = frames;
+			}
+
+			//Objects that don't step every update keep their forces until they do, so
+			//this counts how many updates' worth have built up, to use their average
+			int GetForceUpdates() const {
+				return forceUpdates;
+			}
+
+			void AddForceUpdate() {
+				forceUpdates++;
+			}
+
+			//Set once the forces have been integrated, so they can be cleared
+			bool HaveForcesBeenUsed() const {
+				return forcesUsed;
+			}
+
+			void SetForcesUsed() {
+				forcesUsed = true;
+			}
+
 		protected:
 			const CollisionVolume* volume;
 			Transform*		transform;
 
 			float inverseMass;
+			bool  kinematic;
 			float elasticity;
 			float friction;
 
@@ -94,6 +167,11 @@ namespace NCL {
 			Vector3 torque;
 			Vector3 inverseInertia;
 			Matrix3 inverseInteriaTensor;
+
+			int lodRate;
+			int lodPromotedFrames;
+			int forceUpdates;
+			bool forcesUsed;
 		};
 	}
 }
@@ -3,15 +3,22 @@
 #include "GameObject.h"
 #include "CollisionDetection.h"
 #include "../../Common/Quaternion.h"
+#include "../../Common/Camera.h"
 
 #include "Constraint.h"
 
 #include "Debug.h"
 
 #include <functional>
+#include <algorithm>
+#include <atomic>
 using namespace NCL;
 using namespace CSC8503;
 
+//This is the fixed timestep we'd LIKE to have
+const int   idealHZ = 120;
+const float idealDT = 1.0f / idealHZ;
+
 /*
 
 These two variables help define the relationship between positions
@@ -19,15 +26,36 @@ and the forces that are added to objects to change those positions
 
 */
 
-PhysicsSystem::PhysicsSystem(GameWorld& g) : gameWorld(g)	{
+PhysicsSystem::PhysicsSystem(GameWorld& g) : gameWorld(g),
+	staticTree(Vector2(1024, 1024), 6, 5),
+	dynamicTree(Vector2(1024, 1024), 6, 5)	{
 	applyGravity	= false;
 	useBroadPhase	= true;	
 	dTOffset		= 0.0f;
 	globalDamping	= 0.995f;
+	staticTreeDirty = true;
+	dynamicTreeCurrent = false;
+	history			= nullptr;
+
+	constraintIterationCount	= 10;
+	realHZ						= idealHZ;
+	realDT						= idealDT;
+	adaptiveTimestep			= true;
+
+	journalConsumer = gameWorld.GetJournal().AddConsumer();
+
+	useLOD					= false;
+	lodHalfRateDistance		= 80.0f;
+	lodQuarterRateDistance	= 160.0f;
+	lodCamera				= nullptr;
+	lodSubstep				= 0;
+	lodStats				= LODStats();
 	SetGravity(Vector3(0.0f, -9.8f, 0.0f));
 }
 
 PhysicsSystem::~PhysicsSystem()	{
+	gameWorld.SetBroadphase(nullptr, nullptr);
+	delete history;
 }
 
 void PhysicsSystem::SetGravity(const Vector3& g) {
@@ -38,59 +66,92 @@ void PhysicsSystem::SetGravity(const Vector3& g) {
 
 If the 'game' is ever reset, the PhysicsSystem must be
 'cleared' to remove any old collisions that might still
-be hanging around in the collision list. If your engine
-is expanded to allow objects to be removed from the world,
-you'll need to iterate through this collisions list to remove
-any collisions they are in.
+be hanging around in the collision list. Objects removed
+from the world one at a time are instead cleaned out of
+the lists by ForgetObjects, at the start of the next update.
 
 */
 void PhysicsSystem::Clear() {
 	allCollisions.clear();
+	staticObjects.clear();
+	dynamicObjects.clear();
+	staticTree.Clear();
+	dynamicTree.Clear();
+	staticOutsiders.clear();
+	treeOutsiders.clear();
+	staticTreeDirty		= true;
+	dynamicTreeCurrent	= false;
+	gameWorld.SetBroadphase(nullptr, nullptr);
+	if (history) {
+		history->Reset();
+	}
+	lodObservers.clear();
+	lodPromotions.clear();
+	triggerCandidates.clear();
+	triggerOverlaps.clear();
+	activeTriggers.clear();
 }
 
-/*
+void PhysicsSystem::EnableHistory(int frames, int keyframeInterval) {
+	delete history;
+	history = new PhysicsHistory(frames, keyframeInterval);
+}
 
-This is the core of the physics engine update
+void PhysicsSystem::DisableHistory() {
+	delete history;
+	history = nullptr;
+}
 
-*/
-int constraintIterationCount = 10;
+int PhysicsSystem::SaveSnapshot() {
+	if (!history) {
+		return -1;
+	}
+	return history->Save(gameWorld, allCollisions, dTOffset);
+}
 
-//This is the fixed timestep we'd LIKE to have
-const int   idealHZ = 120;
-const float idealDT = 1.0f / idealHZ;
+/*
+Puts every body back to how it was at the given snapshot, along with the
+contacts that were active then, so that resimulating from that point gives the
+same results as the first time round. Statics are rebuilt in case any moved.
+*/
+bool PhysicsSystem::RestoreSnapshot(int frameID) {
+	UpdateObjectAABBs();	//Catch up on any removals first, so old frames can't bring them back
+	if (!history || !history->Restore(frameID, gameWorld, allCollisions, dTOffset)) {
+		return false;
+	}
+	staticTreeDirty = true;
+	if (useBroadPhase) {
+		UpdateObjectAABBs();
+		UpdateStaticTree();
+		BuildDynamicTree();
+		gameWorld.SetBroadphase(&staticTree, &dynamicTree, &treeOutsiders);
+	}
+	return true;
+}
 
 /*
-This is the fixed update we actually have...
+
+This is the core of the physics engine update
+
+The fixed update we actually have is kept in realHZ / realDT...
 If physics takes too long it starts to kill the framerate, it'll drop the 
 iteration count down until the FPS stabilises, even if that ends up
 being at a low rate. 
-*/
-int realHZ		= idealHZ;
-float realDT	= idealDT;
 
+*/
 void PhysicsSystem::Update(float dt) {	
-	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::B)) {
-		useBroadPhase = !useBroadPhase;
-		std::cout << "Setting broadphase to " << useBroadPhase << std::endl;
-	}
-	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::I)) {
-		constraintIterationCount--;
-		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
-	}
-	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::O)) {
-		constraintIterationCount++;
-		std::cout << "Setting constraint iterations to " << constraintIterationCount << std::endl;
-	}
-
 	dTOffset += dt; //We accumulate time delta here - there might be remainders from previous frame!
 
 	GameTimer t;
 	t.GetTimeDeltaSeconds();
 
+	UpdateObjectAABBs();
 	if (useBroadPhase) {
-		UpdateObjectAABBs();
+		UpdateStaticTree();
 	}
+	UpdateLOD();
 
+	int substeps = 0;
 	while(dTOffset >= realDT) {
 		IntegrateAccel(realDT); //Update accelerations from external forces
 		if (useBroadPhase) {
@@ -100,6 +161,8 @@ void PhysicsSystem::Update(float dt) {
 		else {
 			BasicCollisionDetection();
 		}
+		TriggerPhase();
+		substeps++;
 
 		//This is our simple iterative solver - 
 		//we just run things multiple times, slowly moving things forward
@@ -109,17 +172,49 @@ void PhysicsSystem::Update(float dt) {
 			UpdateConstraints(constraintDt);	
 		}
 		IntegrateVelocity(realDT); //update positions from new velocity changes
+		dynamicTreeCurrent = false;
+
+		ApplyLODPromotions();
+		lodSubstep++;
 
 		dTOffset -= realDT;
 	}
 
 	ClearForces();	//Once we've finished with the forces, reset them to zero
 
+	//Leave the trees matching the final positions of this update, so the
+	//game can use them for raycasts and other queries until the next one.
+	//Reading the journal now takes in everything we just moved, so if the
+	//game doesn't move anything itself, the next broadphase can reuse it
+	if (useBroadPhase) {
+		UpdateObjectAABBs();
+		if (!dynamicTreeCurrent) {
+			BuildDynamicTree();
+		}
+		gameWorld.SetBroadphase(&staticTree, &dynamicTree, &treeOutsiders);
+	}
+	else {
+		gameWorld.SetBroadphase(nullptr, nullptr);
+	}
+
 	UpdateCollisionList(); //Remove any old collisions
+	if (substeps > 0) {
+		UpdateTriggerList();
+	}
+
+	if (history) {
+		SaveSnapshot();
+	}
 
 	t.Tick();
 	float updateTime = t.GetTimeDeltaSeconds();
 
+	lodStats.updates++;
+	lodStats.updateTime += updateTime;
+
+	if (!adaptiveTimestep) {
+		return;
+	}
 	//Uh oh, physics is taking too long...
 	if (updateTime > realDT) {
 		realHZ /= 2;
@@ -155,13 +250,21 @@ rocket launcher, gaining a point when the player hits the gold coin, and so on).
 void PhysicsSystem::UpdateCollisionList() {
 	for (std::set<CollisionDetection::CollisionInfo>::iterator i = allCollisions.begin(); i != allCollisions.end(); ) {
 		if ((*i).framesLeft == numCollisionFrames) {
-			i->a->OnCollisionBegin(i->b);
-			i->b->OnCollisionBegin(i->a);
+			if (i->a->PassesCollisionFilter(i->b)) {
+				i->a->OnCollisionBegin(i->b);
+			}
+			if (i->b->PassesCollisionFilter(i->a)) {
+				i->b->OnCollisionBegin(i->a);
+			}
 		}
 		(*i).framesLeft = (*i).framesLeft - 1;
 		if ((*i).framesLeft < 0) {
-			i->a->OnCollisionEnd(i->b);
-			i->b->OnCollisionEnd(i->a);
+			if (i->a->PassesCollisionFilter(i->b)) {
+				i->a->OnCollisionEnd(i->b);
+			}
+			if (i->b->PassesCollisionFilter(i->a)) {
+				i->b->OnCollisionEnd(i->a);
+			}
 			i = allCollisions.erase(i);
 		}
 		else {
@@ -170,12 +273,129 @@ void PhysicsSystem::UpdateCollisionList() {
 	}
 }
 
+/*
+Trigger volumes (like the coins) don't need any contact points, and should never
+push anything around, so the narrowphase just passes any pair involving them
+over to here. Each substep, the pairs are run through a simple yes/no overlap test
+in one go. At the end of the update, the overlapping pairs are compared against
+last update's, to work out which objects have just entered or left a trigger.
+*/
+void PhysicsSystem::AddTriggerCandidate(GameObject* a, GameObject* b) {
+	if (a->IsTrigger() && b->IsTrigger()) {
+		return;	//Triggers can't set each other off
+	}
+	triggerCandidates.emplace_back(min(a, b), max(a, b));
+}
+
+void PhysicsSystem::TriggerPhase() {
+	for (const TriggerPair& p : triggerCandidates) {
+		if ((p.first->GetLayer() | p.second->GetLayer()) & Layer::IgnoreAllCollisions) {
+			continue;
+		}
+		if (CollisionDetection::VolumeOverlap(p.first->GetBoundingVolume(), p.first->GetTransform(),
+			p.second->GetBoundingVolume(), p.second->GetTransform())) {
+			triggerOverlaps.emplace_back(p);
+		}
+	}
+	triggerCandidates.clear();
+}
+
+void PhysicsSystem::UpdateTriggerList() {
+	std::sort(triggerOverlaps.begin(), triggerOverlaps.end());
+	triggerOverlaps.erase(std::unique(triggerOverlaps.begin(), triggerOverlaps.end()), triggerOverlaps.end());
+
+	for (const TriggerPair& p : triggerOverlaps) {
+		if (!std::binary_search(activeTriggers.begin(), activeTriggers.end(), p)) {
+			if (p.first->PassesCollisionFilter(p.second)) {
+				p.first->OnTriggerEnter(p.second);
+			}
+			if (p.second->PassesCollisionFilter(p.first)) {
+				p.second->OnTriggerEnter(p.first);
+			}
+		}
+	}
+	for (const TriggerPair& p : activeTriggers) {
+		if (!std::binary_search(triggerOverlaps.begin(), triggerOverlaps.end(), p)) {
+			if (p.first->PassesCollisionFilter(p.second)) {
+				p.first->OnTriggerExit(p.second);
+			}
+			if (p.second->PassesCollisionFilter(p.first)) {
+				p.second->OnTriggerExit(p.first);
+			}
+		}
+	}
+	activeTriggers.swap(triggerOverlaps);
+	triggerOverlaps.clear();
+}
+
+/*
+Broadphase AABBs only change when an object is rotated or given a new volume,
+so rather than recalculating every object's AABB each update, we only do it for
+the objects the world's journal says have been created, moved or changed since
+we last looked. A static object changing means the static tree is out of date too.
+This runs again at the end of each update, to take in what the physics itself
+moved, so anything showing up at the start of the next one was the game's doing.
+*/
 void PhysicsSystem::UpdateObjectAABBs() {
-	gameWorld.OperateOnContents(
-		[](GameObject* g) {
-			g->UpdateBroadphaseAABB();
+	gameWorld.GetJournal().Consume(journalConsumer,
+		[&](const JournalRecord& r) {
+			dynamicTreeCurrent = false;	//Whatever it was, the dynamic tree might not match it any more
+			if (r.event == JournalEvent::Destroyed) {
+				removedObjects.emplace_back(r.object);
+				return;
+			}
+			r.object->UpdateBroadphaseAABB();
+			if (IsStaticObject(r.object)) {
+				staticTreeDirty = true;
+			}
 		}
 	);
+	if (!removedObjects.empty()) {
+		ForgetObjects(removedObjects);
+		removedObjects.clear();
+	}
+}
+
+/*
+Objects removed from the world may well have been deleted already, so anything
+still holding on to them is dropped without calling any of their functions - that
+includes the OnCollisionEnd / OnTriggerExit the other object would normally get.
+They're dropped from the history as well, so earlier frames can still be restored
+for everything else.
+*/
+void PhysicsSystem::ForgetObjects(std::vector<GameObject*>& removed) {
+	std::sort(removed.begin(), removed.end());
+	auto isRemoved = [&](GameObject* o) {
+		return std::binary_search(removed.begin(), removed.end(), o);
+	};
+	auto pairRemoved = [&](const TriggerPair& p) {
+		return isRemoved(p.first) || isRemoved(p.second);
+	};
+
+	for (auto i = allCollisions.begin(); i != allCollisions.end(); ) {
+		if (isRemoved(i->a) || isRemoved(i->b)) {
+			i = allCollisions.erase(i);
+		}
+		else {
+			++i;
+		}
+	}
+	activeTriggers.erase(std::remove_if(activeTriggers.begin(), activeTriggers.end(), pairRemoved), activeTriggers.end());
+	triggerOverlaps.erase(std::remove_if(triggerOverlaps.begin(), triggerOverlaps.end(), pairRemoved), triggerOverlaps.end());
+
+	auto eraseRemoved = [&](std::vector<GameObject*>& list) {
+		list.erase(std::remove_if(list.begin(), list.end(), isRemoved), list.end());
+	};
+	eraseRemoved(staticObjects);
+	eraseRemoved(dynamicObjects);
+	eraseRemoved(staticOutsiders);
+	eraseRemoved(lodObservers);
+	eraseRemoved(lodPromotions);
+	staticTreeDirty = true;
+
+	if (history) {
+		history->Forget(removed);
+	}
 }
 
 /*
@@ -200,6 +420,13 @@ void PhysicsSystem::BasicCollisionDetection() {
 			if ((*j)->GetPhysicsObject() == nullptr) {
 				continue;
 			}
+			if ((*i)->IsTrigger() || (*j)->IsTrigger()) {
+				AddTriggerCandidate(*i, *j);
+				continue;
+			}
+			if ((IsStaticObject(*i) || IsKinematic(*i)) && (IsStaticObject(*j) || IsKinematic(*j))) {
+				continue;
+			}
 			CollisionDetection::CollisionInfo info;
 			if (CollisionDetection::ObjectIntersection(*i, *j, info)) {
 				//std::cout << "Collision between " << (*i)->GetName() << " and " << (*j)->GetName() << std::endl;
@@ -224,14 +451,17 @@ void PhysicsSystem::ImpulseResolveCollision(GameObject& a, GameObject& b, Collis
 	Transform& transformA = a.GetTransform();
 	Transform& transformB = b.GetTransform();
 
-	float totalMass = physA->GetInverseMass() + physB->GetInverseMass();
+	//Kinematic objects count as infinitely heavy, so they push things out of the way but never get pushed
+	float inverseMassA = physA->GetSolverInverseMass();
+	float inverseMassB = physB->GetSolverInverseMass();
+	float totalMass = inverseMassA + inverseMassB;
 
 	if (totalMass == 0)
 		return; //Collision between two static objects
 
 	//Projection
-	transformA.SetPosition(transformA.GetPosition() - p.normal * p.penetration * (physA->GetInverseMass() / totalMass));
-	transformB.SetPosition(transformB.GetPosition() + p.normal * p.penetration * (physB->GetInverseMass() / totalMass));
+	transformA.SetPosition(transformA.GetPosition() - p.normal * p.penetration * (inverseMassA / totalMass));
+	transformB.SetPosition(transformB.GetPosition() + p.normal * p.penetration * (inverseMassB / totalMass));
 
 	//Impulse 
 	Vector3 relativeA = p.localA;
@@ -246,8 +476,10 @@ void PhysicsSystem::ImpulseResolveCollision(GameObject& a, GameObject& b, Collis
 	Vector3 contactVelocity = fullVelB - fullVelA;
 
 	float impulseForce = Vector3::Dot(contactVelocity, p.normal);
-	Vector3 inertiaA = Vector3::Cross(physA->GetInertiaTensor() * Vector3::Cross(relativeA, p.normal), relativeA);
-	Vector3 inertiaB = Vector3::Cross(physB->GetInertiaTensor() * Vector3::Cross(relativeB, p.normal), relativeB);
+	Vector3 inertiaA = physA->IsKinematic() ? Vector3() :
+		Vector3::Cross(physA->GetInertiaTensor() * Vector3::Cross(relativeA, p.normal), relativeA);
+	Vector3 inertiaB = physB->IsKinematic() ? Vector3() :
+		Vector3::Cross(physB->GetInertiaTensor() * Vector3::Cross(relativeB, p.normal), relativeB);
 
 	float angularEffect = Vector3::Dot(inertiaA + inertiaB, p.normal);
 
@@ -275,29 +507,44 @@ compare the collisions that we absolutely need to.
 
 void PhysicsSystem::BroadPhase() {
 	broadphaseCollisions.clear();
-	QuadTree<GameObject*> tree(Vector2(1024, 1024), 6, 5);
+	if (!dynamicTreeCurrent) {
+		BuildDynamicTree();
+	}
 
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
-	for (auto i = first; i != last; ++i) {
+	//Dynamic objects against each other...
+	dynamicTree.OperateOnContents(
+		[&](std::list<QuadTreeEntry<GameObject*>>& data) {
+		CollisionDetection::CollisionInfo info;
+		for (auto i = data.begin(); i != data.end(); i++) {
+			for (auto j = std::next(i); j != data.end(); j++) {
+				//Strict object ordering using 'lowest' ID value, so 
+				//you dont end up with A-B collision and B-A collision
+				info.a = min((*i).object, (*j).object);
+				info.b = max((*i).object, (*j).object);
+				broadphaseCollisions.insert(info);
+			}
+		}
+		}
+	);
+
+	//...and then against the prebuilt static tree. Statics are never
+	//tested against each other, as they can't ever move into each other!
+	for (GameObject* g : dynamicObjects) {
 		Vector3 halfSizes;
-		if (!(*i)->GetBroadphaseAABB(halfSizes)) {
+		if (!g->GetBroadphaseAABB(halfSizes)) {
 			continue;
 		}
-		Vector3 pos = (*i)->GetTransform().GetPosition();
-		tree.Insert(*i, pos, halfSizes);
-		tree.OperateOnContents(
+		Vector3 pos = g->GetTransform().GetPosition();
+		staticTree.OperateOnContents(pos, halfSizes,
 			[&](std::list<QuadTreeEntry<GameObject*>>& data) {
 			CollisionDetection::CollisionInfo info;
-			for (auto i = data.begin(); i != data.end(); i++) {
-				for (auto j = std::next(i); j != data.end(); j++) {
-					//Strict object ordering using 'lowest' ID value, so 
-					//you dont end up with A-B collision and B-A collision
-					info.a = min((*i).object, (*j).object);
-					info.b = max((*i).object, (*j).object);
-					broadphaseCollisions.insert(info);
+			for (const auto& i : data) {
+				if (!CollisionDetection::AABBTest(pos, i.pos, halfSizes, i.size)) {
+					continue;
 				}
+				info.a = min(g, i.object);
+				info.b = max(g, i.object);
+				broadphaseCollisions.insert(info);
 			}
 			}
 		);
@@ -306,6 +553,81 @@ void PhysicsSystem::BroadPhase() {
 
 /*
 
+Static objects (floors, walls, and anything else on the static layers) never
+move, so there's no point reinserting them into the broadphase every substep.
+Instead, the world is split into static and dynamic lists once per update, and
+the static objects are kept in their own quadtree, which is only rebuilt if the
+set of static objects has changed since the last time it was built.
+
+*/
+bool PhysicsSystem::IsStaticObject(GameObject* o) const {
+	return (o->GetLayer() & (Layer::StaticObjects | Layer::IgnoreAllCollisions)) != 0;
+}
+
+bool PhysicsSystem::IsKinematic(GameObject* o) const {
+	PhysicsObject* object = o->GetPhysicsObject();
+	return object && object->IsKinematic();
+}
+
+void PhysicsSystem::UpdateStaticTree() {
+	std::vector<GameObject*>::const_iterator first;
+	std::vector<GameObject*>::const_iterator last;
+	gameWorld.GetObjectIterators(first, last);
+
+	dynamicObjects.clear();
+	newStaticObjects.clear();
+
+	for (auto i = first; i != last; ++i) {
+		if (!(*i)->GetBoundingVolume()) {
+			continue;
+		}
+		if (IsStaticObject(*i)) {
+			newStaticObjects.emplace_back(*i);
+		}
+		else {
+			dynamicObjects.emplace_back(*i);
+		}
+	}
+
+	if (!staticTreeDirty && newStaticObjects == staticObjects) {
+		return;
+	}
+	staticObjects.swap(newStaticObjects);
+
+	staticTree.Clear();
+	staticOutsiders.clear();
+	for (GameObject* g : staticObjects) {
+		Vector3 halfSizes;
+		if (!g->GetBroadphaseAABB(halfSizes)) {
+			continue;
+		}
+		staticTree.Insert(g, g->GetTransform().GetPosition(), halfSizes);
+		if (!staticTree.Contains(g->GetTransform().GetPosition(), halfSizes)) {
+			staticOutsiders.emplace_back(g);
+		}
+	}
+	staticTreeDirty = false;
+	dynamicTreeCurrent = false;	//So the outsiders get gathered up again
+}
+
+void PhysicsSystem::BuildDynamicTree() {
+	dynamicTree.Clear();
+	treeOutsiders = staticOutsiders;
+	for (GameObject* g : dynamicObjects) {
+		Vector3 halfSizes;
+		if (!g->GetBroadphaseAABB(halfSizes)) {
+			continue;
+		}
+		dynamicTree.Insert(g, g->GetTransform().GetPosition(), halfSizes);
+		if (!dynamicTree.Contains(g->GetTransform().GetPosition(), halfSizes)) {
+			treeOutsiders.emplace_back(g);
+		}
+	}
+	dynamicTreeCurrent = true;
+}
+
+/*
+
 The broadphase will now only give us likely collisions, so we can now go through them,
 and work out if they are truly colliding, and if so, add them into the main collision list
 */
@@ -314,16 +636,53 @@ void PhysicsSystem::NarrowPhase() {
 		i = broadphaseCollisions.begin(); i != broadphaseCollisions.end(); i++) {
 		CollisionDetection::CollisionInfo info = *i;
 
-		int staticMask = Layer::StaticObjects | Layer::IgnoreAllCollisions;
 		int collisionMask = Layer::DontResolveCollisions;
 
-		//Dont check collisions between static objects
-		if (((*i).a->GetLayer() & staticMask) && (*i).b->GetLayer() & staticMask) {
+		//Triggers only need to know if they're overlapping, so they get handled separately
+		if (info.a->IsTrigger() || info.b->IsTrigger()) {
+			AddTriggerCandidate(info.a, info.b);
+			continue;
+		}
+
+		bool staticA = IsStaticObject(info.a);
+		bool staticB = IsStaticObject(info.b);
+
+		//Kinematic objects only follow their script, so only dynamic objects can react to them
+		if ((staticA || IsKinematic(info.a)) && (staticB || IsKinematic(info.b))) {
+			continue;
+		}
+
+		//If neither object is being stepped this substep, neither can have moved
+		if ((staticA || !IsSteppingThisSubstep(info.a)) && (staticB || !IsSteppingThisSubstep(info.b))) {
+			lodStats.pairsSkipped++;
 			continue;
 		}
-		if (CollisionDetection::ObjectIntersection(info.a, info.b, info)) {
+		lodStats.pairTests++;
+
+		int rateA = GetStepRate(info.a);
+		int rateB = GetStepRate(info.b);
+		bool coarse = !staticA && !staticB && rateA > 1 && rateB > 1;
+
+		//Static pairs never make it out of the broadphase, so don't need checking for here
+		bool colliding = coarse ?
+			CoarseIntersection(info.a, info.b, info) :
+			CollisionDetection::ObjectIntersection(info.a, info.b, info);
+
+		if (coarse) {
+			lodStats.coarseTests++;
+		}
+		if (colliding) {
 			//std::cout << "Collision between " << i->a->GetName() << " and " << i->b->GetName() << std::endl;
 			info.framesLeft = numCollisionFrames;
+			//Anything touching a full rate object needs to keep up with it
+			if (!staticA && !staticB) {
+				if (rateA == 1 && rateB > 1) {
+					lodPromotions.emplace_back(info.b);
+				}
+				else if (rateB == 1 && rateA > 1) {
+					lodPromotions.emplace_back(info.a);
+				}
+			}
 			//Dont resolve collisions if one object is on collectable layer
 			if (!(i->a->GetLayer() & collisionMask) || !(i->b->GetLayer() & collisionMask)) {
 				ImpulseResolveCollision(*info.a, *info.b, info.point);
@@ -333,6 +692,113 @@ void PhysicsSystem::NarrowPhase() {
 	}
 }
 
+/*
+Physics level of detail. Objects close to an observer (the camera, or anything
+registered with AddLODObserver, like the player) are stepped every substep. Those
+further away are only stepped every 2nd or 4th substep, with a correspondingly
+larger timestep, and are tested against each other using just their bounding
+spheres. Which substep a slow object steps on depends on its world ID, so they're
+spread out evenly rather than all landing on the same substep. If a slow object
+touches a full rate one, it's promoted to full rate for a while, so that it
+reacts to whatever hit it properly.
+*/
+void PhysicsSystem::AddLODObserver(GameObject* o) {
+	if (std::find(lodObservers.begin(), lodObservers.end(), o) == lodObservers.end()) {
+		lodObservers.emplace_back(o);
+	}
+}
+
+void PhysicsSystem::RemoveLODObserver(GameObject* o) {
+	lodObservers.erase(std::remove(lodObservers.begin(), lodObservers.end(), o), lodObservers.end());
+}
+
+void PhysicsSystem::UpdateLOD() {
+	lodObserverPositions.clear();
+	if (lodCamera) {
+		lodObserverPositions.emplace_back(lodCamera->GetPosition());
+	}
+	for (GameObject* o : lodObservers) {
+		lodObserverPositions.emplace_back(o->GetTransform().GetPosition());
+	}
+	bool lodActive = useLOD && !lodObserverPositions.empty();
+
+	float halfRateSq	= lodHalfRateDistance * lodHalfRateDistance;
+	float quarterRateSq = lodQuarterRateDistance * lodQuarterRateDistance;
+
+	gameWorld.ParallelOperateOnPhysicsObjects(
+		[&](GameObject* o, PhysicsObject& object) {
+			int promoted = object.GetLODPromotedFrames();
+			if (!lodActive || promoted > 0 || IsStaticObject(o)) {
+				object.SetLODRate(1);
+				object.SetLODPromotedFrames(promoted > 0 ? promoted - 1 : 0);
+				return;
+			}
+			Vector3 pos = o->GetTransform().GetPosition();
+			float closestSq = FLT_MAX;
+			for (const Vector3& observer : lodObserverPositions) {
+				float distSq = (observer - pos).LengthSquared();
+				closestSq = distSq < closestSq ? distSq : closestSq;
+			}
+			object.SetLODRate(closestSq < halfRateSq ? 1 : (closestSq < quarterRateSq ? 2 : 4));
+		}
+	);
+}
+
+void PhysicsSystem::ApplyLODPromotions() {
+	for (GameObject* o : lodPromotions) {
+		PhysicsObject* object = o->GetPhysicsObject();
+		if (object->GetLODRate() != 1) {
+			lodStats.promotions++;
+		}
+		object->SetLODRate(1);
+		object->SetLODPromotedFrames(numCollisionFrames);
+	}
+	lodPromotions.clear();
+}
+
+int PhysicsSystem::GetStepRate(GameObject* o) const {
+	PhysicsObject* object = o->GetPhysicsObject();
+	return object ? object->GetLODRate() : 1;
+}
+
+bool PhysicsSystem::IsSteppingThisSubstep(GameObject* o) const {
+	unsigned int rate = (unsigned int)GetStepRate(o);
+	return rate <= 1 || ((lodSubstep + (unsigned int)o->GetWorldID()) % rate) == 0;
+}
+
+//Far away pairs are only tested using spheres that enclose each object's broadphase box
+bool PhysicsSystem::CoarseIntersection(GameObject* a, GameObject* b, CollisionDetection::CollisionInfo& info) const {
+	Vector3 sizeA;
+	Vector3 sizeB;
+	if (!a->GetBroadphaseAABB(sizeA) || !b->GetBroadphaseAABB(sizeB)) {
+		return false;
+	}
+	SphereVolume sphereA(sizeA.Length());
+	SphereVolume sphereB(sizeB.Length());
+
+	info.a = a;
+	info.b = b;
+	return CollisionDetection::SphereIntersection(sphereA, a->GetTransform(), sphereB, b->GetTransform(), info);
+}
+
+void PhysicsSystem::PrintLODStats() {
+	if (lodStats.updates == 0) {
+		return;
+	}
+	float stepsSaved = lodStats.fullRateSteps > 0 ?
+		100.0f * (1.0f - (float)lodStats.bodySteps / (float)lodStats.fullRateSteps) : 0.0f;
+	int   pairs = lodStats.pairTests + lodStats.pairsSkipped;
+	float pairsSaved = pairs > 0 ? 100.0f * (float)lodStats.pairsSkipped / (float)pairs : 0.0f;
+
+	std::cout << "Physics LOD " << (useLOD ? "on" : "off") << ", over " << lodStats.updates << " updates:" << std::endl;
+	std::cout << "  Average update: " << (lodStats.updateTime * 1000.0f) / lodStats.updates << "ms" << std::endl;
+	std::cout << "  Body steps: " << lodStats.bodySteps << " of " << lodStats.fullRateSteps << " (" << stepsSaved << "% saved)" << std::endl;
+	std::cout << "  Pair tests: " << lodStats.pairTests << ", skipped " << lodStats.pairsSkipped << " (" << pairsSaved << "% saved), "
+		<< lodStats.coarseTests << " coarse" << std::endl;
+	std::cout << "  Promotions: " << lodStats.promotions << std::endl;
+	lodStats = LODStats();
+}
+
 /*
 Integration of acceleration and velocity is split up, so that we can
 move objects multiple times during the course of a PhysicsUpdate,
@@ -342,22 +808,21 @@ This function will update both linear and angular acceleration,
 based on any forces that have been accumulated in the objects during
 the course of the previous game frame.
 */
-void PhysicsSystem::IntegrateAccel(float dt) {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
-
-	for (auto i = first; i != last; i++) {
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr)
-			continue;
+void PhysicsSystem::IntegrateAccel(float baseDt) {
+	//Every object only touches its own state here, so they can all be integrated at once
+	gameWorld.ParallelOperateOnPhysicsObjects([&](GameObject* o, PhysicsObject& body) {
+		PhysicsObject* object = &body;
+		if (object->IsKinematic() || !IsSteppingThisSubstep(o))
+			return;
+		float dt = baseDt * object->GetLODRate(); //Slower objects take bigger steps to catch up
+		float forceScale = 1.0f / object->GetForceUpdates(); //Averages forces built up over updates it skipped
 		float inverseMass = object->GetInverseMass();
 		Vector3 linearVel = object->GetLinearVelocity();
-		Vector3 force = object->GetForce();
+		Vector3 force = object->GetForce() * forceScale;
 		Vector3 accel = force * inverseMass;
 
 		// -- Linear Acceleration -- //
-		if (applyGravity && inverseMass > 0 && !(Layer::AntiGravity & (*i)->GetLayer())) {
+		if (applyGravity && inverseMass > 0 && !(Layer::AntiGravity & o->GetLayer())) {
 			accel += gravity; // dont move infinitely heavy objects
 		}
 
@@ -365,7 +830,7 @@ void PhysicsSystem::IntegrateAccel(float dt) {
 		object->SetLinearVelocity(linearVel);
 
 		// -- Angular Acceleration -- //
-		Vector3 torque = object->GetTorque();
+		Vector3 torque = object->GetTorque() * forceScale;
 		Vector3 angVel = object->GetAngularVelocity();
 
 		object->UpdateInertiaTensor();
@@ -373,7 +838,8 @@ void PhysicsSystem::IntegrateAccel(float dt) {
 
 		angVel += angAccel * dt; //integrate angular acceleration to angular velocity
 		object->SetAngularVelocity(angVel);
-	}
+		object->SetForcesUsed();
+	});
 }
 /*
 This function integrates linear and angular velocity into
@@ -381,17 +847,21 @@ position and orientation. It may be called multiple times
 throughout a physics update, to slowly move the objects through
 the world, looking for collisions.
 */
-void PhysicsSystem::IntegrateVelocity(float dt) {
-	std::vector<GameObject*>::const_iterator first;
-	std::vector<GameObject*>::const_iterator last;
-	gameWorld.GetObjectIterators(first, last);
-
-	float frameLinearDamping = 1.0f - (0.4f * dt);
-	for (auto i = first; i != last; i++) {
-		PhysicsObject* object = (*i)->GetPhysicsObject();
-		if (object == nullptr)
-			continue;
-		Transform& transform = (*i)->GetTransform();
+void PhysicsSystem::IntegrateVelocity(float baseDt) {
+	std::atomic<int> fullRateSteps(0);
+	std::atomic<int> bodySteps(0);
+
+	gameWorld.ParallelOperateOnPhysicsObjects([&](GameObject* o, PhysicsObject& body) {
+		PhysicsObject* object = &body;
+		fullRateSteps++;
+		if (!IsSteppingThisSubstep(o))
+			return;
+		bodySteps++;
+		float dt = baseDt * object->GetLODRate();
+		//Kinematic velocities come from a script, so shouldn't be damped away
+		float frameDamping = object->IsKinematic() ? 1.0f : 1.0f - (0.4f * dt);
+		float frameLinearDamping = frameDamping;
+		Transform& transform = o->GetTransform();
 		Vector3 position = transform.GetPosition();
 		Vector3 linearVel = object->GetLinearVelocity();
 		position += linearVel * dt;
@@ -410,21 +880,30 @@ void PhysicsSystem::IntegrateVelocity(float dt) {
 		transform.SetOrientation(orientation);
 
 		//Dampen the angular velocity
-		float frameAngularDamping = 1.0f - (0.4f * dt);
+		float frameAngularDamping = frameDamping;
 		angVel = angVel * frameAngularDamping;
 		object->SetAngularVelocity(angVel);
-	}
+	});
+	lodStats.fullRateSteps	+= fullRateSteps;
+	lodStats.bodySteps		+= bodySteps;
 }
 
 /*
 Once we're finished with a physics update, we have to
 clear out any accumulated forces, ready to receive new
-ones in the next 'game' frame.
+ones in the next 'game' frame. Objects that didn't step at all this
+update (being far away, or the frame being shorter than a substep) keep
+theirs, and have the next frame's added on top, so none get lost.
 */
 void PhysicsSystem::ClearForces() {
-	gameWorld.OperateOnContents(
-		[](GameObject* o) {
-			o->GetPhysicsObject()->ClearForces();
+	gameWorld.ParallelOperateOnPhysicsObjects(
+		[](GameObject* o, PhysicsObject& object) {
+			if (object.HaveForcesBeenUsed() || object.IsKinematic()) {
+				object.ClearForces();
+			}
+			else {
+				object.AddForceUpdate();
+			}
 		}
 	);
 }
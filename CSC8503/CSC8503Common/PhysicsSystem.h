@@ -1,5 +1,6 @@
 #pragma once
 #include "../CSC8503Common/GameWorld.h"
+#include "PhysicsHistory.h"
 #include <set>
 
 namespace NCL {
@@ -22,11 +23,80 @@ namespace NCL {
 			}
 
 			void SetGravity(const Vector3& g);
+
+			void UseBroadPhase(bool state) {
+				useBroadPhase = state;
+			}
+
+			bool IsUsingBroadPhase() const {
+				return useBroadPhase;
+			}
+
+			void SetConstraintIterationCount(int count) {
+				constraintIterationCount = count > 1 ? count : 1;
+			}
+
+			int GetConstraintIterationCount() const {
+				return constraintIterationCount;
+			}
+
+			//Halves the update rate whenever an update takes too long, and raises it again once there's time
+			void UseAdaptiveTimestep(bool state) {
+				adaptiveTimestep = state;
+			}
+
+			//Call if a static object has been moved or resized, so that
+			//the static broadphase tree is rebuilt on the next update
+			void MarkStaticsDirty() {
+				staticTreeDirty = true;
+			}
+
+			//Keeps the last 'frames' updates around, so the world can be rewound
+			void EnableHistory(int frames, int keyframeInterval = 10);
+			void DisableHistory();
+
+			//Saves are done automatically at the end of every update once history is enabled
+			int  SaveSnapshot();
+			bool RestoreSnapshot(int frameID);
+
+			PhysicsHistory* GetHistory() const {
+				return history;
+			}
+
+			//Objects far away from every observer are simulated at a lower rate. Off by
+			//default, as it changes how distant objects behave
+			void UseLOD(bool state) {
+				useLOD		= state;
+				lodStats	= LODStats();
+			}
+
+			bool IsUsingLOD() const {
+				return useLOD;
+			}
+
+			void PrintLODStats();
+
+			void SetLODDistances(float halfRate, float quarterRate) {
+				lodHalfRateDistance		= halfRate;
+				lodQuarterRateDistance	= quarterRate;
+			}
+
+			void SetLODCamera(const Camera* c) {
+				lodCamera = c;
+			}
+
+			void AddLODObserver(GameObject* o);
+			void RemoveLODObserver(GameObject* o);
 		protected:
 			void BasicCollisionDetection();
 			void BroadPhase();
 			void NarrowPhase();
 
+			bool IsStaticObject(GameObject* o) const;
+			bool IsKinematic(GameObject* o) const;
+			void UpdateStaticTree();
+			void BuildDynamicTree();
+
 			void ClearForces();
 
 			void IntegrateAccel(float dt);
@@ -35,7 +105,18 @@ namespace NCL {
 			void UpdateConstraints(float dt);
 
 			void UpdateCollisionList();
+
+			void AddTriggerCandidate(GameObject* a, GameObject* b);
+			void TriggerPhase();
+			void UpdateTriggerList();
 			void UpdateObjectAABBs();
+			void ForgetObjects(std::vector<GameObject*>& removed);
+
+			void UpdateLOD();
+			void ApplyLODPromotions();
+			bool IsSteppingThisSubstep(GameObject* o) const;
+			int  GetStepRate(GameObject* o) const;
+			bool CoarseIntersection(GameObject* a, GameObject* b, CollisionDetection::CollisionInfo& info) const;
 
 			void ImpulseResolveCollision(GameObject& a , GameObject&b, CollisionDetection::ContactPoint& p) const;
 
@@ -46,9 +127,55 @@ namespace NCL {
 			float	dTOffset;
 			float	globalDamping;
 
+			//Every simulation keeps its own rate, so one struggling world doesn't slow down any others
+			int		constraintIterationCount;
+			int		realHZ;
+			float	realDT;
+			bool	adaptiveTimestep;
+
 			std::set<CollisionDetection::CollisionInfo> allCollisions;
 			std::set<CollisionDetection::CollisionInfo> broadphaseCollisions;
 
+			typedef std::pair<GameObject*, GameObject*> TriggerPair;
+			std::vector<TriggerPair> triggerCandidates;	//Pairs involving a trigger from this substep's broadphase
+			std::vector<TriggerPair> triggerOverlaps;	//Pairs found overlapping during this update
+			std::vector<TriggerPair> activeTriggers;	//Pairs that were overlapping at the end of the last update
+
+			QuadTree<GameObject*>		staticTree;
+			QuadTree<GameObject*>		dynamicTree;
+			std::vector<GameObject*>	staticObjects;
+			std::vector<GameObject*>	dynamicObjects;
+			std::vector<GameObject*>	newStaticObjects;
+			std::vector<GameObject*>	staticOutsiders;	//Statics that don't fit inside the tree
+			std::vector<GameObject*>	treeOutsiders;		//And every object that doesn't, for queries
+			bool						staticTreeDirty;
+			bool						dynamicTreeCurrent;	//Nothing has moved since the dynamic tree was built
+			int							journalConsumer;
+			std::vector<GameObject*>	removedObjects;
+
+			PhysicsHistory* history;
+
+			struct LODStats {
+				int		updates;
+				float	updateTime;
+				int		fullRateSteps;	//Body steps we'd have taken without LOD
+				int		bodySteps;		//Body steps we actually took
+				int		pairTests;
+				int		pairsSkipped;
+				int		coarseTests;
+				int		promotions;
+			};
+
+			bool						useLOD;
+			float						lodHalfRateDistance;
+			float						lodQuarterRateDistance;
+			const Camera*				lodCamera;
+			std::vector<GameObject*>	lodObservers;
+			std::vector<Vector3>		lodObserverPositions;
+			std::vector<GameObject*>	lodPromotions;
+			unsigned int				lodSubstep;
+			LODStats					lodStats;
+
 			bool useBroadPhase;
 			int numCollisionFrames	= 5;
 		};
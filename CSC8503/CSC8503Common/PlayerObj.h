@@ -7,18 +7,22 @@ namespace NCL {
 		public:
 			PlayerObj(std::string name = "Player") : GameObject(name) {
 				layer = Layer::Player;
+				AddCollisionFilter("Coin"_sid);
+				AddCollisionFilter("Goal"_sid);
+				AddCollisionFilter("Enemy"_sid);
 			};
 
 			virtual void OnCollisionBegin(GameObject* otherObject) override {
-				if (otherObject->GetName() == "Coin") {
+				StringID otherName = otherObject->GetName();
+				if (otherName == "Coin"_sid) {
 					score += 10;
 				}
 
-				if (otherObject->GetName() == "Goal") {
+				if (otherName == "Goal"_sid) {
 					won = true;
 				}
 
-				if (otherObject->GetName() == "Enemy") {
+				if (otherName == "Enemy"_sid) {
 					lost = true;
 				}
 			}
@@ -21,8 +21,8 @@ void PositionConstraint::UpdateConstraint(float dt) {
 
 		Vector3 relativeVelocity = physA->GetLinearVelocity() -
 			physB->GetLinearVelocity();
-		float constraintMass = physA->GetInverseMass() +
-			physB->GetInverseMass();
+		float constraintMass = physA->GetSolverInverseMass() +
+			physB->GetSolverInverseMass();
 
 		if (constraintMass > 0.0f) {
 			//How much of their relative force is affecting the constraint
@@ -14,6 +14,18 @@ namespace NCL {
 			~PositionConstraint() {};
 
 			void UpdateConstraint(float dt) override;
+
+			GameObject* GetObjectA() const {
+				return objectA;
+			}
+
+			GameObject* GetObjectB() const {
+				return objectB;
+			}
+
+			float GetDistance() const {
+				return distance;
+			}
 		protected:
 			GameObject* objectA;
 			GameObject* objectB;
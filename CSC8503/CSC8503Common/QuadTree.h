@@ -24,6 +24,80 @@ namespace NCL {
 			}
 		};
 
+		//A small bundle of rays, stored as a structure of arrays so that a batch
+		//of rays can walk the tree together, sharing the cost of each node visit.
+		//Each lane's box test is independent, so the compiler is free to vectorise it
+		struct QuadTreeRayPacket {
+			static const int MAX_RAYS = 8;
+
+			float posX[MAX_RAYS];
+			float posY[MAX_RAYS];
+			float posZ[MAX_RAYS];
+
+			float invDirX[MAX_RAYS];
+			float invDirY[MAX_RAYS];
+			float invDirZ[MAX_RAYS];
+
+			float maxT[MAX_RAYS];	//Closest hit so far, anything further away is culled
+
+			int				count;
+			unsigned int	finishedMask;	//Rays that no longer need to visit anything
+
+			QuadTreeRayPacket() {
+				for (int i = 0; i < MAX_RAYS; ++i) {
+					posX[i]		= posY[i]	 = posZ[i]	  = 0.0f;
+					invDirX[i]	= invDirY[i] = invDirZ[i] = 0.0f;
+					maxT[i]		= FLT_MAX;
+				}
+				count			= 0;
+				finishedMask	= ~0u;
+			}
+
+			void AddRay(const Vector3& pos, const Vector3& dir, float maxDistance = FLT_MAX) {
+				posX[count] = pos.x;
+				posY[count] = pos.y;
+				posZ[count] = pos.z;
+
+				invDirX[count] = SafeInverse(dir.x);
+				invDirY[count] = SafeInverse(dir.y);
+				invDirZ[count] = SafeInverse(dir.z);
+
+				maxT[count] = maxDistance;
+				finishedMask &= ~(1u << count);
+				count++;
+			}
+
+			//Slab test of every ray in the packet against an axis aligned box
+			unsigned int TestBox(const Vector3& boxMin, const Vector3& boxMax, unsigned int activeMask) const {
+				unsigned int hitMask = 0;
+				for (int i = 0; i < MAX_RAYS; ++i) {
+					float tx1 = (boxMin.x - posX[i]) * invDirX[i];
+					float tx2 = (boxMax.x - posX[i]) * invDirX[i];
+					float ty1 = (boxMin.y - posY[i]) * invDirY[i];
+					float ty2 = (boxMax.y - posY[i]) * invDirY[i];
+					float tz1 = (boxMin.z - posZ[i]) * invDirZ[i];
+					float tz2 = (boxMax.z - posZ[i]) * invDirZ[i];
+
+					float tNear = Max(Max(Min(tx1, tx2), Min(ty1, ty2)), Min(tz1, tz2));
+					float tFar	= Min(Min(Max(tx1, tx2), Max(ty1, ty2)), Max(tz1, tz2));
+
+					hitMask |= (unsigned int)(tFar >= Max(tNear, 0.0f) && tNear <= maxT[i]) << i;
+				}
+				return hitMask & activeMask & ~finishedMask;
+			}
+
+		protected:
+			static float SafeInverse(float f) {
+				return f == 0.0f ? 1e30f : 1.0f / f;
+			}
+			static float Min(float a, float b) {
+				return a < b ? a : b;
+			}
+			static float Max(float a, float b) {
+				return a > b ? a : b;
+			}
+		};
+
 		template<class T>
 		class QuadTreeNode	{
 		public:
@@ -100,6 +174,68 @@ namespace NCL {
 				}
 			}
 
+			//Only visits the leaves that overlap the given box, so a single
+			//object can be tested against a tree without walking all of it
+			void OperateOnContents(const Vector3& objectPos, const Vector3& objectSize, QuadTreeFunc& func) {
+				if (!CollisionDetection::AABBTest(objectPos, Vector3(position.x, 0, position.y), objectSize, Vector3(size.x, 1000.0f, size.y))) {
+					return;
+				}
+				if (children) {
+					for (int i = 0; i < 4; i++) {
+						children[i].OperateOnContents(objectPos, objectSize, func);
+					}
+				}
+				else {
+					if (!contents.empty()) {
+						func(contents);
+					}
+				}
+			}
+
+			//Same as the box version of OperateOnContents, but takes any callable
+			//directly, so queries don't need to wrap themselves in a std::function
+			template<class F>
+			void VisitOverlapping(const Vector3& objectPos, const Vector3& objectSize, F& func) const {
+				if (!CollisionDetection::AABBTest(objectPos, Vector3(position.x, 0, position.y), objectSize, Vector3(size.x, 1000.0f, size.y))) {
+					return;
+				}
+				if (children) {
+					for (int i = 0; i < 4; i++) {
+						children[i].VisitOverlapping(objectPos, objectSize, func);
+					}
+				}
+				else {
+					for (const auto& entry : contents) {
+						func(entry);
+					}
+				}
+			}
+
+			template<class F>
+			void RayPacketCast(QuadTreeRayPacket& packet, unsigned int activeMask, F& func) const {
+				activeMask = packet.TestBox(Vector3(position.x - size.x, -1000.0f, position.y - size.y),
+											Vector3(position.x + size.x,  1000.0f, position.y + size.y), activeMask);
+				if (!activeMask) {
+					return;
+				}
+				if (children) {
+					for (int i = 0; i < 4; i++) {
+						children[i].RayPacketCast(packet, activeMask, func);
+					}
+				}
+				else {
+					if (!contents.empty()) {
+						func(contents, activeMask);
+					}
+				}
+			}
+
+			void Clear() {
+				delete[] children;
+				children = nullptr;
+				contents.clear();
+			}
+
 		protected:
 			std::list< QuadTreeEntry<T> >	contents;
 
@@ -131,6 +267,14 @@ namespace NCL {
 				root.Insert(object, pos, size, maxDepth, maxSize);
 			}
 
+			//Anything poking out past the edges of the tree can't be found by searching it
+			bool Contains(const Vector3& pos, const Vector3& size) const {
+				Vector3 delta = pos - Vector3(root.position.x, 0, root.position.y);
+				return	abs(delta.x) + size.x <= root.size.x &&
+						abs(delta.y) + size.y <= 1000.0f &&
+						abs(delta.z) + size.z <= root.size.y;
+			}
+
 			void DebugDraw() {
 				root.DebugDraw();
 			}
@@ -139,6 +283,26 @@ namespace NCL {
 				root.OperateOnContents(func);
 			}
 
+			void OperateOnContents(const Vector3& pos, const Vector3& size, typename QuadTreeNode<T>::QuadTreeFunc func) {
+				root.OperateOnContents(pos, size, func);
+			}
+
+			//func is called with every entry in each leaf that overlaps the box
+			template<class F>
+			void VisitOverlapping(const Vector3& pos, const Vector3& size, F func) const {
+				root.VisitOverlapping(pos, size, func);
+			}
+
+			//func is called with each leaf's contents, and a mask of which rays in the packet reached it
+			template<class F>
+			void RayPacketCast(QuadTreeRayPacket& packet, F func) const {
+				root.RayPacketCast(packet, ~0u, func);
+			}
+
+			void Clear() {
+				root.Clear();
+			}
+
 		protected:
 			QuadTreeNode<T> root;
 			int maxDepth;
@@ -26,6 +26,10 @@ namespace NCL {
 				return texture;
 			}
 
+			void SetMesh(MeshGeometry* m) {
+				mesh = m;
+			}
+
 			MeshGeometry*	GetMesh() const {
 				return mesh;
 			}
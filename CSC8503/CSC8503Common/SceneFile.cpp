@@ -0,0 +1,456 @@
+#include "SceneFile.h"
+#include "GameWorld.h"
+#include "GameObject.h"
+#include "Constraint.h"
+#include "Spring.h"
+#include "PositionConstraint.h"
+#include "AABBVolume.h"
+#include "OBBVolume.h"
+#include "SphereVolume.h"
+#include "CapsuleVolume.h"
+#include "HeightfieldVolume.h"
+
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	const char SCENE_MAGIC[4] = { 'S', 'C', 'N', 'E' };
+
+	//A rough guess at how much arena each object takes, volume included, so the
+	//whole level can be reserved in one go before anything is made
+	const size_t ARENA_BYTES_PER_OBJECT = 512;
+
+	/*
+	Gives read only access to a whole file. On Windows the file is mapped
+	straight into memory, so nothing is copied until it's actually touched,
+	and pages are shared with the OS file cache. Anywhere else, it's just
+	read into a buffer in one go.
+	*/
+	class MappedFile	{
+	public:
+		MappedFile(const std::string& filename) {
+			data = nullptr;
+			size = 0;
+#ifdef _WIN32
+			file	= CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			mapping = nullptr;
+			if (file == INVALID_HANDLE_VALUE) {
+				return;
+			}
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+				return;
+			}
+			mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mapping) {
+				return;
+			}
+			data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			size = data ? (size_t)fileSize.QuadPart : 0;
+#else
+			std::ifstream infile(filename, std::ios::binary | std::ios::ate);
+			if (!infile) {
+				return;
+			}
+			buffer.resize((size_t)infile.tellg());
+			infile.seekg(0);
+			if (!buffer.empty() && infile.read(buffer.data(), buffer.size())) {
+				data = buffer.data();
+				size = buffer.size();
+			}
+#endif
+		}
+
+		~MappedFile() {
+#ifdef _WIN32
+			if (data) {
+				UnmapViewOfFile(data);
+			}
+			if (mapping) {
+				CloseHandle(mapping);
+			}
+			if (file != INVALID_HANDLE_VALUE) {
+				CloseHandle(file);
+			}
+#endif
+		}
+
+		const char* GetData() const {
+			return data;
+		}
+
+		size_t GetSize() const {
+			return size;
+		}
+
+	protected:
+		const char* data;
+		size_t		size;
+#ifdef _WIN32
+		HANDLE		file;
+		HANDLE		mapping;
+#else
+		std::vector<char> buffer;
+#endif
+	};
+
+	void WriteVolume(const CollisionVolume* volume, SceneObjectRecord& r, std::vector<float>& heights) {
+		r.volumeType = volume ? (unsigned int)volume->type : 0;
+		if (!volume) {
+			return;
+		}
+		Vector3 size;
+		switch (volume->type) {
+			case VolumeType::AABB:		size = ((const AABBVolume&)*volume).GetHalfDimensions(); break;
+			case VolumeType::OBB:		size = ((const OBBVolume&)*volume).GetHalfDimensions(); break;
+			case VolumeType::Sphere:	size.x = ((const SphereVolume&)*volume).GetRadius(); break;
+			case VolumeType::Capsule: {
+				const CapsuleVolume& capsule = (const CapsuleVolume&)*volume;
+				size = Vector3(capsule.GetRadius(), capsule.GetHalfHeight(), 0);
+			}break;
+			case VolumeType::Heightfield: {
+				const HeightfieldVolume& field = (const HeightfieldVolume&)*volume;
+				size.x			= field.GetCellSize();
+				r.samplesX		= field.GetSamplesX();
+				r.samplesZ		= field.GetSamplesZ();
+				r.heightsOffset = (unsigned int)heights.size();
+				for (int z = 0; z < r.samplesZ; ++z) {
+					for (int x = 0; x < r.samplesX; ++x) {
+						heights.emplace_back(field.GetHeight(x, z));
+					}
+				}
+			}break;
+			default: {
+				std::cout << __FUNCTION__ << ": can't save volume type " << (int)volume->type << ", skipping it" << std::endl;
+				r.volumeType = 0;
+			}break;
+		}
+		r.volumeSize[0] = size.x;
+		r.volumeSize[1] = size.y;
+		r.volumeSize[2] = size.z;
+	}
+
+	CollisionVolume* ReadVolume(const SceneObjectRecord& r, const float* heights, unsigned int heightCount) {
+		Vector3 size(r.volumeSize[0], r.volumeSize[1], r.volumeSize[2]);
+		switch ((VolumeType)r.volumeType) {
+			case VolumeType::AABB:		return (CollisionVolume*)new AABBVolume(size);
+			case VolumeType::OBB:		return (CollisionVolume*)new OBBVolume(size);
+			case VolumeType::Sphere:	return (CollisionVolume*)new SphereVolume(size.x);
+			case VolumeType::Capsule:	return (CollisionVolume*)new CapsuleVolume(size.y, size.x);
+			case VolumeType::Heightfield: {
+				size_t count = (size_t)r.samplesX * (size_t)r.samplesZ;
+				if (r.samplesX < 0 || r.samplesZ < 0 || (size_t)r.heightsOffset + count > heightCount) {
+					return nullptr;
+				}
+				std::vector<float> samples(heights + r.heightsOffset, heights + r.heightsOffset + count);
+				return (CollisionVolume*)new HeightfieldVolume(r.samplesX, r.samplesZ, size.x, samples);
+			}
+			default: return nullptr;
+		}
+	}
+}
+
+bool SceneFile::Save(const std::string& filename, GameWorld& world, SceneContext& context, const GameObjectFilter& filter) {
+	GameObjectIterator first;
+	GameObjectIterator last;
+	world.GetObjectIterators(first, last);
+
+	std::vector<SceneObjectRecord>		objects;
+	std::vector<SceneConstraintRecord>	constraints;
+	std::vector<float>					heights;
+	std::vector<char>					strings;
+	std::unordered_map<GameObject*, unsigned int> objectIndices;
+
+	for (auto i = first; i != last; ++i) {
+		GameObject* o = *i;
+		if (filter && !filter(o)) {
+			continue;
+		}
+		SceneObjectRecord r;
+		memset(&r, 0, sizeof(SceneObjectRecord));
+
+		r.type			= context.GetObjectType(o);
+		r.nameOffset	= (unsigned int)strings.size();
+		const std::string& name = o->GetName().GetString();
+		strings.insert(strings.end(), name.begin(), name.end());
+		strings.emplace_back('\0');
+
+		r.layer = o->GetLayer();
+		r.flags = (o->IsActive() ? SceneObjectActive : 0) | (o->IsTrigger() ? SceneObjectTrigger : 0);
+
+		Transform& t		= o->GetTransform();
+		Vector3 position	= t.GetPosition();
+		Quaternion rotation = t.GetOrientation();
+		Vector3 scale		= t.GetScale();
+		for (int j = 0; j < 3; ++j) {
+			r.position[j]	= position[j];
+			r.scale[j]		= scale[j];
+		}
+		r.orientation[0] = rotation.x;
+		r.orientation[1] = rotation.y;
+		r.orientation[2] = rotation.z;
+		r.orientation[3] = rotation.w;
+
+		WriteVolume(o->GetBoundingVolume(), r, heights);
+
+		if (PhysicsObject* p = o->GetPhysicsObject()) {
+			r.flags			|= SceneObjectHasPhysics | (p->IsKinematic() ? SceneObjectKinematic : 0);
+			r.inverseMass	= p->GetInverseMass();
+			r.elasticity	= p->GetElasticity();
+			r.friction		= p->GetFriction();
+			Vector3 inertia = p->GetInverseInertia();
+			for (int j = 0; j < 3; ++j) {
+				r.inverseInertia[j] = inertia[j];
+			}
+		}
+
+		r.meshID	= SCENE_NO_ASSET;
+		r.textureID = SCENE_NO_ASSET;
+		r.shaderID	= SCENE_NO_ASSET;
+		if (RenderObject* ro = o->GetRenderObject()) {
+			r.flags		|= SceneObjectHasRender;
+			r.meshID	= context.GetMeshID(ro->GetMesh());
+			r.textureID = context.GetTextureID(ro->GetDefaultTexture());
+			r.shaderID	= context.GetShaderID(ro->GetShader());
+			Vector4 colour = ro->GetColour();
+			for (int j = 0; j < 4; ++j) {
+				r.colour[j] = colour[j];
+			}
+		}
+		objectIndices[o] = (unsigned int)objects.size();
+		objects.emplace_back(r);
+	}
+
+	std::vector<Constraint*>::const_iterator firstC;
+	std::vector<Constraint*>::const_iterator lastC;
+	world.GetConstraintIterators(firstC, lastC);
+
+	for (auto i = firstC; i != lastC; ++i) {
+		SceneConstraintRecord r;
+		memset(&r, 0, sizeof(SceneConstraintRecord));
+		GameObject* a = nullptr;
+		GameObject* b = nullptr;
+
+		if (Spring* s = dynamic_cast<Spring*>(*i)) {
+			r.type		= SceneSpring;
+			a			= s->GetObjectA();
+			b			= s->GetObjectB();
+			r.params[0] = s->GetRestingLength();
+			r.params[1] = s->GetStiffness();
+			r.params[2] = s->IsCoiled() ? 1.0f : 0.0f;
+		}
+		else if (PositionConstraint* p = dynamic_cast<PositionConstraint*>(*i)) {
+			r.type		= ScenePositionConstraint;
+			a			= p->GetObjectA();
+			b			= p->GetObjectB();
+			r.params[0] = p->GetDistance();
+		}
+		auto indexA = objectIndices.find(a);
+		auto indexB = objectIndices.find(b);
+		if (r.type != 0 && indexA == objectIndices.end() && indexB == objectIndices.end()) {
+			continue;	//Filtered out along with both of its objects
+		}
+		if (r.type == 0 || indexA == objectIndices.end() || indexB == objectIndices.end()) {
+			std::cout << __FUNCTION__ << ": can't save a constraint, skipping it" << std::endl;
+			continue;
+		}
+		r.objectA = indexA->second;
+		r.objectB = indexB->second;
+		constraints.emplace_back(r);
+	}
+
+	SceneHeader header;
+	memset(&header, 0, sizeof(SceneHeader));
+	memcpy(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC));
+	header.version			= SCENE_FILE_VERSION;
+	header.objectCount		= (unsigned int)objects.size();
+	header.constraintCount	= (unsigned int)constraints.size();
+	header.heightCount		= (unsigned int)heights.size();
+	header.stringBytes		= (unsigned int)strings.size();
+	context.WriteUserData(header.userData);
+
+	std::ofstream outfile(filename, std::ios::binary);
+	if (!outfile) {
+		std::cout << __FUNCTION__ << ": couldn't open " << filename << " for writing!" << std::endl;
+		return false;
+	}
+	outfile.write((const char*)&header, sizeof(SceneHeader));
+	outfile.write((const char*)objects.data(), objects.size() * sizeof(SceneObjectRecord));
+	outfile.write((const char*)constraints.data(), constraints.size() * sizeof(SceneConstraintRecord));
+	outfile.write((const char*)heights.data(), heights.size() * sizeof(float));
+	outfile.write(strings.data(), strings.size());
+	return (bool)outfile;
+}
+
+bool SceneFile::Load(const std::string& filename, GameWorld& world, SceneContext& context) {
+	ArenaScope		levelScope(world.GetLevelArena());
+	ComponentScope	componentScope(world.GetComponents());
+
+	SceneContents contents;
+	if (!Read(filename, context, contents)) {
+		std::cout << __FUNCTION__ << ": couldn't load " << filename << std::endl;
+		return false;
+	}
+	context.ReadUserData(contents.userData);
+
+	world.ReserveObjects(contents.objects.size());
+	for (size_t i = 0; i < contents.objects.size(); ++i) {
+		AddObject(contents, i, world, context);
+	}
+	for (size_t i = 0; i < contents.constraints.size(); ++i) {
+		AddConstraint(contents, i, world, context);
+	}
+	return true;
+}
+
+/*
+Everything the scene needs is made room for up front - arena memory if there's
+an ArenaScope open on this thread, and space in whichever component stores its
+ComponentScope picks - so the loop that creates the objects never has to stop
+and grow anything part way through.
+*/
+bool SceneFile::Read(const std::string& filename, SceneContext& context, SceneContents& contents) {
+	MappedFile file(filename);
+	if (!file.GetData()) {
+		return false;
+	}
+	if (file.GetSize() < sizeof(SceneHeader)) {
+		std::cout << __FUNCTION__ << ": " << filename << " is truncated!" << std::endl;
+		return false;
+	}
+	const char*			data	= file.GetData();
+	const SceneHeader&	header	= *(const SceneHeader*)data;
+
+	if (memcmp(header.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC)) != 0 || header.version != SCENE_FILE_VERSION) {
+		std::cout << __FUNCTION__ << ": " << filename << " isn't a version " << SCENE_FILE_VERSION << " scene file!" << std::endl;
+		return false;
+	}
+	size_t objectBytes		= (size_t)header.objectCount * sizeof(SceneObjectRecord);
+	size_t constraintBytes	= (size_t)header.constraintCount * sizeof(SceneConstraintRecord);
+	size_t heightBytes		= (size_t)header.heightCount * sizeof(float);
+	if (file.GetSize() < sizeof(SceneHeader) + objectBytes + constraintBytes + heightBytes + header.stringBytes) {
+		std::cout << __FUNCTION__ << ": " << filename << " is truncated!" << std::endl;
+		return false;
+	}
+	const SceneObjectRecord*		objects		= (const SceneObjectRecord*)(data + sizeof(SceneHeader));
+	const SceneConstraintRecord*	constraints = (const SceneConstraintRecord*)((const char*)objects + objectBytes);
+	const float*					heights		= (const float*)((const char*)constraints + constraintBytes);
+	const char*						strings		= (const char*)heights + heightBytes;
+
+	memcpy(contents.userData, header.userData, sizeof(header.userData));
+
+	if (LevelArena* arena = ArenaScope::GetCurrentArena()) {
+		arena->Reserve(header.objectCount * ARENA_BYTES_PER_OBJECT);
+	}
+	ComponentStores& stores = ComponentStores::GetCurrent();
+	stores.GetTransforms().Reserve(header.objectCount);
+	stores.GetPhysicsObjects().Reserve(header.objectCount);
+	stores.GetRenderObjects().Reserve(header.objectCount);
+
+	size_t firstObject = contents.objects.size();
+	contents.objects.reserve(firstObject + header.objectCount);
+	contents.types.reserve(firstObject + header.objectCount);
+	contents.generatedMesh.reserve(firstObject + header.objectCount);
+
+	for (unsigned int i = 0; i < header.objectCount; ++i) {
+		const SceneObjectRecord& r = objects[i];
+		std::string name = r.nameOffset < header.stringBytes ?
+			std::string(strings + r.nameOffset, strnlen(strings + r.nameOffset, header.stringBytes - r.nameOffset)) : "";
+
+		GameObject* o = context.CreateObject(r.type, name);
+		contents.objects.emplace_back(o);
+		contents.types.emplace_back(r.type);
+		contents.generatedMesh.emplace_back(o && (r.flags & SceneObjectHasRender) && r.meshID == SCENE_GENERATED_MESH);
+		if (!o) {
+			continue;
+		}
+		o->SetLayer(r.layer);
+		o->SetTrigger((r.flags & SceneObjectTrigger) != 0);
+		o->GetTransform()
+			.SetPosition(Vector3(r.position[0], r.position[1], r.position[2]))
+			.SetOrientation(Quaternion(r.orientation[0], r.orientation[1], r.orientation[2], r.orientation[3]))
+			.SetScale(Vector3(r.scale[0], r.scale[1], r.scale[2]));
+
+		if (r.volumeType != 0) {
+			o->SetBoundingVolume(ReadVolume(r, heights, header.heightCount));
+		}
+		if (r.flags & SceneObjectHasRender) {
+			//Generated meshes are made by AddObject, as they might need the render thread
+			MeshGeometry* mesh = r.meshID == SCENE_GENERATED_MESH ? nullptr : context.GetMesh(r.meshID);
+			o->AddRenderObject(mesh, context.GetTexture(r.textureID), context.GetShader(r.shaderID));
+			o->GetRenderObject()->SetColour(Vector4(r.colour[0], r.colour[1], r.colour[2], r.colour[3]));
+		}
+		if (r.flags & SceneObjectHasPhysics) {
+			PhysicsObject* p = o->AddPhysicsObject();
+			p->SetInverseMass(r.inverseMass);
+			p->SetElasticity(r.elasticity);
+			p->SetFriction(r.friction);
+			p->SetInverseInertia(Vector3(r.inverseInertia[0], r.inverseInertia[1], r.inverseInertia[2]));
+			p->SetKinematic((r.flags & SceneObjectKinematic) != 0);
+		}
+		if (!(r.flags & SceneObjectActive)) {
+			o->SetActive(false);
+		}
+	}
+
+	for (unsigned int i = 0; i < header.constraintCount; ++i) {
+		const SceneConstraintRecord& r = constraints[i];
+		GameObject* a = r.objectA < header.objectCount ? contents.objects[firstObject + r.objectA] : nullptr;
+		GameObject* b = r.objectB < header.objectCount ? contents.objects[firstObject + r.objectB] : nullptr;
+		if (!a || !b) {
+			continue;
+		}
+		switch (r.type) {
+			case ScenePositionConstraint:	contents.constraints.emplace_back(new PositionConstraint(a, b, r.params[0])); break;
+			case SceneSpring:				contents.constraints.emplace_back(new Spring(a, b, r.params[0], r.params[1], r.params[2] != 0.0f)); break;
+			default:						continue;
+		}
+		contents.constraintObjects.emplace_back(firstObject + r.objectA, firstObject + r.objectB);
+	}
+	return true;
+}
+
+void SceneFile::AddObject(SceneContents& contents, size_t index, GameWorld& world, SceneContext& context) {
+	GameObject* o = contents.objects[index];
+	if (!o) {
+		return;
+	}
+	if (contents.generatedMesh[index]) {
+		o->GetRenderObject()->SetMesh(context.CreateGeneratedMesh(o));
+		contents.generatedMesh[index] = false;
+	}
+	world.AddGameObject(o);
+	context.ObjectLoaded(o, contents.types[index]);
+}
+
+void SceneFile::AddConstraint(SceneContents& contents, size_t index, GameWorld& world, SceneContext& context) {
+	Constraint* c = contents.constraints[index];
+	world.AddConstraint(c);
+	context.ConstraintLoaded(c);
+}
+
+void SceneFile::Discard(SceneContents& contents, size_t firstObject, size_t firstConstraint) {
+	for (size_t i = firstConstraint; i < contents.constraints.size(); ++i) {
+		delete contents.constraints[i];
+	}
+	for (size_t i = firstObject; i < contents.objects.size(); ++i) {
+		delete contents.objects[i];
+	}
+	contents.constraints.resize(firstConstraint < contents.constraints.size() ? firstConstraint : contents.constraints.size());
+	contents.constraintObjects.resize(contents.constraints.size());
+	contents.objects.resize(firstObject < contents.objects.size() ? firstObject : contents.objects.size());
+	contents.types.resize(contents.objects.size());
+	contents.generatedMesh.resize(contents.objects.size());
+}
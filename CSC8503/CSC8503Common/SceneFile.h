@@ -0,0 +1,168 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <utility>
+
+namespace NCL {
+	class MeshGeometry;
+	namespace Rendering {
+		class TextureBase;
+		class ShaderBase;
+	}
+	using namespace NCL::Rendering;
+
+	namespace CSC8503 {
+		class GameWorld;
+		class GameObject;
+		class Constraint;
+
+		const unsigned int SCENE_FILE_VERSION = 1;
+
+		//Asset IDs are whatever the game's SceneContext says they are, apart from these two
+		const int SCENE_NO_ASSET		= -1;
+		const int SCENE_GENERATED_MESH	= -2;	//Built from the object's own volume when loaded, like terrain
+
+		enum SceneObjectFlags {
+			SceneObjectActive		= 1,
+			SceneObjectTrigger		= 2,
+			SceneObjectHasPhysics	= 4,
+			SceneObjectKinematic	= 8,
+			SceneObjectHasRender	= 16
+		};
+
+		enum SceneConstraintType {
+			ScenePositionConstraint = 1,
+			SceneSpring				= 2
+		};
+
+		/*
+		Everything in a scene file is one of these plain structs, written out
+		exactly as it is in memory, so loading never has to parse anything - the
+		file is mapped into memory, and the records are read straight out of it.
+		A file is laid out as:
+
+			SceneHeader
+			SceneObjectRecord		[objectCount]
+			SceneConstraintRecord	[constraintCount]
+			float					[heightCount]	(every heightfield's samples)
+			char					[stringBytes]	(every object's name, null terminated)
+		*/
+		struct SceneHeader {
+			char			magic[4];
+			unsigned int	version;
+			unsigned int	objectCount;
+			unsigned int	constraintCount;
+			unsigned int	heightCount;
+			unsigned int	stringBytes;
+			int				userData[8];	//Left for the game to store its own level settings in
+		};
+
+		struct SceneObjectRecord {
+			unsigned int	type;			//What the game's SceneContext should create
+			unsigned int	nameOffset;		//Into the string table
+			int				layer;
+			unsigned int	flags;
+
+			float			position[3];
+			float			orientation[4];
+			float			scale[3];
+
+			unsigned int	volumeType;		//A VolumeType, or 0 for no volume
+			float			volumeSize[3];	//Half sizes, or radius (and half height for capsules)
+			int				samplesX;		//Heightfields only
+			int				samplesZ;
+			unsigned int	heightsOffset;	//Into the height table
+
+			float			inverseMass;
+			float			elasticity;
+			float			friction;
+			float			inverseInertia[3];
+
+			int				meshID;
+			int				textureID;
+			int				shaderID;
+			float			colour[4];
+		};
+
+		struct SceneConstraintRecord {
+			unsigned int	type;			//A SceneConstraintType
+			unsigned int	objectA;		//Indices into the object records
+			unsigned int	objectB;
+			float			params[3];		//Distance, or resting length, stiffness and coiled
+		};
+
+		/*
+		The scene file only knows about the engine's own classes, so the game
+		fills in the rest: what type of object something is, which of its meshes,
+		textures and shaders an ID refers to, and what to do with each object and
+		constraint once it has been loaded (like keeping hold of the player).
+
+		When a scene is streamed in, CreateObject and the asset lookups are called
+		from a loading thread, so they mustn't touch anything else in the game.
+		Everything else is only ever called from the thread that owns the world.
+		*/
+		class SceneContext	{
+		public:
+			virtual ~SceneContext() {}
+
+			//Used when saving
+			virtual unsigned int	GetObjectType(GameObject* o) = 0;
+			virtual int				GetMeshID(const MeshGeometry* m) = 0;
+			virtual int				GetTextureID(const TextureBase* t) = 0;
+			virtual int				GetShaderID(const ShaderBase* s) = 0;
+			virtual void			WriteUserData(int* userData) {}
+
+			//Used when loading
+			virtual GameObject*		CreateObject(unsigned int type, const std::string& name) = 0;
+			virtual MeshGeometry*	GetMesh(int id) = 0;
+			virtual TextureBase*	GetTexture(int id) = 0;
+			virtual ShaderBase*		GetShader(int id) = 0;
+			virtual MeshGeometry*	CreateGeneratedMesh(GameObject* o) {
+				return nullptr;
+			}
+			virtual void			ReadUserData(const int* userData) {}
+
+			virtual void			ObjectLoaded(GameObject* o, unsigned int type) {}
+			virtual void			ConstraintLoaded(Constraint* c) {}
+
+			//Called just before streamed objects and constraints are removed and deleted
+			virtual void			ObjectUnloading(GameObject* o) {}
+			virtual void			ConstraintUnloading(Constraint* c) {}
+		};
+
+		typedef std::function<bool(GameObject*)> GameObjectFilter;
+
+		//Everything read from a scene file, made but not yet added to any world
+		struct SceneContents {
+			std::vector<GameObject*>	objects;		//nullptr wherever the context didn't make anything
+			std::vector<unsigned int>	types;
+			std::vector<bool>			generatedMesh;	//Which objects still need CreateGeneratedMesh calling
+			std::vector<Constraint*>	constraints;
+			std::vector<std::pair<size_t, size_t>> constraintObjects;	//Which two objects each constraint joins
+			int							userData[8];
+		};
+
+		class SceneFile	{
+		public:
+			//Writes out every object in the world that passes the filter, if there is one,
+			//along with every constraint between them
+			static bool Save(const std::string& filename, GameWorld& world, SceneContext& context, const GameObjectFilter& filter = nullptr);
+
+			//Adds everything in the file to the world, in the order it was saved in.
+			//Everything made is allocated from the world's level arena
+			static bool Load(const std::string& filename, GameWorld& world, SceneContext& context);
+
+			//Makes everything in the file, without touching any world, so can be used off
+			//the main thread. Returns false without saying anything if the file isn't there
+			static bool Read(const std::string& filename, SceneContext& context, SceneContents& contents);
+
+			//Moves one object or constraint from Read's results into the world
+			static void AddObject(SceneContents& contents, size_t index, GameWorld& world, SceneContext& context);
+			static void AddConstraint(SceneContents& contents, size_t index, GameWorld& world, SceneContext& context);
+
+			//Deletes everything from the given indices onwards, for contents that won't be added after all
+			static void Discard(SceneContents& contents, size_t firstObject = 0, size_t firstConstraint = 0);
+		};
+	}
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <random>
+
+namespace NCL {
+	namespace CSC8503 {
+		/*
+		A handle to something stored in a SlotMap. Every time a slot is reused,
+		its generation goes up, so a handle to something that's been removed can
+		never accidentally find whatever took its place. Generations start at 1,
+		so a default constructed handle never points at anything.
+		*/
+		struct SlotHandle {
+			unsigned int index;
+			unsigned int generation;
+
+			SlotHandle() {
+				index		= 0;
+				generation	= 0;
+			}
+
+			SlotHandle(unsigned int index, unsigned int generation) {
+				this->index			= index;
+				this->generation	= generation;
+			}
+
+			bool IsNull() const {
+				return generation == 0;
+			}
+
+			bool operator==(const SlotHandle& other) const {
+				return index == other.index && generation == other.generation;
+			}
+
+			bool operator!=(const SlotHandle& other) const {
+				return !(*this == other);
+			}
+		};
+
+		/*
+		Stores values in one tightly packed array, so iterating over them is just
+		walking a vector, while still giving O(1) insert, remove and lookup by handle.
+		Removing a value moves the last value into its place, so the order values
+		are iterated in can change whenever something is removed.
+		*/
+		template<class T>
+		class SlotMap	{
+		public:
+			typedef typename std::vector<T>::iterator		iterator;
+			typedef typename std::vector<T>::const_iterator	const_iterator;
+
+			SlotMap() {
+				freeHead = NO_SLOT;
+			}
+
+			SlotHandle Insert(const T& value) {
+				unsigned int slotIndex;
+				if (freeHead != NO_SLOT) {
+					slotIndex	= freeHead;
+					freeHead	= slots[slotIndex].nextFree;
+				}
+				else {
+					slotIndex = (unsigned int)slots.size();
+					slots.push_back(Slot());
+				}
+				Slot& slot		= slots[slotIndex];
+				slot.denseIndex = (unsigned int)values.size();
+				slot.nextFree	= NO_SLOT;
+
+				values.push_back(value);
+				valueSlots.push_back(slotIndex);
+				return SlotHandle(slotIndex, slot.generation);
+			}
+
+			bool Remove(SlotHandle h) {
+				if (!Contains(h)) {
+					return false;
+				}
+				Slot& slot = slots[h.index];
+
+				unsigned int lastIndex = (unsigned int)values.size() - 1;
+				if (slot.denseIndex != lastIndex) {
+					values[slot.denseIndex]		= values[lastIndex];
+					valueSlots[slot.denseIndex] = valueSlots[lastIndex];
+					slots[valueSlots[slot.denseIndex]].denseIndex = slot.denseIndex;
+				}
+				values.pop_back();
+				valueSlots.pop_back();
+
+				slot.generation++;
+				slot.generation += slot.generation == 0 ? 1 : 0;	//Never hand out generation 0
+				slot.nextFree	= freeHead;
+				freeHead		= h.index;
+				return true;
+			}
+
+			bool Contains(SlotHandle h) const {
+				return h.index < slots.size() && slots[h.index].generation == h.generation && h.generation != 0;
+			}
+
+			T* Get(SlotHandle h) {
+				return Contains(h) ? &values[slots[h.index].denseIndex] : nullptr;
+			}
+
+			const T* Get(SlotHandle h) const {
+				return Contains(h) ? &values[slots[h.index].denseIndex] : nullptr;
+			}
+
+			//Makes room for count values, so inserting that many never has to reallocate
+			void Reserve(size_t count) {
+				values.reserve(count);
+				valueSlots.reserve(count);
+				slots.reserve(count);
+			}
+
+			//Removes everything, invalidating every handle given out so far
+			void Clear() {
+				while (!values.empty()) {
+					unsigned int slotIndex = valueSlots.back();
+					Remove(SlotHandle(slotIndex, slots[slotIndex].generation));
+				}
+			}
+
+			//Shuffles the packed values, keeping every handle pointing at the same value
+			template<class R>
+			void Shuffle(R& generator) {
+				for (size_t i = values.size(); i > 1; --i) {
+					size_t j = std::uniform_int_distribution<size_t>(0, i - 1)(generator);
+					std::swap(values[i - 1], values[j]);
+					std::swap(valueSlots[i - 1], valueSlots[j]);
+				}
+				for (size_t i = 0; i < values.size(); ++i) {
+					slots[valueSlots[i]].denseIndex = (unsigned int)i;
+				}
+			}
+
+			size_t Size() const {
+				return values.size();
+			}
+
+			bool Empty() const {
+				return values.empty();
+			}
+
+			const std::vector<T>& Values() const {
+				return values;
+			}
+
+			iterator		begin()			{ return values.begin(); }
+			iterator		end()			{ return values.end(); }
+			const_iterator	begin() const	{ return values.begin(); }
+			const_iterator	end()	const	{ return values.end(); }
+
+		protected:
+			static const unsigned int NO_SLOT = ~0u;
+
+			struct Slot {
+				unsigned int generation;
+				unsigned int denseIndex;
+				unsigned int nextFree;
+
+				Slot() {
+					generation	= 1;
+					denseIndex	= 0;
+					nextFree	= NO_SLOT;
+				}
+			};
+
+			std::vector<T>				values;
+			std::vector<unsigned int>	valueSlots;	//Which slot each packed value belongs to
+			std::vector<Slot>			slots;
+			unsigned int				freeHead;
+		};
+	}
+}
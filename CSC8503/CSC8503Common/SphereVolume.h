@@ -5,6 +5,9 @@ namespace NCL {
 	class SphereVolume : CollisionVolume
 	{
 	public:
+		using CollisionVolume::operator new;
+		using CollisionVolume::operator delete;
+
 		SphereVolume(float sphereRadius = 1.0f) {
 			type	= VolumeType::Sphere;
 			radius	= sphereRadius;
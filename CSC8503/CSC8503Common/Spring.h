@@ -29,6 +29,26 @@ namespace NCL {
 			void ToggleSpringCoil() {
 				coiled = !coiled;
 			}
+
+			GameObject* GetObjectA() const {
+				return obj1;
+			}
+
+			GameObject* GetObjectB() const {
+				return obj2;
+			}
+
+			float GetRestingLength() const {
+				return restingLength;
+			}
+
+			float GetStiffness() const {
+				return k;
+			}
+
+			bool IsCoiled() const {
+				return coiled;
+			}
 		protected:
 			GameObject* obj1;
 			GameObject* obj2;
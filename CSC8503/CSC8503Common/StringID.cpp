@@ -0,0 +1,40 @@
+#include "StringID.h"
+#include <unordered_map>
+#include <mutex>
+#include <iostream>
+
+using namespace NCL;
+using namespace CSC8503;
+
+namespace {
+	//Functions rather than globals, so they exist before any static objects intern names
+	std::unordered_map<unsigned int, std::string>& GetStringTable() {
+		static std::unordered_map<unsigned int, std::string> table;
+		return table;
+	}
+
+	std::mutex& GetStringMutex() {
+		static std::mutex mutex;
+		return mutex;
+	}
+}
+
+StringID StringID::Intern(const std::string& s) {
+	StringID id(HashString(s.c_str(), s.length()));
+
+	std::lock_guard<std::mutex> lock(GetStringMutex());
+	auto i = GetStringTable().emplace(id.value, s);
+	if (!i.second && i.first->second != s) {
+		std::cout << __FUNCTION__ << ": \"" << s << "\" and \"" << i.first->second << "\" have the same ID!" << std::endl;
+	}
+	return id;
+}
+
+//Entries are never removed, and unordered_map never moves them, so the reference stays valid
+const std::string& StringID::GetString() const {
+	static const std::string unknown = "<unknown>";
+
+	std::lock_guard<std::mutex> lock(GetStringMutex());
+	auto i = GetStringTable().find(value);
+	return i != GetStringTable().end() ? i->second : unknown;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+namespace NCL {
+	namespace CSC8503 {
+		//32 bit FNV-1a, written so it can be worked out at compile time
+		constexpr unsigned int HashString(const char* s, size_t length) {
+			unsigned int hash = 2166136261u;
+			for (size_t i = 0; i < length; ++i) {
+				hash = (hash ^ (unsigned char)s[i]) * 16777619u;
+			}
+			return hash;
+		}
+
+		/*
+		A name boiled down to a 32 bit hash, so comparing two names is a single
+		integer compare rather than a string compare, and storing one takes 4
+		bytes rather than a whole std::string. Write literals as "Coin"_sid, and
+		they're hashed by the compiler. Anything made through Intern is also
+		remembered, so GetString can turn an ID back into a name for debugging -
+		GameObject interns every name it's given, so object names always can be.
+		*/
+		class StringID	{
+		public:
+			constexpr StringID() : value(0) {}
+			explicit constexpr StringID(unsigned int value) : value(value) {}
+
+			//Hashes the string, and remembers it for GetString
+			static StringID Intern(const std::string& s);
+
+			//The string this ID was interned from, or "<unknown>"
+			const std::string& GetString() const;
+
+			constexpr unsigned int GetValue() const {
+				return value;
+			}
+
+			constexpr bool operator==(const StringID& other) const {
+				return value == other.value;
+			}
+
+			constexpr bool operator!=(const StringID& other) const {
+				return value != other.value;
+			}
+
+			constexpr bool operator<(const StringID& other) const {
+				return value < other.value;
+			}
+
+		protected:
+			unsigned int value;
+		};
+
+		constexpr StringID operator"" _sid(const char* s, size_t length) {
+			return StringID(HashString(s, length));
+		}
+	}
+}
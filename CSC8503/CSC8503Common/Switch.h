@@ -7,17 +7,24 @@ namespace NCL {
 		class Switch : public GameObject {
 		public:
 			Switch(std::string name = "Switch") : GameObject(name) {
-				layer = Layer::StaticObjects;
+				layer	= Layer::StaticObjects;
+				spring	= nullptr;
 			};
 			
 			virtual void OnSelect() override{
-				spring->ToggleSpringCoil();
+				if (spring) {
+					spring->ToggleSpringCoil();
+				}
 			}
 
 			void SetSpring(Spring* spr) {
 				spring = spr;
 			}
 
+			Spring* GetSpring() const {
+				return spring;
+			}
+
 
 		protected:
 			Spring* spring;
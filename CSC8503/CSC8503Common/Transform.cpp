@@ -1,10 +1,33 @@
 #include "Transform.h"
+#include "WorldJournal.h"
 
 using namespace NCL::CSC8503;
 
 Transform::Transform()
 {
 	scale	= Vector3(1, 1, 1);
+	journal = nullptr;
+	owner	= nullptr;
+	journalStamp = -1;
+}
+
+Transform::Transform(const Transform& other) {
+	matrix		= other.matrix;
+	orientation = other.orientation;
+	position	= other.position;
+	scale		= other.scale;
+	journal		= nullptr;
+	owner		= nullptr;
+	journalStamp = -1;
+}
+
+Transform& Transform::operator=(const Transform& other) {
+	matrix		= other.matrix;
+	orientation = other.orientation;
+	position	= other.position;
+	scale		= other.scale;
+	LogMove();
+	return *this;
 }
 
 Transform::~Transform()
@@ -19,20 +42,29 @@ void Transform::UpdateMatrix() {
 		Matrix4::Scale(scale);
 }
 
+void Transform::LogMove() {
+	if (journal) {
+		journal->ObjectMoved(owner, journalStamp);
+	}
+}
+
 Transform& Transform::SetPosition(const Vector3& worldPos) {
 	position = worldPos;
 	UpdateMatrix();
+	LogMove();
 	return *this;
 }
 
 Transform& Transform::SetScale(const Vector3& worldScale) {
 	scale = worldScale;
 	UpdateMatrix();
+	LogMove();
 	return *this;
 }
 
 Transform& Transform::SetOrientation(const Quaternion& worldOrientation) {
 	orientation = worldOrientation;
 	UpdateMatrix();
+	LogMove();
 	return *this;
 }
\ No newline at end of file
@@ -12,12 +12,18 @@ using namespace NCL::Maths;
 
 namespace NCL {
 	namespace CSC8503 {
+		class WorldJournal;
+		class GameObject;
+
 		class Transform
 		{
 		public:
 			Transform();
+			Transform(const Transform& other);
 			~Transform();
 
+			Transform& operator=(const Transform& other);
+
 			Transform& SetPosition(const Vector3& worldPos);
 			Transform& SetScale(const Vector3& worldScale);
 			Transform& SetOrientation(const Quaternion& newOr);
@@ -38,12 +44,26 @@ namespace NCL {
 				return matrix;
 			}
 			void UpdateMatrix();
+
+			//Once set, every change to the transform is logged to the journal as a move of the owner
+			void SetJournal(WorldJournal* newJournal, GameObject* newOwner) {
+				journal			= newJournal;
+				owner			= newOwner;
+				journalStamp	= -1;
+			}
 		protected:
+			void LogMove();
+
 			Matrix4		matrix;
 			Quaternion	orientation;
 			Vector3		position;
 
 			Vector3		scale;
+
+			//Not copied along with the rest of the transform - copies aren't part of any world
+			WorldJournal*	journal;
+			GameObject*		owner;
+			int				journalStamp;
 		};
 	}
 }
@@ -0,0 +1,76 @@
+#include "WorldCommandBuffer.h"
+#include "GameWorld.h"
+#include "Constraint.h"
+
+using namespace NCL;
+using namespace CSC8503;
+
+WorldCommandBuffer::WorldCommandBuffer() {
+}
+
+WorldCommandBuffer::~WorldCommandBuffer() {
+}
+
+void WorldCommandBuffer::Queue(const Command& c) {
+	std::lock_guard<std::mutex> lock(mutex);
+	commands.emplace_back(c);
+}
+
+void WorldCommandBuffer::AddGameObject(GameObject* o) {
+	Queue({ CommandType::AddObject, o, nullptr, GameObjectHandle(), false });
+}
+
+void WorldCommandBuffer::RemoveGameObject(GameObject* o, bool andDelete) {
+	Queue({ CommandType::RemoveObject, o, nullptr, o->GetHandle(), andDelete });
+}
+
+void WorldCommandBuffer::AddConstraint(Constraint* c) {
+	Queue({ CommandType::AddConstraint, nullptr, c, GameObjectHandle(), false });
+}
+
+void WorldCommandBuffer::RemoveConstraint(Constraint* c, bool andDelete) {
+	Queue({ CommandType::RemoveConstraint, nullptr, c, GameObjectHandle(), andDelete });
+}
+
+size_t WorldCommandBuffer::GetQueuedCount() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return commands.size();
+}
+
+/*
+An object can easily end up queued for removal more than once (say, by two
+different collisions in the same frame), so removals are checked against the
+handle the object had when it was queued. Once the first removal has gone
+through, that handle no longer finds anything, and any later ones are skipped,
+without ever touching an object that might have been deleted already. Objects
+that weren't in the world yet when their removal was queued have no handle to
+check, so they're looked at directly instead - but only once it's known this
+Apply hasn't already deleted them.
+*/
+void WorldCommandBuffer::Apply(GameWorld& world) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		applying.swap(commands);
+	}
+	for (Command& c : applying) {
+		switch (c.type) {
+			case CommandType::AddObject:		world.AddGameObject(c.object); break;
+			case CommandType::AddConstraint:	world.AddConstraint(c.constraint); break;
+			case CommandType::RemoveConstraint: world.RemoveConstraint(c.constraint, c.andDelete); break;
+			case CommandType::RemoveObject: {
+				if (c.handle.IsNull() && deleted.count(c.object)) {
+					break;
+				}
+				GameObjectHandle h = c.handle.IsNull() ? c.object->GetHandle() : c.handle;
+				if (world.GetObject(h) == c.object) {
+					world.RemoveGameObject(c.object, c.andDelete);
+					if (c.andDelete) {
+						deleted.insert(c.object);
+					}
+				}
+			} break;
+		}
+	}
+	applying.clear();
+	deleted.clear();
+}
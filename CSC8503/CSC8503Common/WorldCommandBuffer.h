@@ -0,0 +1,59 @@
+#pragma once
+#include "GameObject.h"
+#include <vector>
+#include <unordered_set>
+#include <mutex>
+
+namespace NCL {
+	namespace CSC8503 {
+		class GameWorld;
+		class Constraint;
+
+		/*
+		Adding or removing things from a GameWorld while something else is iterating
+		over it (like the physics system calling OnCollisionBegin, or another thread
+		updating objects) isn't safe. Instead, those changes can be queued up here, from
+		any thread, and the world applies them all in the order they were queued once
+		it reaches a point in the frame where nothing else is using it.
+		*/
+		class WorldCommandBuffer	{
+		public:
+			WorldCommandBuffer();
+			~WorldCommandBuffer();
+
+			void AddGameObject(GameObject* o);
+			void RemoveGameObject(GameObject* o, bool andDelete = false);
+
+			void AddConstraint(Constraint* c);
+			void RemoveConstraint(Constraint* c, bool andDelete = false);
+
+			//Anything queued while the commands are being applied is left for next time
+			void Apply(GameWorld& world);
+
+			size_t GetQueuedCount() const;
+
+		protected:
+			enum class CommandType {
+				AddObject,
+				RemoveObject,
+				AddConstraint,
+				RemoveConstraint
+			};
+
+			struct Command {
+				CommandType			type;
+				GameObject*			object;
+				Constraint*			constraint;
+				GameObjectHandle	handle;		//Where the object was when the removal was queued
+				bool				andDelete;
+			};
+
+			void Queue(const Command& c);
+
+			std::vector<Command>	commands;
+			std::vector<Command>	applying;
+			std::unordered_set<GameObject*>	deleted;	//Objects this Apply has deleted so far
+			mutable std::mutex		mutex;
+		};
+	}
+}
@@ -0,0 +1,68 @@
+#include "WorldJournal.h"
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+WorldJournal::WorldJournal() {
+	firstRecord = 0;
+	epoch		= 0;
+}
+
+WorldJournal::~WorldJournal() {
+}
+
+int WorldJournal::AddConsumer() {
+	cursors.emplace_back(firstRecord + records.size());
+	return (int)cursors.size() - 1;
+}
+
+void WorldJournal::ObjectCreated(GameObject* o) {
+	std::lock_guard<std::mutex> lock(mutex);
+	records.push_back({ JournalEvent::Created, o });
+}
+
+void WorldJournal::ObjectChanged(GameObject* o) {
+	std::lock_guard<std::mutex> lock(mutex);
+	records.push_back({ JournalEvent::Changed, o });
+}
+
+void WorldJournal::ObjectDestroyed(GameObject* o) {
+	destroyedScratch.assign(1, o);
+	ObjectsDestroyed(destroyedScratch);
+}
+
+/*
+Clearing a world destroys everything at once, so the pending records are
+only walked over the one time, looking each object up in a sorted list.
+*/
+void WorldJournal::ObjectsDestroyed(const std::vector<GameObject*>& objects) {
+	if (objects.empty()) {
+		return;
+	}
+	std::vector<GameObject*> sorted(objects);
+	std::sort(sorted.begin(), sorted.end());
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	for (JournalRecord& r : records) {
+		if (r.object && std::binary_search(sorted.begin(), sorted.end(), r.object)) {
+			r.object = nullptr;
+		}
+	}
+	for (GameObject* o : objects) {
+		records.push_back({ JournalEvent::Destroyed, o });
+	}
+}
+
+void WorldJournal::EndFrame() {
+	size_t oldest = firstRecord + records.size();
+	for (size_t c : cursors) {
+		oldest = c < oldest ? c : oldest;
+	}
+	size_t seenByAll = oldest - firstRecord;
+	if (seenByAll > 0) {
+		records.erase(records.begin(), records.begin() + seenByAll);
+		firstRecord = oldest;
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <vector>
+#include <mutex>
+
+namespace NCL {
+	namespace CSC8503 {
+		class GameObject;
+
+		enum class JournalEvent {
+			Created,
+			Destroyed,	//The object may already be deleted, so only use it to look things up!
+			Moved,		//Position, orientation or scale was set
+			Changed		//Anything else a subsystem might care about - active, layer, volume, render object
+		};
+
+		struct JournalRecord {
+			JournalEvent	event;
+			GameObject*		object;
+		};
+
+		/*
+		A running log of what's happened to the objects in a GameWorld, so that
+		each subsystem can catch up on just the objects that changed, rather than
+		visiting every object every frame to find out. Each subsystem registers
+		as a consumer, and gets given every record logged since it last asked.
+
+		An object is only logged as moved once between reads, no matter how many
+		times its transform is set. Once an object is destroyed, any records about
+		it that are still waiting to be read are cancelled, so nobody touches it.
+		Objects can be logged from any thread, but records should only be read
+		while nothing else is using the world.
+		*/
+		class WorldJournal	{
+		public:
+			WorldJournal();
+			~WorldJournal();
+
+			//Consumers start off only seeing records logged after they were added
+			int AddConsumer();
+
+			template<class F>
+			void Consume(int consumer, F func) {
+				for (size_t i = cursors[consumer] - firstRecord; i < records.size(); ++i) {
+					if (records[i].object) {
+						func(records[i]);
+					}
+				}
+				cursors[consumer] = firstRecord + records.size();
+				epoch++;
+			}
+
+			void ObjectCreated(GameObject* o);
+			void ObjectDestroyed(GameObject* o);
+			void ObjectsDestroyed(const std::vector<GameObject*>& objects);
+			void ObjectChanged(GameObject* o);
+
+			//Transforms call this whenever they're set, with their own stamp so repeats can be skipped
+			void ObjectMoved(GameObject* o, int& stamp) {
+				if (stamp != epoch) {
+					stamp = epoch;
+					std::lock_guard<std::mutex> lock(mutex);
+					records.push_back({ JournalEvent::Moved, o });
+				}
+			}
+
+			//Throws away everything every consumer has already seen
+			void EndFrame();
+
+			size_t GetPendingRecords() const {
+				return records.size();
+			}
+
+		protected:
+			std::vector<JournalRecord>	records;
+			std::vector<size_t>			cursors;	//Counted from the first record ever logged
+			std::vector<GameObject*>	destroyedScratch;
+			std::mutex					mutex;		//Objects can be moved or changed from jobs
+
+			size_t	firstRecord;	//How many records have been thrown away so far
+			int		epoch;			//Goes up on every read, so moves after a read get logged again
+		};
+	}
+}
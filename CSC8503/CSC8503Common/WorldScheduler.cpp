@@ -0,0 +1,91 @@
+#include "WorldScheduler.h"
+#include "GameWorld.h"
+#include "PhysicsSystem.h"
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+WorldScheduler::WorldScheduler(int threadCount) {
+	stepDT		= 0.0f;
+	stepCount	= 0;
+	workersDone = 0;
+	shuttingDown = false;
+	nextWorld	= 0;
+
+	for (int i = 1; i < threadCount; ++i) {
+		workers.emplace_back(&WorldScheduler::WorkerLoop, this);
+	}
+}
+
+WorldScheduler::~WorldScheduler() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shuttingDown = true;
+	}
+	startStep.notify_all();
+	for (std::thread& t : workers) {
+		t.join();
+	}
+}
+
+void WorldScheduler::AddWorld(GameWorld* world, PhysicsSystem* physics) {
+	worlds.push_back({ world, physics });
+}
+
+void WorldScheduler::RemoveWorld(GameWorld* world) {
+	worlds.erase(std::remove_if(worlds.begin(), worlds.end(),
+		[&](const ScheduledWorld& w) { return w.world == world; }), worlds.end());
+}
+
+void WorldScheduler::Step(float dt) {
+	if (worlds.empty()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stepDT		= dt;
+		nextWorld	= 0;
+		workersDone = 0;
+		stepCount++;
+	}
+	startStep.notify_all();
+
+	RunWorlds();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	stepDone.wait(lock, [&]() { return workersDone == (int)workers.size(); });
+}
+
+//Each thread keeps grabbing the next world that nobody has started on yet
+void WorldScheduler::RunWorlds() {
+	int count = (int)worlds.size();
+	for (int i = nextWorld++; i < count; i = nextWorld++) {
+		ScheduledWorld& w = worlds[i];
+		w.world->ApplyCommands();
+		if (w.physics) {
+			w.physics->Update(stepDT);
+		}
+		w.world->UpdateWorld(stepDT);
+	}
+}
+
+void WorldScheduler::WorkerLoop() {
+	int lastStep = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			startStep.wait(lock, [&]() { return shuttingDown || stepCount != lastStep; });
+			if (shuttingDown) {
+				return;
+			}
+			lastStep = stepCount;
+		}
+		RunWorlds();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			workersDone++;
+		}
+		stepDone.notify_one();
+	}
+}
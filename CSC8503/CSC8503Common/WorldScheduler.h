@@ -0,0 +1,62 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace NCL {
+	namespace CSC8503 {
+		class GameWorld;
+		class PhysicsSystem;
+
+		/*
+		Steps a set of completely independent worlds (separate matches, or test
+		sandboxes) at the same time, spread across a pool of threads. Each world
+		only ever touches its own state during a step, so worlds are handed out to
+		threads one at a time and never need locking. The thread calling Step does
+		its share of the work too, and Step only returns once every world is done.
+		*/
+		class WorldScheduler	{
+		public:
+			//threadCount includes the calling thread, so 1 steps everything on the caller
+			WorldScheduler(int threadCount = (int)std::thread::hardware_concurrency());
+			~WorldScheduler();
+
+			void AddWorld(GameWorld* world, PhysicsSystem* physics);
+			void RemoveWorld(GameWorld* world);
+
+			void Step(float dt);
+
+			int GetThreadCount() const {
+				return (int)workers.size() + 1;
+			}
+
+			int GetWorldCount() const {
+				return (int)worlds.size();
+			}
+
+		protected:
+			struct ScheduledWorld {
+				GameWorld*		world;
+				PhysicsSystem*	physics;
+			};
+
+			void WorkerLoop();
+			void RunWorlds();
+
+			std::vector<ScheduledWorld>	worlds;
+			std::vector<std::thread>	workers;
+
+			std::mutex					mutex;
+			std::condition_variable		startStep;
+			std::condition_variable		stepDone;
+			std::atomic<int>			nextWorld;
+
+			float	stepDT;
+			int		stepCount;		//Goes up every step, so workers know there's new work
+			int		workersDone;
+			bool	shuttingDown;
+		};
+	}
+}
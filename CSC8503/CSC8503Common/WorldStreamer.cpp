@@ -0,0 +1,324 @@
+#include "WorldStreamer.h"
+#include "GameWorld.h"
+#include "GameObject.h"
+#include "Constraint.h"
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+using namespace NCL;
+using namespace CSC8503;
+
+WorldStreamer::WorldStreamer(GameWorld& world, SceneContext& context, const std::string& cellPrefix, float cellSize, int threadCount)
+	: world(world), context(context) {
+	this->cellPrefix	= cellPrefix;
+	this->cellSize		= cellSize;
+	loadRadius			= cellSize;
+	unloadRadius		= cellSize * 1.5f;
+	insertionBudget		= 32;
+	removalBudget		= 32;
+	loadingCount		= 0;
+	shuttingDown		= false;
+
+	for (int i = 0; i < threadCount; ++i) {
+		workers.emplace_back(&WorldStreamer::WorkerLoop, this);
+	}
+}
+
+WorldStreamer::~WorldStreamer() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shuttingDown = true;
+	}
+	requestReady.notify_all();
+	for (std::thread& t : workers) {
+		t.join();
+	}
+	//Anything made but never put in the world has nowhere else to go
+	for (LoadResult& r : results) {
+		SceneFile::Discard(r.contents);
+	}
+	for (auto& i : cells) {
+		SceneFile::Discard(i.second.contents, i.second.nextObject, i.second.nextConstraint);
+	}
+}
+
+WorldStreamer::CellKey WorldStreamer::MakeKey(int x, int z) {
+	return ((CellKey)x << 32) | (CellKey)(unsigned int)z;
+}
+
+std::string WorldStreamer::GetCellFilename(const std::string& prefix, int x, int z) {
+	return prefix + "_" + std::to_string(x) + "_" + std::to_string(z) + ".scene";
+}
+
+int WorldStreamer::SaveCells(GameWorld& world, SceneContext& context, const std::string& cellPrefix, float cellSize, const GameObjectFilter& filter) {
+	GameObjectIterator first;
+	GameObjectIterator last;
+	world.GetObjectIterators(first, last);
+
+	std::unordered_map<CellKey, std::pair<int, int>> usedCells;
+	for (auto i = first; i != last; ++i) {
+		if (filter && !filter(*i)) {
+			continue;
+		}
+		Vector3 pos = (*i)->GetTransform().GetPosition();
+		int x = (int)std::floor(pos.x / cellSize);
+		int z = (int)std::floor(pos.z / cellSize);
+		usedCells[MakeKey(x, z)] = std::make_pair(x, z);
+	}
+
+	int written = 0;
+	for (auto& c : usedCells) {
+		int x = c.second.first;
+		int z = c.second.second;
+		bool saved = SceneFile::Save(GetCellFilename(cellPrefix, x, z), world, context, [&](GameObject* o) {
+			Vector3 pos = o->GetTransform().GetPosition();
+			return (!filter || filter(o)) && (int)std::floor(pos.x / cellSize) == x && (int)std::floor(pos.z / cellSize) == z;
+		});
+		written += saved ? 1 : 0;
+	}
+	return written;
+}
+
+void WorldStreamer::Update(const Vector3& focus) {
+	CollectResults();
+	RequestCells(focus);
+
+	//Removals go first, so their memory is ready to be reused by the insertions
+	int budget = removalBudget;
+	for (auto i = cells.begin(); i != cells.end() && budget > 0; ) {
+		if (i->second.state == CellState::Unloading && RemoveCell(i->second, budget)) {
+			i = cells.erase(i);
+		}
+		else {
+			++i;
+		}
+	}
+	budget = insertionBudget;
+	for (auto i = cells.begin(); i != cells.end() && budget > 0; ++i) {
+		if (i->second.state == CellState::Inserting) {
+			InsertCell(i->second, budget);
+		}
+	}
+}
+
+void WorldStreamer::UnloadAll() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		loadingCount -= (int)requests.size();
+		for (const LoadRequest& r : requests) {
+			cells.erase(r.key);
+		}
+		requests.clear();
+	}
+	int budget = INT_MAX;
+	for (auto i = cells.begin(); i != cells.end(); ) {
+		Cell& c = i->second;
+		if (c.state == CellState::Loading) {
+			c.wanted = false;	//Already being read in, so it's thrown away when it arrives
+			++i;
+			continue;
+		}
+		RemoveCell(c, budget);
+		i = cells.erase(i);
+	}
+}
+
+float WorldStreamer::DistanceToCell(const Vector3& focus, int x, int z) const {
+	float minX = x * cellSize;
+	float minZ = z * cellSize;
+	float dx = focus.x < minX ? minX - focus.x : (focus.x > minX + cellSize ? focus.x - (minX + cellSize) : 0.0f);
+	float dz = focus.z < minZ ? minZ - focus.z : (focus.z > minZ + cellSize ? focus.z - (minZ + cellSize) : 0.0f);
+	return std::sqrt(dx * dx + dz * dz);
+}
+
+void WorldStreamer::RequestCells(const Vector3& focus) {
+	int minX = (int)std::floor((focus.x - loadRadius) / cellSize);
+	int maxX = (int)std::floor((focus.x + loadRadius) / cellSize);
+	int minZ = (int)std::floor((focus.z - loadRadius) / cellSize);
+	int maxZ = (int)std::floor((focus.z + loadRadius) / cellSize);
+
+	std::vector<LoadRequest> newRequests;
+	for (int z = minZ; z <= maxZ; ++z) {
+		for (int x = minX; x <= maxX; ++x) {
+			if (DistanceToCell(focus, x, z) > loadRadius) {
+				continue;
+			}
+			CellKey key = MakeKey(x, z);
+			auto i = cells.find(key);
+			if (i != cells.end()) {
+				i->second.wanted = true;	//If it's on its way out, it's requested again once it's gone
+				continue;
+			}
+			Cell& c			= cells[key];
+			c.state			= CellState::Loading;
+			c.wanted		= true;
+			c.nextObject	= 0;
+			c.nextConstraint = 0;
+			c.x				= x;
+			c.z				= z;
+			newRequests.push_back({ key, GetCellFilename(cellPrefix, x, z) });
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	for (auto i = cells.begin(); i != cells.end(); ) {
+		Cell& c = i->second;
+		if (DistanceToCell(focus, c.x, c.z) <= unloadRadius) {
+			++i;
+			continue;
+		}
+		c.wanted = false;
+		if (c.state == CellState::Inserting || c.state == CellState::Loaded) {
+			c.state = CellState::Unloading;
+		}
+		else if (c.state == CellState::Loading) {
+			//If no thread has started on it yet, it can just be forgotten about
+			CellKey key = i->first;
+			auto r = std::find_if(requests.begin(), requests.end(), [&](const LoadRequest& l) { return l.key == key; });
+			if (r != requests.end()) {
+				requests.erase(r);
+				loadingCount--;
+				i = cells.erase(i);
+				continue;
+			}
+		}
+		++i;
+	}
+	for (LoadRequest& r : newRequests) {
+		requests.emplace_back(r);
+		loadingCount++;
+	}
+	if (!newRequests.empty()) {
+		requestReady.notify_all();
+	}
+}
+
+void WorldStreamer::CollectResults() {
+	std::vector<LoadResult> arrived;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		arrived.swap(results);
+	}
+	for (LoadResult& r : arrived) {
+		auto i = cells.find(r.key);
+		if (i == cells.end()) {
+			SceneFile::Discard(r.contents);
+			continue;
+		}
+		Cell& c			= i->second;
+		c.contents		= std::move(r.contents);
+		c.state			= c.wanted ? CellState::Inserting : CellState::Unloading;
+		c.nextObject	= 0;
+		c.nextConstraint = 0;
+		loadingCount--;
+	}
+}
+
+bool WorldStreamer::WasRemoved(CellKey key, size_t index) const {
+	auto i = removedObjects.find(key);
+	return i != removedObjects.end() && index < i->second.size() && i->second[index];
+}
+
+/*
+Objects go in before the constraints between them. Anything gameplay removed
+the last time the cell was in is deleted instead, along with any constraints
+attached to it. Returns true once the whole cell is in.
+*/
+bool WorldStreamer::InsertCell(Cell& c, int& budget) {
+	SceneContents& contents = c.contents;
+	CellKey key = MakeKey(c.x, c.z);
+	while (budget > 0 && c.nextObject < contents.objects.size()) {
+		size_t i = c.nextObject++;
+		if (WasRemoved(key, i)) {
+			delete contents.objects[i];
+			contents.objects[i] = nullptr;
+			continue;
+		}
+		SceneFile::AddObject(contents, i, world, context);
+		if (contents.objects[i]) {
+			c.objects.push_back({ contents.objects[i]->GetHandle(), i });
+		}
+		budget--;
+	}
+	while (budget > 0 && c.nextObject == contents.objects.size() && c.nextConstraint < contents.constraints.size()) {
+		size_t i = c.nextConstraint++;
+		const std::pair<size_t, size_t>& joins = contents.constraintObjects[i];
+		if (WasRemoved(key, joins.first) || WasRemoved(key, joins.second)) {
+			delete contents.constraints[i];
+			contents.constraints[i] = nullptr;
+			continue;
+		}
+		SceneFile::AddConstraint(contents, i, world, context);
+		c.constraints.emplace_back(contents.constraints[i]);
+		budget--;
+	}
+	if (c.nextObject < contents.objects.size() || c.nextConstraint < contents.constraints.size()) {
+		return false;
+	}
+	c.contents	= SceneContents();	//Everything in it belongs to the world now
+	c.state		= CellState::Loaded;
+	return true;
+}
+
+//Constraints come out first, so none are ever left pointing at deleted objects. Returns true once the cell is empty
+bool WorldStreamer::RemoveCell(Cell& c, int& budget) {
+	while (budget > 0 && !c.constraints.empty()) {
+		Constraint* constraint = c.constraints.back();
+		c.constraints.pop_back();
+		context.ConstraintUnloading(constraint);
+		world.RemoveConstraint(constraint, true);
+		budget--;
+	}
+	if (!c.constraints.empty()) {
+		return false;
+	}
+	//Whatever was never put in the world is just deleted
+	SceneFile::Discard(c.contents, c.contents.objects.size(), c.nextConstraint);
+
+	while (budget > 0 && !c.objects.empty()) {
+		StreamedObject streamed = c.objects.back();
+		c.objects.pop_back();
+		GameObject* o = world.GetObject(streamed.handle);
+		if (o) {
+			context.ObjectUnloading(o);
+			world.RemoveGameObject(o, true);
+		}
+		else {
+			std::vector<bool>& removed = removedObjects[MakeKey(c.x, c.z)];
+			if (removed.size() <= streamed.index) {
+				removed.resize(streamed.index + 1, false);
+			}
+			removed[streamed.index] = true;
+		}
+		budget--;
+	}
+	while (budget > 0 && c.nextObject < c.contents.objects.size()) {
+		delete c.contents.objects[c.nextObject];
+		c.contents.objects[c.nextObject++] = nullptr;
+		budget--;
+	}
+	return c.objects.empty() && c.nextObject >= c.contents.objects.size();
+}
+
+void WorldStreamer::WorkerLoop() {
+	ComponentScope componentScope(world.GetComponents());
+	while (true) {
+		LoadRequest request;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			requestReady.wait(lock, [&]() { return shuttingDown || !requests.empty(); });
+			if (shuttingDown) {
+				return;
+			}
+			request = requests.front();
+			requests.pop_front();
+		}
+		LoadResult result;
+		result.key = request.key;
+		SceneFile::Read(request.filename, context, result.contents);	//No file just means an empty cell
+
+		std::lock_guard<std::mutex> lock(mutex);
+		results.emplace_back(std::move(result));
+	}
+}
@@ -0,0 +1,131 @@
+#pragma once
+#include "SceneFile.h"
+#include "SlotMap.h"
+#include "../../Common/Vector3.h"
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace NCL {
+	using Maths::Vector3;
+	namespace CSC8503 {
+		/*
+		Splits a big level up into square cells on the XZ plane, each saved as its
+		own scene file, and keeps only the cells near a focus point (usually the
+		player) in the world. Cells are read and their objects made on background
+		threads, then moved into the world a few at a time in Update, which should
+		be called at the same point in the frame as GameWorld::ApplyCommands. The
+		budgets cap how many objects go in or come out each frame, so crossing into
+		a busy area never causes one huge spike.
+
+		Cells are unloaded a little further out than they're loaded, so walking
+		back and forth over a cell boundary doesn't keep reloading the same cells.
+		Anything gameplay takes out of the world while its cell is loaded (like a
+		collected coin) is remembered, and left out whenever that cell comes back.
+		*/
+		class WorldStreamer	{
+		public:
+			WorldStreamer(GameWorld& world, SceneContext& context, const std::string& cellPrefix, float cellSize, int threadCount = 1);
+			//Anything streamed in is left in the world, so call UnloadAll first if that matters
+			~WorldStreamer();
+
+			//Writes each cell of the world's objects that pass the filter out to its own file. Returns how many were written
+			static int SaveCells(GameWorld& world, SceneContext& context, const std::string& cellPrefix, float cellSize,
+				const GameObjectFilter& filter = nullptr);
+
+			void Update(const Vector3& focus);
+
+			//Removes every streamed object right away, ignoring the budgets
+			void UnloadAll();
+
+			void SetRadius(float loadRadius, float unloadRadius) {
+				this->loadRadius	= loadRadius;
+				this->unloadRadius	= unloadRadius > loadRadius ? unloadRadius : loadRadius;
+			}
+
+			void SetBudgets(int insertionsPerFrame, int removalsPerFrame) {
+				insertionBudget = insertionsPerFrame;
+				removalBudget	= removalsPerFrame;
+			}
+
+			int GetCellCount() const {
+				return (int)cells.size();
+			}
+
+			int GetLoadingCount() const {
+				return loadingCount;
+			}
+
+		protected:
+			typedef long long CellKey;
+
+			enum class CellState {
+				Loading,	//Waiting for a thread to read it in
+				Inserting,	//Read in, and being moved into the world
+				Loaded,
+				Unloading	//Being taken out of the world
+			};
+
+			struct StreamedObject {
+				SlotHandle	handle;
+				size_t		index;	//Where it is in the cell's file
+			};
+
+			struct Cell {
+				CellState					state;
+				bool						wanted;			//If not, it's unloaded as soon as it has been read in
+				SceneContents				contents;
+				size_t						nextObject;		//How far through contents insertion has got
+				size_t						nextConstraint;
+				std::vector<StreamedObject>	objects;		//Everything put in the world so far, which gameplay might have removed since
+				std::vector<Constraint*>	constraints;
+				int							x;
+				int							z;
+			};
+
+			struct LoadRequest {
+				CellKey		key;
+				std::string filename;
+			};
+
+			struct LoadResult {
+				CellKey			key;
+				SceneContents	contents;
+			};
+
+			static CellKey		MakeKey(int x, int z);
+			static std::string	GetCellFilename(const std::string& prefix, int x, int z);
+
+			void WorkerLoop();
+			void RequestCells(const Vector3& focus);
+			void CollectResults();
+			bool InsertCell(Cell& c, int& budget);
+			bool RemoveCell(Cell& c, int& budget);
+			float DistanceToCell(const Vector3& focus, int x, int z) const;
+			bool  WasRemoved(CellKey key, size_t index) const;
+
+			GameWorld&		world;
+			SceneContext&	context;
+			std::string		cellPrefix;
+			float			cellSize;
+			float			loadRadius;
+			float			unloadRadius;
+			int				insertionBudget;
+			int				removalBudget;
+			int				loadingCount;
+
+			std::unordered_map<CellKey, Cell> cells;
+			std::unordered_map<CellKey, std::vector<bool>> removedObjects;	//Outlives the cells, indexed by position in each file
+
+			std::vector<std::thread>	workers;
+			std::mutex					mutex;
+			std::condition_variable		requestReady;
+			std::deque<LoadRequest>		requests;
+			std::vector<LoadResult>		results;
+			bool						shuttingDown;
+		};
+	}
+}
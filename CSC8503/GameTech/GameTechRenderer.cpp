@@ -15,6 +15,9 @@ Matrix4 biasMatrix = Matrix4::Translation(Vector3(0.5, 0.5, 0.5)) * Matrix4::Sca
 GameTechRenderer::GameTechRenderer(GameWorld& world) : OGLRenderer(*Window::GetWindow()), gameWorld(world)	{
 	glEnable(GL_DEPTH_TEST);
 
+	journalConsumer = gameWorld.GetJournal().AddConsumer();
+	objectListDirty = true;
+
 	shadowShader = new OGLShader("GameTechShadowVert.glsl", "GameTechShadowFrag.glsl");
 
 	glGenTextures(1, &shadowTex);
@@ -108,16 +111,28 @@ void GameTechRenderer::RenderFrame() {
 	glDisable(GL_CULL_FACE); //Todo - text indices are going the wrong way...
 }
 
+/*
+Moving an object doesn't change what needs drawing, so the list is only
+rebuilt when the world's journal says something else has happened.
+*/
 void GameTechRenderer::BuildObjectList() {
+	gameWorld.GetJournal().Consume(journalConsumer,
+		[&](const JournalRecord& r) {
+			if (r.event != JournalEvent::Moved) {
+				objectListDirty = true;
+			}
+		}
+	);
+	if (!objectListDirty) {
+		return;
+	}
+	objectListDirty = false;
 	activeObjects.clear();
 
-	gameWorld.OperateOnContents(
-		[&](GameObject* o) {
+	gameWorld.OperateOnRenderObjects(
+		[&](GameObject* o, RenderObject& g) {
 			if (o->IsActive()) {
-				const RenderObject* g = o->GetRenderObject();
-				if (g) {
-					activeObjects.emplace_back(g);
-				}
+				activeObjects.emplace_back(&g);
 			}
 		}
 	);
@@ -36,6 +36,8 @@ namespace NCL {
 			void LoadSkybox();
 
 			vector<const RenderObject*> activeObjects;
+			int		journalConsumer;
+			bool	objectListDirty;
 
 			OGLShader*  skyboxShader;
 			OGLMesh*	skyboxMesh;
@@ -4,6 +4,8 @@
 #include "../../Plugins/OpenGLRendering/OGLShader.h"
 #include "../../Plugins/OpenGLRendering/OGLTexture.h"
 #include "../../Common/TextureLoader.h"
+#include "../../Common/Assets.h"
+#include "../../Common/Maths.h"
 #include"../CSC8503Common/PositionConstraint.h"
 #include"../CSC8503Common/Spring.h"
 #include"../CSC8503Common/Coin.h"
@@ -16,12 +18,20 @@
 #include "../CSC8503Common/PushdownState.h"
 #include "../CSC8503Common/NavigationGrid.h"
 #include "../CSC8503Common/NavigationPath.h"
+#include "../CSC8503Common/NavigationPathCache.h"
+#include "../CSC8503Common/FlowField.h"
+#include "../CSC8503Common/PhysicsHistory.h"
+#include "../CSC8503Common/JobSystem.h"
+#include "../CSC8503Common/WorldStreamer.h"
+#include <iostream>
+#include <algorithm>
 
 using namespace NCL;
 using namespace CSC8503;
 
 TutorialGame::TutorialGame()	{
 	world		= new GameWorld();
+	worldScope	= new ComponentScope(world->GetComponents());
 	renderer	= new GameTechRenderer(*world);
 	physics		= new PhysicsSystem(*world);
 
@@ -35,6 +45,8 @@ TutorialGame::TutorialGame()	{
 	InitialiseAssets();
 
 	physics->UseGravity(useGravity);
+	physics->EnableHistory(120);
+	physics->SetLODCamera(world->GetMainCamera());
 }
 
 /*
@@ -62,6 +74,10 @@ void TutorialGame::InitialiseAssets() {
 	basicTex	= (OGLTexture*)TextureLoader::LoadAPITexture("checkerboard.png");
 	basicShader = new OGLShader("GameTechVert.glsl", "GameTechFrag.glsl");
 
+	navGrid		= new NavigationGrid("TestGrid1.txt");
+	pathCache	= new NavigationPathCache(*navGrid);
+	playerField = new FlowField(*navGrid);
+
 	InitCamera();
 }
 
@@ -72,24 +88,41 @@ TutorialGame::~TutorialGame()	{
 	delete charMeshB;
 	delete enemyMesh;
 	delete bonusMesh;
+	for (OGLMesh* m : heightfieldMeshes) {
+		delete m;
+	}
 
 	delete basicTex;
 	delete basicShader;
 
+	delete playerField;
+	delete pathCache;
+	delete navGrid;
+
+	delete streamer;
 	delete physics;
 	delete renderer;
+	delete worldScope;
 	delete world;
 }
 
 void TutorialGame::ClearWorld() {
+	delete streamer;	//Stops it loading anything more into the world
+	streamer = nullptr;
 
 	pushers.clear();
 	stateObjects.clear();
+	collectables.clear();
 	world->ClearAndErase();
 	physics->Clear();
 
-	selectionObject = nullptr;
-	lockedObject = nullptr;
+	for (OGLMesh* m : heightfieldMeshes) {
+		delete m;
+	}
+	heightfieldMeshes.clear();
+
+	selectionHandle = GameObjectHandle();
+	lockedHandle	= GameObjectHandle();
 
 	timer = new GameTimer();
 }
@@ -99,12 +132,17 @@ void TutorialGame::UpdateGame(float dt) {
 		world->GetMainCamera()->UpdateCamera(dt);
 	}
 
-	for (int i = 0; i < collectables.size(); i++) {
-		if (!collectables[i]->IsActive()) {
-			world->RemoveGameObject(collectables[i]);
-			collectables.erase(collectables.begin() + i);
+	//Erasing inside the loop skipped whichever collectable came after a removed one
+	collectables.erase(std::remove_if(collectables.begin(), collectables.end(), [&](GameObjectHandle h) {
+		GameObject* c = world->GetObject(h);
+		if (c && c->IsActive()) {
+			return false;
 		}
-	}
+		if (c) {
+			world->GetCommands().RemoveGameObject(c, true);
+		}
+		return true;	//Collected, or already gone from the world
+	}), collectables.end());
 
 
 	UpdateKeys();
@@ -149,7 +187,7 @@ void TutorialGame::UpdateGame(float dt) {
 
 		if (enemy) {
 			if (coinSpawnTimer >= 10.0f) {
-				collectables.emplace_back(SpawnCoin());
+				collectables.emplace_back(SpawnCoin()->GetHandle());
 				coinSpawnTimer = 0;
 			}
 			else {
@@ -167,15 +205,18 @@ void TutorialGame::UpdateGame(float dt) {
 				}
 				//...Otherwise, go after the most recently spawned collectable
 				else {
-					enemy->SetTarget(collectableInWorld ? collectables.back() : enemy);
+					enemy->SetTarget(collectableInWorld ? world->GetObject(collectables.back()) : enemy);
 				}
 			}
 			else {
-				enemy->SetTarget(collectableInWorld ? collectables.back() : enemy);
+				enemy->SetTarget(collectableInWorld ? world->GetObject(collectables.back()) : enemy);
 			}
 
-			if (enemy->GetTarget() != nullptr) {
-				PathFind(enemy->GetTransform().GetPosition() + Vector3(10, 0, 10), enemy->GetTarget()->GetTransform().GetPosition() + Vector3(10, 0, 10));
+			playerField->SetTarget(player->GetTransform().GetPosition() + navOffset);
+			playerField->Update();
+
+			if (enemy->GetTarget() != nullptr && !enemy->IsFollowingFlowField()) {
+				PathFind(enemy->GetTransform().GetPosition() + navOffset, enemy->GetTarget()->GetTransform().GetPosition() + navOffset);
 				DebugDisplayPath();
 			}
 		}
@@ -192,12 +233,24 @@ void TutorialGame::UpdateGame(float dt) {
 	}
 	SelectObject();
 	//MoveSelectedObject();
-	physics->Update(dt);
 
-	for (auto i : stateObjects) {
-		((VerticalBlocker*)i)->Update(dt);
+	//Everything queued up to change the world happens here, before physics sees it
+	if (streamer) {
+		streamer->Update(player ? player->GetTransform().GetPosition() : world->GetMainCamera()->GetPosition());
 	}
+	world->ApplyCommands();
+	physics->Update(dt);
 
+	//Each AI object only changes itself, so big groups of them can be updated as jobs
+	JobSystem::Instance().ParallelFor(0, (int)stateObjects.size(), 16,
+		[&](int first, int last) {
+			for (int i = first; i < last; ++i) {
+				stateObjects[i]->Update(dt);
+			}
+		}
+	);
+
+	GameObject* lockedObject = GetLockedObject();
 	if (lockedObject != nullptr) {
 		Vector3 objPos = lockedObject->GetTransform().GetPosition();
 		Vector3 camPos = objPos + lockedOffset;
@@ -269,8 +322,8 @@ void TutorialGame::ShowScore(bool won, float dt) {
 
 void TutorialGame::UpdateKeys() {
 	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F1)) {
-		selectionObject = nullptr;
-		lockedObject	= nullptr;
+		selectionHandle = GameObjectHandle();
+		lockedHandle	= GameObjectHandle();
 	}
 
 	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F2)) {
@@ -311,8 +364,62 @@ void TutorialGame::UpdateKeys() {
 	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F8)) {
 		world->ShuffleObjects(false);
 	}
+	//Rewind the physics by 60 updates, or as far back as the history goes
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F5)) {
+		PhysicsHistory* history = physics->GetHistory();
+		int frame = history->GetLatestFrame() - 60;
+		while (!history->HasFrame(frame) && frame < history->GetLatestFrame()) {
+			frame++;
+		}
+		std::cout << (physics->RestoreSnapshot(frame) ? "Rewound physics to snapshot " : "Couldn't rewind to snapshot ") << frame << std::endl;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F6)) {
+		BenchmarkSnapshots();
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F3)) {
+		BenchmarkClosestPoints();
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F4)) {
+		BenchmarkWorlds();
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::END)) {
+		CheckWorldCommands();
+	}
+
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F11)) {
+		PoolAllocator::PrintStats("Since level start", levelStartStats);
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::F12)) {
+		BenchmarkLevelLoading();
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::HOME)) {
+		ToggleLevelStreaming();
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::INSERT)) {
+		BenchmarkPathfinding();
+	}
 
-	if (lockedObject) {
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::B)) {
+		physics->UseBroadPhase(!physics->IsUsingBroadPhase());
+		std::cout << "Setting broadphase to " << physics->IsUsingBroadPhase() << std::endl;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::I)) {
+		physics->SetConstraintIterationCount(physics->GetConstraintIterationCount() - 1);
+		std::cout << "Setting constraint iterations to " << physics->GetConstraintIterationCount() << std::endl;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::O)) {
+		physics->SetConstraintIterationCount(physics->GetConstraintIterationCount() + 1);
+		std::cout << "Setting constraint iterations to " << physics->GetConstraintIterationCount() << std::endl;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::K)) {
+		physics->UseLOD(!physics->IsUsingLOD());
+		std::cout << "Setting physics LOD to " << physics->IsUsingLOD() << std::endl;
+	}
+	if (Window::GetKeyboard()->KeyPressed(KeyboardKeys::J)) {
+		physics->PrintLODStats();
+	}
+
+	if (GetLockedObject()) {
 		LockedObjectMovement();
 	}
 	else {
@@ -339,6 +446,7 @@ void TutorialGame::UpdateKeys() {
 }
 
 void TutorialGame::LockedObjectMovement() {
+	GameObject* lockedObject = GetLockedObject();
 	Matrix4 view		= world->GetMainCamera()->BuildViewMatrix();
 	Matrix4 camWorld	= view.Inverse();
 
@@ -362,7 +470,6 @@ void TutorialGame::LockedObjectMovement() {
 	}
 
 	if (Window::GetKeyboard()->KeyDown(KeyboardKeys::RIGHT)) {
-		Vector3 worldPos = selectionObject->GetTransform().GetPosition();
 		lockedObject->GetPhysicsObject()->AddForce(rightAxis * force);
 	}
 
@@ -380,6 +487,7 @@ void TutorialGame::LockedObjectMovement() {
 }
 
 void TutorialGame::DebugObjectMovement() {
+	GameObject* selectionObject = GetSelectionObject();
 //If we've selected an object, we can manipulate it with some key presses
 	if (inSelectionMode && selectionObject) {
 		//Twist the selected object!
@@ -425,6 +533,7 @@ void TutorialGame::DebugDrawCollider(const CollisionVolume* c, Transform* worldT
 	case VolumeType::OBB: Debug::DrawCube(worldTransform->GetPosition(), ((AABBVolume*)c)->GetHalfDimensions(),Vector4(0,1,0,1), 0, worldTransform->GetOrientation()); break;
 	case VolumeType::Sphere: Debug::DrawSphere(worldTransform->GetPosition(), ((SphereVolume*)c)->GetRadius(), col); break;
 	case VolumeType::Capsule: DebugDrawCapsule((CapsuleVolume*)c, worldTransform); break;
+	case VolumeType::Heightfield: Debug::DrawCube(worldTransform->GetPosition(), ((HeightfieldVolume*)c)->GetHalfDimensions(), col); break;
 	default: break;
 	}
 }
@@ -458,7 +567,7 @@ void TutorialGame::InitCamera() {
 	world->GetMainCamera()->SetPitch(-15.0f);
 	world->GetMainCamera()->SetYaw(315.0f);
 	world->GetMainCamera()->SetPosition(Vector3(-60, 40, 60));
-	lockedObject = nullptr;
+	lockedHandle = GameObjectHandle();
 }
 
 /*
@@ -474,9 +583,9 @@ GameObject* TutorialGame::AddFloorToWorld(const Vector3& position, const Vector3
 		.SetScale(dims * 2)
 		.SetPosition(position);
 
-	floor->SetRenderObject(new RenderObject(&floor->GetTransform(), cubeMesh, basicTex, basicShader));
+	floor->AddRenderObject(cubeMesh, basicTex, basicShader);
 	floor->GetRenderObject()->SetColour(col);
-	floor->SetPhysicsObject(new PhysicsObject(&floor->GetTransform(), floor->GetBoundingVolume()));
+	floor->AddPhysicsObject();
 
 	floor->GetPhysicsObject()->SetInverseMass(0);
 	floor->GetPhysicsObject()->SetElasticity(elasticity);
@@ -486,18 +595,79 @@ GameObject* TutorialGame::AddFloorToWorld(const Vector3& position, const Vector3
 	return floor;
 }
 
+/*
+Adds a static terrain floor, built from a grid of heights. The mesh is generated
+from the same samples, split along the same diagonals as the collision volume, so
+what you see is exactly what you'll stand on.
+*/
+GameObject* TutorialGame::AddHeightfieldToWorld(const Vector3& position, int samplesX, int samplesZ, float cellSize, const std::vector<float>& heights, float elasticity, Vector4 col) {
+	GameObject* terrain = new GameObject("Terrain", Layer::StaticObjects);
+
+	HeightfieldVolume* volume = new HeightfieldVolume(samplesX, samplesZ, cellSize, heights);
+	terrain->SetBoundingVolume((CollisionVolume*)volume);
+	terrain->GetTransform().SetPosition(position);
+
+	terrain->AddRenderObject(BuildHeightfieldMesh(volume), basicTex, basicShader);
+	terrain->GetRenderObject()->SetColour(col);
+	terrain->AddPhysicsObject();
+
+	terrain->GetPhysicsObject()->SetInverseMass(0);
+	terrain->GetPhysicsObject()->SetElasticity(elasticity);
+
+	world->AddGameObject(terrain);
+
+	return terrain;
+}
+
+//The mesh is kept in heightfieldMeshes, and deleted along with the level
+OGLMesh* TutorialGame::BuildHeightfieldMesh(const HeightfieldVolume* volume) {
+	int samplesX = volume->GetSamplesX();
+	int samplesZ = volume->GetSamplesZ();
+
+	std::vector<Vector3>		positions;
+	std::vector<Vector2>		texCoords;
+	std::vector<unsigned int>	indices;
+	for (int z = 0; z < samplesZ; ++z) {
+		for (int x = 0; x < samplesX; ++x) {
+			positions.emplace_back(volume->GetSamplePosition(x, z));
+			texCoords.emplace_back(Vector2((float)x, (float)z));
+		}
+	}
+	for (int z = 0; z < samplesZ - 1; ++z) {
+		for (int x = 0; x < samplesX - 1; ++x) {
+			unsigned int i00 = z * samplesX + x;
+			unsigned int i10 = i00 + 1;
+			unsigned int i01 = i00 + samplesX;
+			unsigned int i11 = i01 + 1;
+
+			indices.insert(indices.end(), { i00, i01, i11 });
+			indices.insert(indices.end(), { i00, i11, i10 });
+		}
+	}
+	OGLMesh* mesh = new OGLMesh();
+	mesh->SetVertexPositions(positions);
+	mesh->SetVertexTextureCoords(texCoords);
+	mesh->SetVertexIndices(indices);
+	mesh->RecalculateNormals();
+	mesh->SetPrimitiveType(GeometryPrimitive::Triangles);
+	mesh->UploadToGPU();
+	heightfieldMeshes.emplace_back(mesh);
+
+	return mesh;
+}
+
 VerticalBlocker* TutorialGame::AddVerticalBlockerToWorld(const Vector3& position, const Quaternion& rotation) {
 	VerticalBlocker* s = new VerticalBlocker();
 	s->SetLayer(Layer::AntiGravity);
 	s->GetTransform().SetPosition(position).SetScale(Vector3(20, 40, 20)).SetOrientation(rotation);
 	s->SetBoundingVolume(new CapsuleVolume(40, 10));
 
-	s->SetRenderObject(new RenderObject(&s->GetTransform(), capsuleMesh, basicTex, basicShader));
+	s->AddRenderObject(capsuleMesh, basicTex, basicShader);
 	s->GetRenderObject()->SetColour(Vector4(0, 1, 0, 1));
-	s->SetPhysicsObject(new PhysicsObject(&s->GetTransform(), s->GetBoundingVolume()));
+	s->AddPhysicsObject();
 	s->GetPhysicsObject()->SetElasticity(1.6);
 
-	s->GetPhysicsObject()->SetInverseMass(0.1);
+	s->GetPhysicsObject()->SetKinematic(true);
 	s->GetPhysicsObject()->SetElasticity(1);
 	world->AddGameObject(s);
 	stateObjects.emplace_back(s);
@@ -512,12 +682,12 @@ HorizontalBlocker* TutorialGame::AddHorizontalBlockerToWorld(const Vector3& posi
 	s->GetTransform().SetPosition(position).SetScale(dims * 2);
 	s->SetBoundingVolume((CollisionVolume*)new AABBVolume(Vector3(10,10, 1)));
 
-	s->SetRenderObject(new RenderObject(&s->GetTransform(), cubeMesh, basicTex, basicShader));
+	s->AddRenderObject(cubeMesh, basicTex, basicShader);
 	s->GetRenderObject()->SetColour(Vector4(0,1,0,1));
-	s->SetPhysicsObject(new PhysicsObject(&s->GetTransform(), s->GetBoundingVolume()));
+	s->AddPhysicsObject();
 	s->GetPhysicsObject()->SetElasticity(1.6);
 
-	s->GetPhysicsObject()->SetInverseMass(0.1);
+	s->GetPhysicsObject()->SetKinematic(true);
 	s->GetPhysicsObject()->SetElasticity(1);
 	world->AddGameObject(s);
 	stateObjects.emplace_back(s);
@@ -543,8 +713,8 @@ GameObject* TutorialGame::AddSphereToWorld(const Vector3& position, float radius
 		.SetScale(sphereSize)
 		.SetPosition(position);
 
-	sphere->SetRenderObject(new RenderObject(&sphere->GetTransform(), sphereMesh, basicTex, basicShader));
-	sphere->SetPhysicsObject(new PhysicsObject(&sphere->GetTransform(), sphere->GetBoundingVolume()));
+	sphere->AddRenderObject(sphereMesh, basicTex, basicShader);
+	sphere->AddPhysicsObject();
 
 	sphere->GetPhysicsObject()->SetInverseMass(inverseMass);
 	sphere->GetPhysicsObject()->InitSphereInertia();
@@ -563,9 +733,9 @@ GameObject* TutorialGame::AddSwitchToWorld(const Vector3& position) {
 	sw->GetTransform()
 		.SetScale(sphereSize)
 		.SetPosition(position);
-	sw->SetRenderObject(new RenderObject(&sw->GetTransform(), sphereMesh, basicTex, basicShader));
+	sw->AddRenderObject(sphereMesh, basicTex, basicShader);
 	sw->GetRenderObject()->SetColour(Vector4(1, 0, 1, 1));
-	sw->SetPhysicsObject(new PhysicsObject(&sw->GetTransform(), sw->GetBoundingVolume()));
+	sw->AddPhysicsObject();
 	sw->GetPhysicsObject()->SetInverseMass(0);
 	sw->GetPhysicsObject()->InitSphereInertia();
 	sw->GetPhysicsObject()->SetElasticity(0);
@@ -585,8 +755,8 @@ GameObject* TutorialGame::AddCapsuleToWorld(const Vector3& position, float halfH
 		.SetScale(Vector3(radius* 2, halfHeight, radius * 2))
 		.SetPosition(position);
 
-	capsule->SetRenderObject(new RenderObject(&capsule->GetTransform(), capsuleMesh, basicTex, basicShader));
-	capsule->SetPhysicsObject(new PhysicsObject(&capsule->GetTransform(), capsule->GetBoundingVolume()));
+	capsule->AddRenderObject(capsuleMesh, basicTex, basicShader);
+	capsule->AddPhysicsObject();
 
 	capsule->GetPhysicsObject()->SetInverseMass(inverseMass);
 	capsule->GetPhysicsObject()->InitCubeInertia();
@@ -611,8 +781,8 @@ GameObject* TutorialGame::AddCubeToWorld(const Vector3& position, Vector3 dimens
 		.SetPosition(position)
 		.SetScale(dimensions * 2);
 
-	cube->SetRenderObject(new RenderObject(&cube->GetTransform(), cubeMesh, basicTex, basicShader));
-	cube->SetPhysicsObject(new PhysicsObject(&cube->GetTransform(), cube->GetBoundingVolume()));
+	cube->AddRenderObject(cubeMesh, basicTex, basicShader);
+	cube->AddPhysicsObject();
 
 	cube->GetPhysicsObject()->SetInverseMass(inverseMass);
 	cube->GetPhysicsObject()->InitCubeInertia();
@@ -623,8 +793,10 @@ GameObject* TutorialGame::AddCubeToWorld(const Vector3& position, Vector3 dimens
 }
 
 void TutorialGame::InitLevel1() {
+	AllocationStats loadStart = PoolAllocator::GetStats();
 
 	ClearWorld();
+	ArenaScope levelScope(world->GetLevelArena());	//Everything made for the level goes in the arena
 	finishScore = 0;
 	finishTime = 0;
 
@@ -659,11 +831,18 @@ void TutorialGame::InitLevel1() {
 	AddGoal(Vector3(9, -40, 110));
 
 	timer = new GameTimer();
+
+	if (reportLevelLoads) {
+		PoolAllocator::PrintStats("Level load", loadStart);
+	}
+	levelStartStats = PoolAllocator::GetStats();
 }
 
 void TutorialGame::InitLevel2() {
+	AllocationStats loadStart = PoolAllocator::GetStats();
 
 	ClearWorld();
+	ArenaScope levelScope(world->GetLevelArena());	//Everything made for the level goes in the arena
 	finishScore = 0;
 	finishTime = 0;
 
@@ -672,7 +851,7 @@ void TutorialGame::InitLevel2() {
 	controlBall = true;
 	level = 2;
 
-	AddFloorToWorld(Vector3(90, -4, 90), Vector3(90, 4, 90), Quaternion::EulerAnglesToQuaternion(0, 0, 0), 0.5f, Vector4(0.1,0.1,0.1,1));
+	AddHeightfieldToWorld(Vector3(90, 0, 90), 19, 19, 10.0f, std::vector<float>(19 * 19, 0.0f), 0.5f, Vector4(0.1, 0.1, 0.1, 1));
 	AddFloorToWorld(Vector3(100, 0, 0), Vector3(100, 10, 10), Quaternion::EulerAnglesToQuaternion(0, 0, 0));
 	AddFloorToWorld(Vector3(100, 0, 180), Vector3(100, 10, 10), Quaternion::EulerAnglesToQuaternion(0, 0, 0));
 	AddFloorToWorld(Vector3(0, 0, 100), Vector3(10, 10, 100), Quaternion::EulerAnglesToQuaternion(0, 0, 0));
@@ -691,6 +870,38 @@ void TutorialGame::InitLevel2() {
 
 
 	timer = new GameTimer();
+
+	if (reportLevelLoads) {
+		PoolAllocator::PrintStats("Level load", loadStart);
+	}
+	levelStartStats = PoolAllocator::GetStats();
+}
+
+/*
+Everything the level needs is in the file, so this is just one bulk load.
+The player has to be saved before the enemy, as enemies are made to chase
+whichever player has already been loaded - InitLevel2 adds them that way.
+*/
+bool TutorialGame::InitLevelFromFile(const string& filename) {
+	AllocationStats loadStart = PoolAllocator::GetStats();
+
+	ClearWorld();
+	finishScore = 0;
+	finishTime	= 0;
+
+	won			= false;
+	gameLost	= false;
+	player		= nullptr;
+	enemy		= nullptr;
+
+	if (!SceneFile::Load(filename, *world, *this)) {
+		return false;
+	}
+	if (reportLevelLoads) {
+		PoolAllocator::PrintStats("Level load", loadStart);
+	}
+	levelStartStats = PoolAllocator::GetStats();
+	return true;
 }
 
 void TutorialGame::AddPusher(Vector3 pos, Vector3 pusherDims,  Quaternion rot, bool startCoiled, float springForce, float length) {
@@ -715,9 +926,9 @@ GameObject* TutorialGame::AddPlayerToWorld(const Vector3& position) {
 		.SetScale(sphereSize)
 		.SetPosition(position);
 
-	sphere->SetRenderObject(new RenderObject(&sphere->GetTransform(), sphereMesh, basicTex, basicShader));
+	sphere->AddRenderObject(sphereMesh, basicTex, basicShader);
 	sphere->GetRenderObject()->SetColour(Vector4(0, 0, 1, 1));
-	sphere->SetPhysicsObject(new PhysicsObject(&sphere->GetTransform(), sphere->GetBoundingVolume()));
+	sphere->AddPhysicsObject();
 
 	sphere->GetPhysicsObject()->SetInverseMass(1.0f);
 	sphere->GetPhysicsObject()->InitSphereInertia();
@@ -725,6 +936,7 @@ GameObject* TutorialGame::AddPlayerToWorld(const Vector3& position) {
 
 	world->AddGameObject(sphere);
 	player = sphere;
+	physics->AddLODObserver(player);
 
 	return sphere;
 }
@@ -733,7 +945,7 @@ GameObject* TutorialGame::AddEnemyToWorld(const Vector3& position) {
 	float meshSize		= 3.0f;
 	float inverseMass	= 0.5f;
 
-	Enemy* enemy = new Enemy(pathNodes, player);
+	Enemy* enemy = new Enemy(pathNodes, player, world, playerField, navOffset);
 
 	SphereVolume* volume = new SphereVolume(3);
 	enemy->SetBoundingVolume((CollisionVolume*)volume);
@@ -742,9 +954,9 @@ GameObject* TutorialGame::AddEnemyToWorld(const Vector3& position) {
 		.SetScale(Vector3(meshSize, meshSize, meshSize))
 		.SetPosition(position);
 
-	enemy->SetRenderObject(new RenderObject(&enemy->GetTransform(), enemyMesh, nullptr, basicShader));
+	enemy->AddRenderObject(enemyMesh, nullptr, basicShader);
 	enemy->GetRenderObject()->SetColour(Vector4(1,0,0,1));
-	enemy->SetPhysicsObject(new PhysicsObject(&enemy->GetTransform(), enemy->GetBoundingVolume()));
+	enemy->AddPhysicsObject();
 
 	enemy->GetPhysicsObject()->SetInverseMass(inverseMass);
 	enemy->GetPhysicsObject()->InitSphereInertia();
@@ -766,9 +978,9 @@ GameObject* TutorialGame::AddBonusToWorld(const Vector3& position, const Quatern
 		.SetPosition(position)
 		.SetOrientation(rot);
 
-	coin->SetRenderObject(new RenderObject(&coin->GetTransform(), bonusMesh, nullptr, basicShader));
+	coin->AddRenderObject(bonusMesh, nullptr, basicShader);
 	coin->GetRenderObject()->SetColour(Vector4(1, 1, 0, 1));
-	coin->SetPhysicsObject(new PhysicsObject(&coin->GetTransform(), coin->GetBoundingVolume()));
+	coin->AddPhysicsObject();
 
 	coin->GetPhysicsObject()->SetInverseMass(1.0f);
 	coin->GetPhysicsObject()->InitSphereInertia();
@@ -786,9 +998,9 @@ Goal* TutorialGame::AddGoal(const Vector3& position) {
 	goal->GetTransform()
 		.SetScale(Vector3(1, 10, 1))
 		.SetPosition(position);
-	goal->SetRenderObject(new RenderObject(&goal->GetTransform(), cubeMesh, nullptr, basicShader));
+	goal->AddRenderObject(cubeMesh, nullptr, basicShader);
 	goal->GetRenderObject()->SetColour(Vector4(0.5, 0.2f, 0, 1));
-	goal->SetPhysicsObject(new PhysicsObject(&goal->GetTransform(), goal->GetBoundingVolume()));
+	goal->AddPhysicsObject();
 
 	goal->GetPhysicsObject()->SetInverseMass(0);
 	goal->GetPhysicsObject()->InitSphereInertia();
@@ -802,9 +1014,9 @@ Goal* TutorialGame::AddGoal(const Vector3& position) {
 	flag->GetTransform()
 		.SetScale(Vector3(0.1f, 2, 4))
 		.SetPosition(position + Vector3(0, 3.5f,-1.5f));
-	flag->SetRenderObject(new RenderObject(&flag->GetTransform(), cubeMesh, nullptr, basicShader));
+	flag->AddRenderObject(cubeMesh, nullptr, basicShader);
 	flag->GetRenderObject()->SetColour(Vector4(1, 0, 0, 1));
-	flag->SetPhysicsObject(new PhysicsObject(&flag->GetTransform(), flag->GetBoundingVolume()));
+	flag->AddPhysicsObject();
 
 	flag->GetPhysicsObject()->SetInverseMass(0);
 	flag->GetPhysicsObject()->InitSphereInertia();
@@ -837,17 +1049,16 @@ bool TutorialGame::SelectObject() {
 		//renderer->DrawString("Press Q to change to camera mode!", Vector2(5, 85));
 
 		if (Window::GetMouse()->ButtonPressed(NCL::MouseButtons::LEFT)) {
-			if (selectionObject) {	//set colour to deselected;
-				selectionObject = nullptr;
-				lockedObject	= nullptr;
-			}
+			selectionHandle = GameObjectHandle();
+			lockedHandle	= GameObjectHandle();
 
 			Ray ray = CollisionDetection::BuildRayFromMouse(*world->GetMainCamera());
 
 			RayCollision closestCollision;
 			if (world->Raycast(ray, closestCollision, true)) {
-				selectionObject = (GameObject*)closestCollision.node;
-				selectionObject->OnSelect();
+				GameObject* selected = (GameObject*)closestCollision.node;
+				selectionHandle = selected->GetHandle();
+				selected->OnSelect();
 				return true;
 			}
 			else {
@@ -861,8 +1072,9 @@ bool TutorialGame::SelectObject() {
 		renderer->DrawString("or click on the purple buttons!", Vector2(5, 95));
 	}
 
+	GameObject* selectionObject = GetSelectionObject();
 	if(selectionObject){
-		renderer->DrawString("Name: " + selectionObject->GetName(), Vector2(1, 75));
+		renderer->DrawString("Name: " + selectionObject->GetName().GetString(), Vector2(1, 75));
 		Transform trans = selectionObject->GetTransform();
 		Vector3 pos = trans.GetPosition();
 		renderer->DrawString("Position: " + std::to_string(int(pos.x)) + ", " +
@@ -889,6 +1101,7 @@ line - after the third, they'll be able to twist under torque aswell.
 void TutorialGame::MoveSelectedObject() {
 	forceMagnitude += Window::GetMouse()->GetWheelMovement() * 100.0f;
 
+	GameObject* selectionObject = GetSelectionObject();
 	if (!selectionObject)
 		return;
 
@@ -903,11 +1116,167 @@ void TutorialGame::MoveSelectedObject() {
 	}
 }
 
+/*
+Saves everything but the player out as cells, then rebuilds the level with
+just the player in it, leaving the streamer to bring the rest back in as
+the player moves around. Pressing it again rebuilds the level normally.
+*/
+void TutorialGame::ToggleLevelStreaming() {
+	const float cellSize = 40.0f;
+
+	if (streamer) {
+		level == 2 ? InitLevel2() : InitLevel1();
+		std::cout << "Stopped streaming level " << level << std::endl;
+		return;
+	}
+	if (!player) {
+		return;
+	}
+	string prefix		= Assets::GetTempDir() + "level" + std::to_string(level) + "_cell";
+	PlayerObj* keep		= player;
+	Vector3 playerPos	= player->GetTransform().GetPosition();
+	int cellCount = WorldStreamer::SaveCells(*world, *this, prefix, cellSize, [&](GameObject* o) { return o != keep; });
+
+	int currentLevel	= level;
+	bool currentControl = controlBall;
+	ClearWorld();
+	level		= currentLevel;
+	controlBall = currentControl;
+	enemy		= nullptr;
+	AddPlayerToWorld(playerPos);
+
+	streamer = new WorldStreamer(*world, *this, prefix, cellSize);
+	streamer->SetRadius(cellSize * 1.5f, cellSize * 2.0f);
+	streamer->SetBudgets(16, 16);
+	std::cout << "Streaming level " << level << " from " << cellCount << " cells" << std::endl;
+}
+
+unsigned int TutorialGame::GetObjectType(GameObject* o) {
+	if (dynamic_cast<Switch*>(o))			 return SceneSwitch;
+	if (dynamic_cast<VerticalBlocker*>(o))	 return SceneVerticalBlocker;
+	if (dynamic_cast<HorizontalBlocker*>(o)) return SceneHorizontalBlocker;
+	if (dynamic_cast<PlayerObj*>(o))		 return ScenePlayer;
+	if (dynamic_cast<Enemy*>(o))			 return SceneEnemy;
+	if (dynamic_cast<Coin*>(o))				 return SceneCoin;
+	if (dynamic_cast<Goal*>(o))				 return SceneGoal;
+	return ScenePlainObject;
+}
+
+int TutorialGame::GetMeshID(const MeshGeometry* m) {
+	if (std::find(heightfieldMeshes.begin(), heightfieldMeshes.end(), m) != heightfieldMeshes.end()) {
+		return SCENE_GENERATED_MESH;
+	}
+	std::vector<OGLMesh*> meshes = GetSceneMeshes();
+	auto i = std::find(meshes.begin(), meshes.end(), m);
+	return (m && i != meshes.end()) ? (int)(i - meshes.begin()) : SCENE_NO_ASSET;
+}
+
+int TutorialGame::GetTextureID(const TextureBase* t) {
+	return (t && t == basicTex) ? 0 : SCENE_NO_ASSET;
+}
+
+int TutorialGame::GetShaderID(const ShaderBase* s) {
+	return (s && s == basicShader) ? 0 : SCENE_NO_ASSET;
+}
+
+void TutorialGame::WriteUserData(int* userData) {
+	userData[0] = level;
+	userData[1] = controlBall ? 1 : 0;
+}
+
+GameObject* TutorialGame::CreateObject(unsigned int type, const std::string& name) {
+	switch (type) {
+		case SceneSwitch:				return new Switch(name);
+		case SceneVerticalBlocker:		return new VerticalBlocker();
+		case SceneHorizontalBlocker:	return new HorizontalBlocker();
+		case ScenePlayer:				return new PlayerObj(name);
+		case SceneEnemy:				return new Enemy(pathNodes, player, world, playerField, navOffset);	//The player is never streamed, so won't change under us
+		case SceneCoin:					return new Coin(name);
+		case SceneGoal:					return new Goal(name);
+		default:						return new GameObject(name);
+	}
+}
+
+MeshGeometry* TutorialGame::GetMesh(int id) {
+	std::vector<OGLMesh*> meshes = GetSceneMeshes();
+	return (id >= 0 && id < (int)meshes.size()) ? meshes[id] : nullptr;
+}
+
+TextureBase* TutorialGame::GetTexture(int id) {
+	return id == 0 ? basicTex : nullptr;
+}
+
+ShaderBase* TutorialGame::GetShader(int id) {
+	return id == 0 ? basicShader : nullptr;
+}
+
+MeshGeometry* TutorialGame::CreateGeneratedMesh(GameObject* o) {
+	const CollisionVolume* volume = o->GetBoundingVolume();
+	if (!volume || volume->type != VolumeType::Heightfield) {
+		return nullptr;
+	}
+	return BuildHeightfieldMesh((const HeightfieldVolume*)volume);
+}
+
+void TutorialGame::ReadUserData(const int* userData) {
+	level		= userData[0];
+	controlBall = userData[1] != 0;
+}
+
+//Hooks loaded objects up to the game, the same way the AddXToWorld functions do
+void TutorialGame::ObjectLoaded(GameObject* o, unsigned int type) {
+	switch (type) {
+		case SceneVerticalBlocker:
+		case SceneHorizontalBlocker: {
+			stateObjects.emplace_back((StateGameObject*)o);
+		}break;
+		case ScenePlayer: {
+			player = (PlayerObj*)o;
+			physics->AddLODObserver(player);
+		}break;
+		case SceneEnemy: {
+			enemy = (Enemy*)o;
+			stateObjects.emplace_back(enemy);
+		}break;
+	}
+}
+
+void TutorialGame::ObjectUnloading(GameObject* o) {
+	stateObjects.erase(std::remove_if(stateObjects.begin(), stateObjects.end(),
+		[&](StateGameObject* s) { return (GameObject*)s == o; }), stateObjects.end());
+	if (o == enemy) {
+		enemy = nullptr;
+	}
+}
+
+//The switch is in the same cell, and outlasts the spring by a frame or two while the cell empties
+void TutorialGame::ConstraintUnloading(Constraint* c) {
+	pushers.erase(std::remove(pushers.begin(), pushers.end(), c), pushers.end());
+	Spring* spr = dynamic_cast<Spring*>(c);
+	if (!spr) {
+		return;
+	}
+	Switch* s = dynamic_cast<Switch*>(spr->GetObjectA());
+	if (s && s->GetSpring() == spr) {
+		s->SetSpring(nullptr);
+	}
+}
+
+void TutorialGame::ConstraintLoaded(Constraint* c) {
+	Spring* spr = dynamic_cast<Spring*>(c);
+	if (!spr) {
+		return;
+	}
+	if (Switch* s = dynamic_cast<Switch*>(spr->GetObjectA())) {
+		s->SetSpring(spr);
+	}
+	pushers.emplace_back(spr);
+}
+
 void TutorialGame::PathFind(Vector3 from, Vector3 to) {
-	NavigationGrid grid("TestGrid1.txt");
 	pathNodes.clear();
 	NavigationPath outPath;
-	bool found = grid.FindPath(from, to, outPath);
+	bool found = pathCache->FindPath(from, to, outPath);
 	Vector3 pos;
 	while (outPath.PopWaypoint(pos)) {
 		pathNodes.push_back(pos);
@@ -1,6 +1,7 @@
 #pragma once
 #include "GameTechRenderer.h"
 #include "../CSC8503Common/PhysicsSystem.h"
+#include "../CSC8503Common/SceneFile.h"
 
 namespace NCL {
 	namespace CSC8503 {
@@ -11,7 +12,11 @@ namespace NCL {
 		class PlayerObj;
 		class Enemy;
 		class Goal;
-		class TutorialGame		{
+		class WorldStreamer;
+		class NavigationGrid;
+		class NavigationPathCache;
+		class FlowField;
+		class TutorialGame : protected SceneContext	{
 		public:
 			TutorialGame();
 			~TutorialGame();
@@ -20,6 +25,8 @@ namespace NCL {
 
 			void InitLevel1();
 			void InitLevel2();
+			//Loads a level saved by SceneFile::Save, rather than building it in code
+			bool InitLevelFromFile(const string& filename);
 			void Menu(int option, float dt);
 			void ShowScore(bool won, float dt);
 			void ClearWorld();
@@ -41,10 +48,50 @@ namespace NCL {
 			void DebugDrawCollider(const CollisionVolume* c, Transform* worldTransform);
 			void DebugDrawCapsule(CapsuleVolume* a, Transform* worldTransform);
 
+			void BenchmarkSnapshots();
+			void BenchmarkClosestPoints();
+			void BenchmarkWorlds();
+			void CheckWorldCommands();
+			void BenchmarkLevelLoading();
+			void BenchmarkPathfinding();
+			//Splits the current level into cells, and streams them in and out around the player
+			void ToggleLevelStreaming();
+
+			//What each kind of object is saved as in a scene file
+			enum SceneObjectType {
+				ScenePlainObject,
+				SceneSwitch,
+				SceneVerticalBlocker,
+				SceneHorizontalBlocker,
+				ScenePlayer,
+				SceneEnemy,
+				SceneCoin,
+				SceneGoal
+			};
+
+			unsigned int	GetObjectType(GameObject* o) override;
+			int				GetMeshID(const MeshGeometry* m) override;
+			int				GetTextureID(const TextureBase* t) override;
+			int				GetShaderID(const ShaderBase* s) override;
+			void			WriteUserData(int* userData) override;
+
+			GameObject*		CreateObject(unsigned int type, const std::string& name) override;
+			MeshGeometry*	GetMesh(int id) override;
+			TextureBase*	GetTexture(int id) override;
+			ShaderBase*		GetShader(int id) override;
+			MeshGeometry*	CreateGeneratedMesh(GameObject* o) override;
+			void			ReadUserData(const int* userData) override;
+			void			ObjectLoaded(GameObject* o, unsigned int type) override;
+			void			ConstraintLoaded(Constraint* c) override;
+			void			ObjectUnloading(GameObject* o) override;
+			void			ConstraintUnloading(Constraint* c) override;
+
 			void PathFind(Vector3 from, Vector3 to);
 			void DebugDisplayPath();
 
 			GameObject* AddFloorToWorld(const Vector3& position, const Vector3& dims, const Quaternion& rotation, float elasticity = 0.5f, Vector4 col = Vector4(1,1,1,1), string name = "Floor");
+			GameObject* AddHeightfieldToWorld(const Vector3& position, int samplesX, int samplesZ, float cellSize, const std::vector<float>& heights, float elasticity = 0.5f, Vector4 col = Vector4(1,1,1,1));
+			OGLMesh*	BuildHeightfieldMesh(const HeightfieldVolume* volume);
 			GameObject* AddSphereToWorld(const Vector3& position, float radius, float inverseMass = 10.0f, float elasticity = 0.66f, int layer = Layer::Other);
 			GameObject* AddCubeToWorld(const Vector3& position, Vector3 dimensions, bool axisAligned,float inverseMass = 10.0f, int layer = Layer::Other);
 			GameObject* AddSwitchToWorld(const Vector3& position);
@@ -63,6 +110,8 @@ namespace NCL {
 			GameTechRenderer*	renderer;
 			PhysicsSystem*		physics;
 			GameWorld*			world;
+			ComponentScope*		worldScope;	//Everything the game makes goes in the world's component stores
+			WorldStreamer*		streamer = nullptr;
 
 			std::vector<Spring*> pushers;
 			std::vector<StateGameObject*> stateObjects;
@@ -74,7 +123,11 @@ namespace NCL {
 
 			float		forceMagnitude;
 
-			GameObject* selectionObject = nullptr;
+			//Handles rather than pointers, so objects can leave the world while selected
+			GameObjectHandle selectionHandle;
+			GameObject* GetSelectionObject() const {
+				return world->GetObject(selectionHandle);
+			}
 
 			OGLMesh*	capsuleMesh = nullptr;
 			OGLMesh*	cubeMesh	= nullptr;
@@ -82,6 +135,13 @@ namespace NCL {
 			OGLTexture* basicTex	= nullptr;
 			OGLShader*	basicShader = nullptr;
 
+			std::vector<OGLMesh*> heightfieldMeshes;
+
+			//Every mesh a scene file can refer to, with each one's ID being its index
+			std::vector<OGLMesh*> GetSceneMeshes() const {
+				return { cubeMesh, sphereMesh, charMeshA, charMeshB, enemyMesh, bonusMesh, capsuleMesh };
+			}
+
 			//Coursework Meshes
 			OGLMesh*	charMeshA	= nullptr;
 			OGLMesh*	charMeshB	= nullptr;
@@ -89,23 +149,33 @@ namespace NCL {
 			OGLMesh*	bonusMesh	= nullptr;
 
 			//Coursework Additional functionality	
-			GameObject* lockedObject	= nullptr;
+			GameObjectHandle lockedHandle;
 			Vector3 lockedOffset		= Vector3(0, 14, 20);
 			void LockCameraToObject(GameObject* o) {
-				lockedObject = o;
+				lockedHandle = o ? o->GetHandle() : GameObjectHandle();
+			}
+			GameObject* GetLockedObject() const {
+				return world->GetObject(lockedHandle);
 			}
 
 			GameTimer* timer;
+
+			AllocationStats levelStartStats;	//So F11 can show what gameplay has allocated since
+			bool reportLevelLoads = true;
 			float finishTime;
 			int finishScore;
 
 			PlayerObj* player;
 			Enemy* enemy;
 			std::vector<Vector3> validSpawnPositions;
-			std::vector<GameObject*> collectables;
+			std::vector<GameObjectHandle> collectables;	//Handles, as level switches and streaming can delete them under us
 			float coinSpawnTimer;
 
 			std::vector<Vector3> pathNodes;
+			NavigationGrid*			navGrid;	//Loaded once with the other assets, and shared by every search
+			NavigationPathCache*	pathCache;
+			FlowField*				playerField;	//Leads anything chasing the player to it, without searches of their own
+			Vector3					navOffset = Vector3(10, 0, 10);	//From world positions to the grid's
 
 			bool controlBall;
 			bool collectableInWorld = false;
@@ -0,0 +1,830 @@
+/*
+The debug key benchmarks, kept apart from the rest of the game. Each one builds
+whatever it needs for itself, and prints its results to the console.
+*/
+#include "TutorialGame.h"
+#include "../CSC8503Common/GameWorld.h"
+#include "../../Common/Assets.h"
+#include "../../Common/Maths.h"
+#include "../CSC8503Common/PhysicsHistory.h"
+#include "../CSC8503Common/ClosestPoint.h"
+#include "../CSC8503Common/WorldScheduler.h"
+#include "../CSC8503Common/NavigationGrid.h"
+#include "../CSC8503Common/NavigationPath.h"
+#include "../CSC8503Common/NavigationPathCache.h"
+#include "../CSC8503Common/JumpPointSearch.h"
+#include "../CSC8503Common/HierarchicalGrid.h"
+#include "../CSC8503Common/NavigationMesh.h"
+#include "../CSC8503Common/FlowField.h"
+#include <iostream>
+#include <random>
+#include <cassert>
+#include <cstdio>
+#include <thread>
+
+using namespace NCL;
+using namespace CSC8503;
+
+/*
+The capsule tests as they were before ClosestPoint, kept here only so the
+closest point benchmark has something to compare the new ones against. The
+box one used to draw a debug line on every call, which has been left out so
+it isn't timing the line drawing.
+*/
+namespace {
+	bool OldOBBCapsuleIntersection(const OBBVolume& volumeA, const Transform& worldTransformA,
+		const CapsuleVolume& volumeB, const Transform& worldTransformB, CollisionDetection::CollisionInfo& collisionInfo) {
+		Quaternion boxRot = worldTransformA.GetOrientation();
+		Matrix3 boxInvTransform = Matrix3(boxRot.Conjugate());
+		Vector3 boxSize = volumeA.GetHalfDimensions();
+
+		Quaternion capRot = worldTransformB.GetOrientation();
+		Vector3 position = worldTransformA.GetPosition() - worldTransformB.GetPosition();
+
+		Vector3 capsuleUpVec = boxInvTransform * (capRot * Vector3(0, 1, 0));
+
+		//Project sphere's position onto capsuleline using dot product
+		float t = Vector3::Dot((position).Normalised(), capsuleUpVec.Normalised());
+		Vector3 closestPointOnLine = (position + capsuleUpVec * min(max(t, -1.0f), 1.0f));
+
+		Vector3 closestPointOnBox = Maths::Clamp(closestPointOnLine, -boxSize, boxSize);
+		Vector3 localPoint = (closestPointOnLine - closestPointOnBox);
+		float distance = Vector3::Distance(closestPointOnBox, closestPointOnLine);
+
+		if (distance < volumeB.GetRadius()) {
+			Vector3 collisionNormal = boxRot * (localPoint.Normalised());
+			float penetration = (volumeB.GetRadius() - distance);
+
+			Vector3 localA = boxRot * closestPointOnBox;
+			Vector3 localB = capRot * closestPointOnLine;
+
+			collisionInfo.AddContactPoint(localA, localB, collisionNormal, penetration);
+			return true;
+		}
+		return false;
+	}
+
+	bool OldCapsuleIntersection(const CapsuleVolume& volumeA, const Transform& worldTransformA,
+		const CapsuleVolume& volumeB, const Transform& worldTransformB, CollisionDetection::CollisionInfo& collisionInfo) {
+		Quaternion rotA = worldTransformA.GetOrientation();
+		Vector3 posA = worldTransformA.GetPosition();
+		Quaternion rotB = worldTransformB.GetOrientation();
+		Vector3 posB = worldTransformB.GetPosition();
+		Vector3 aAxis = (rotA * Vector3(0, 1, 0)).Normalised();
+		Vector3 bAxis = (rotB * Vector3(0, 1, 0)).Normalised();
+
+		//Closest point on two lines algorithm from: https://wickedengine.net/2020/04/26/capsule-collision-detection/
+		Vector3 aTop = posA + aAxis * (volumeA.GetHalfHeight() - volumeA.GetRadius());
+		Vector3 aBot = posA - aAxis * (volumeA.GetHalfHeight() - volumeA.GetRadius());
+		Vector3 bTop = posB + bAxis * (volumeB.GetHalfHeight() - volumeB.GetRadius());
+		Vector3 bBot = posB - bAxis * (volumeB.GetHalfHeight() - volumeB.GetRadius());
+		//Vectors between capsule endpoints
+		Vector3 bTaT = bTop - aTop;
+		Vector3 bBaT = bBot - aTop;
+		Vector3 bTaB = bTop - aBot;
+		Vector3 bBaB = bBot - aBot;
+		//Square Distances
+		float bTaTSqrDist = Vector3::Dot(bTaT, bTaT);
+		float bBaTSqrDist = Vector3::Dot(bBaT, bBaT);
+		float bTaBSqrDist = Vector3::Dot(bTaB, bTaB);
+		float bBaBSqrDist = Vector3::Dot(bBaB, bBaB);
+
+		//Finding closest points on vectors a and b
+		Vector3 bestA;
+		if (bTaBSqrDist < bTaTSqrDist || bTaBSqrDist < bBaTSqrDist
+			|| bBaBSqrDist < bTaTSqrDist || bBaBSqrDist < bBaTSqrDist)
+			bestA = aBot;
+		else
+			bestA = aTop;
+
+		float t = Vector3::Dot((bestA - posB), bAxis);
+		Vector3 bestB = posB + bAxis * min(max(t, -1.0f), 1.0f);
+		t = Vector3::Dot((bestB - posA), aAxis);
+		bestA = posA + aAxis * min(max(t, -1.0f), 1.0f);
+
+		//Sphere-Sphere Collision Detection
+		float radii = volumeA.GetRadius() + volumeB.GetRadius();
+		Vector3 delta = bestB - bestA;
+		float deltaLength = Vector3::Distance(bestA, bestB);
+
+		//If within range, get details of collision by doing a sphere-sphere collision
+		if (deltaLength < radii) {
+			float penetration = (radii - deltaLength);
+			Vector3 normal = delta.Normalised();
+			Vector3 localA = bestA - posA + (normal) * volumeA.GetRadius();
+			Vector3 localB = bestB - posB - normal * volumeB.GetRadius();
+			collisionInfo.AddContactPoint(localA, localB, normal, penetration);
+			return true;
+		}
+		return false;
+	}
+
+	bool OldSphereCapsuleIntersection(const CapsuleVolume& volumeA, const Transform& worldTransformA,
+		const SphereVolume& volumeB, const Transform& worldTransformB, CollisionDetection::CollisionInfo& collisionInfo) {
+		Quaternion orientation = worldTransformA.GetOrientation();
+		Vector3 position = worldTransformA.GetPosition();
+		Matrix3 transform = Matrix3(orientation);
+
+		Vector3 capsuleUpVec = transform * Vector3(0, 1, 0);
+
+		//Project sphere's position onto capsuleline using dot product
+		Vector3 sphereCenter = worldTransformB.GetPosition();
+		float t = Vector3::Dot((sphereCenter - position).Normalised(), capsuleUpVec.Normalised());
+		Vector3 closestPointOnLine = position + capsuleUpVec * min(max(t, -1.0f), 1.0f);
+
+		float radii = volumeA.GetRadius() + volumeB.GetRadius();
+		Vector3 delta = sphereCenter - closestPointOnLine;
+		float deltaLength = Vector3::Distance(sphereCenter, closestPointOnLine);
+		//If within range, get details of collision by doing a sphere-sphere collision
+		if (deltaLength < radii) {
+			float penetration = radii - deltaLength;
+			Vector3 normal = delta.Normalised();
+			Vector3 localA = closestPointOnLine - position + (normal * volumeA.GetRadius());
+			Vector3 localB = (-normal * volumeB.GetRadius());
+
+			collisionInfo.AddContactPoint(localA, localB, normal, penetration);
+			return true;
+		}
+		return false;
+	}
+}
+
+/*
+Times saving and restoring the state of a large number of bodies, so we can keep
+an eye on how expensive rollback gets. It uses its own world, so the game isn't
+disturbed. A tenth of the bodies move each frame, so most saves are deltas.
+*/
+void TutorialGame::BenchmarkSnapshots() {
+	const int bodyCount		= 10000;
+	const int frameCount	= 100;
+
+	GameWorld testWorld;
+	ComponentScope componentScope(testWorld.GetComponents());
+	for (int i = 0; i < bodyCount; ++i) {
+		GameObject* o = new GameObject();
+		o->GetTransform().SetPosition(Vector3((float)(i % 100), 0.0f, (float)(i / 100)));
+		o->SetBoundingVolume((CollisionVolume*)new SphereVolume(0.5f));
+		o->AddPhysicsObject();
+		testWorld.AddGameObject(o);
+	}
+	GameObjectIterator first;
+	GameObjectIterator last;
+	testWorld.GetObjectIterators(first, last);
+
+	PhysicsHistory history(frameCount);
+	std::set<CollisionDetection::CollisionInfo> contacts;
+	float offset = 0.0f;
+
+	GameTimer t;
+	float saveTime = 0.0f;
+	for (int f = 0; f < frameCount; ++f) {
+		for (int i = f % 10; i < bodyCount; i += 10) {
+			Transform& transform = first[i]->GetTransform();
+			transform.SetPosition(transform.GetPosition() + Vector3(0, 0.1f, 0));
+		}
+		t.Tick();
+		history.Save(testWorld, contacts, offset);
+		t.Tick();
+		saveTime += t.GetTimeDeltaMSec();
+	}
+
+	//Restoring a frame drops everything after it, so go backwards
+	int oldest		= history.GetLatestFrame() - frameCount + 1;
+	int deltaFrame	= oldest + 9;	//The frame with the most deltas to replay
+	t.Tick();
+	bool restoredDelta = history.Restore(deltaFrame, testWorld, contacts, offset);
+	t.Tick();
+	float deltaTime = t.GetTimeDeltaMSec();
+
+	t.Tick();
+	bool restoredOldest = history.Restore(oldest, testWorld, contacts, offset);
+	t.Tick();
+	float oldestTime = t.GetTimeDeltaMSec();
+
+	std::cout << "Snapshot benchmark, " << bodyCount << " bodies, " << frameCount << " frames:" << std::endl;
+	std::cout << "  Average save: " << saveTime / frameCount << "ms" << std::endl;
+	std::cout << "  Restore keyframe: " << oldestTime << "ms" << (restoredOldest ? "" : " (FAILED)") << std::endl;
+	std::cout << "  Restore keyframe + 9 deltas: " << deltaTime << "ms" << (restoredDelta ? "" : " (FAILED)") << std::endl;
+	std::cout << "  History memory: " << history.GetMemoryUsed() / 1024 << "KB" << std::endl;
+
+	testWorld.ClearAndErase();
+}
+
+/*
+Checks the closest point library against brute force sampling of the
+same segments, and then times the capsule tests built on it against the
+old ones they replaced. The hit counts won't always match, as the old
+ones could miss the closest points and so some touching pairs.
+*/
+void TutorialGame::BenchmarkClosestPoints() {
+	const int accuracyTests	= 1000;
+	const int samples		= 1000;
+	const int timingTests	= 100000;
+
+	auto randomPoint = []() {
+		return Vector3((float)(rand() % 2000) / 100.0f - 10.0f, (float)(rand() % 2000) / 100.0f - 10.0f, (float)(rand() % 2000) / 100.0f - 10.0f);
+	};
+
+	float worstSegment	= 0.0f;
+	float worstBox		= 0.0f;
+	for (int i = 0; i < accuracyTests; ++i) {
+		Vector3 p1 = randomPoint();
+		Vector3 q1 = randomPoint();
+		Vector3 p2 = randomPoint();
+		Vector3 q2 = randomPoint();
+		Vector3 halfSize = Vector3(abs(p2.x), abs(p2.y), abs(p2.z)) * 0.5f;
+
+		Vector3 c1;
+		Vector3 c2;
+		float s;
+		float t;
+		ClosestPoint::SegmentSegment(p1, q1, p2, q2, c1, c2, s, t);
+		float segmentDist = (c1 - c2).Length();
+		float boxDist = sqrt(ClosestPoint::SegmentBox(p1, q1, halfSize, c1, c2));
+
+		//Brute force, sampling every segment pair
+		float bestSegment	= FLT_MAX;
+		float bestBox		= FLT_MAX;
+		for (int a = 0; a <= samples; ++a) {
+			Vector3 pointA = p1 + (q1 - p1) * ((float)a / samples);
+			Vector3 onBox = Maths::Clamp(pointA, -halfSize, halfSize);
+			bestBox = min(bestBox, (pointA - onBox).Length());
+			for (int b = 0; b <= samples; b += 10) {
+				Vector3 pointB = p2 + (q2 - p2) * ((float)b / samples);
+				bestSegment = min(bestSegment, (pointA - pointB).Length());
+			}
+		}
+		//The library should never be further apart than the best sample found
+		worstSegment	= max(worstSegment, segmentDist - bestSegment);
+		worstBox		= max(worstBox, boxDist - bestBox);
+	}
+
+	CapsuleVolume	capsule(2.0f, 0.5f);
+	OBBVolume		box(Vector3(1, 1, 1));
+	SphereVolume	sphere(0.5f);
+	std::vector<Transform> transforms(timingTests);
+	for (Transform& transform : transforms) {
+		transform.SetPosition(randomPoint() * 0.2f).SetOrientation(Quaternion::EulerAnglesToQuaternion((float)(rand() % 360), (float)(rand() % 360), 0));
+	}
+	Transform origin;
+
+	//Runs one test over every transform, returning how long it took and how many hit
+	auto timeTest = [&](auto test, int& hits) {
+		GameTimer timer;
+		hits = 0;
+		timer.Tick();
+		for (const Transform& transform : transforms) {
+			CollisionDetection::CollisionInfo info;
+			hits += test(transform, info) ? 1 : 0;
+		}
+		timer.Tick();
+		return timer.GetTimeDeltaMSec();
+	};
+
+	struct TimingResult {
+		const char* name;
+		float		oldTime;
+		float		newTime;
+		int			oldHits;
+		int			newHits;
+	};
+	TimingResult results[3];
+
+	results[0].name		= "capsule / capsule";
+	results[0].oldTime	= timeTest([&](const Transform& t, CollisionDetection::CollisionInfo& info) {
+		return OldCapsuleIntersection(capsule, origin, capsule, t, info);
+	}, results[0].oldHits);
+	results[0].newTime	= timeTest([&](const Transform& t, CollisionDetection::CollisionInfo& info) {
+		return CollisionDetection::CapsuleIntersection(capsule, origin, capsule, t, info);
+	}, results[0].newHits);
+
+	results[1].name		= "box / capsule";
+	results[1].oldTime	= timeTest([&](const Transform& t, CollisionDetection::CollisionInfo& info) {
+		return OldOBBCapsuleIntersection(box, origin, capsule, t, info);
+	}, results[1].oldHits);
+	results[1].newTime	= timeTest([&](const Transform& t, CollisionDetection::CollisionInfo& info) {
+		return CollisionDetection::OBBCapsuleIntersection(box, origin, capsule, t, info);
+	}, results[1].newHits);
+
+	results[2].name		= "sphere / capsule";
+	results[2].oldTime	= timeTest([&](const Transform& t, CollisionDetection::CollisionInfo& info) {
+		return OldSphereCapsuleIntersection(capsule, origin, sphere, t, info);
+	}, results[2].oldHits);
+	results[2].newTime	= timeTest([&](const Transform& t, CollisionDetection::CollisionInfo& info) {
+		return CollisionDetection::SphereCapsuleIntersection(capsule, origin, sphere, t, info);
+	}, results[2].newHits);
+
+	std::cout << "Closest point benchmark:" << std::endl;
+	std::cout << "  Worst segment / segment error: " << worstSegment << std::endl;
+	std::cout << "  Worst segment / box error: " << worstBox << std::endl;
+	for (const TimingResult& r : results) {
+		std::cout << "  " << timingTests << " " << r.name << " tests: old " << r.oldTime << "ms (" << r.oldHits << " hits), new "
+			<< r.newTime << "ms (" << r.newHits << " hits), " << (r.newTime > 0.0f ? r.oldTime / r.newTime : 0.0f) << "x" << std::endl;
+	}
+}
+
+/*
+Builds a number of small test worlds, each a pile of spheres dropped onto a
+floor, and times stepping them all together - first on this thread alone,
+and then spread over every core through a WorldScheduler.
+*/
+void TutorialGame::BenchmarkWorlds() {
+	const int worldCounts[]		= { 1, 8, 32 };
+	const int spheresPerWorld	= 100;
+	const int steps				= 120;
+	const float stepDT			= 1.0f / 60.0f;
+
+	std::cout << "World scheduler benchmark, " << spheresPerWorld << " spheres per world, " << steps << " steps:" << std::endl;
+
+	for (int worldCount : worldCounts) {
+		float times[2];
+		int cores = (int)std::thread::hardware_concurrency();
+		int threadCounts[2] = { 1, cores > 0 ? cores : 1 };
+
+		for (int run = 0; run < 2; ++run) {
+			std::vector<GameWorld*>		testWorlds;
+			std::vector<PhysicsSystem*> testPhysics;
+			WorldScheduler scheduler(threadCounts[run]);
+
+			for (int w = 0; w < worldCount; ++w) {
+				GameWorld* testWorld = new GameWorld();
+				testWorld->SetRandomSeed(w);
+				ComponentScope componentScope(testWorld->GetComponents());	//So each world walks only its own
+
+				GameObject* floor = new GameObject("Floor", Layer::StaticObjects);
+				floor->SetBoundingVolume((CollisionVolume*)new AABBVolume(Vector3(50, 1, 50)));
+				floor->GetTransform().SetPosition(Vector3(0, -1, 0));
+				floor->AddPhysicsObject();
+				floor->GetPhysicsObject()->SetInverseMass(0);
+				testWorld->AddGameObject(floor);
+
+				for (int i = 0; i < spheresPerWorld; ++i) {
+					GameObject* sphere = new GameObject();
+					sphere->SetBoundingVolume((CollisionVolume*)new SphereVolume(1.0f));
+					sphere->GetTransform().SetPosition(Vector3((float)(i % 10) * 3.0f - 15.0f, 2.0f + (float)(i / 10) * 3.0f, (float)(w % 4)));
+					sphere->AddPhysicsObject();
+					sphere->GetPhysicsObject()->InitSphereInertia();
+					testWorld->AddGameObject(sphere);
+				}
+
+				PhysicsSystem* p = new PhysicsSystem(*testWorld);
+				p->UseGravity(true);
+				p->UseLOD(false);
+				p->UseAdaptiveTimestep(false);	//Keep the work the same however busy the cores are
+
+				testWorlds.emplace_back(testWorld);
+				testPhysics.emplace_back(p);
+				scheduler.AddWorld(testWorld, p);
+			}
+
+			GameTimer t;
+			t.Tick();
+			for (int i = 0; i < steps; ++i) {
+				scheduler.Step(stepDT);
+			}
+			t.Tick();
+			times[run] = t.GetTimeDeltaMSec();
+
+			for (int w = 0; w < worldCount; ++w) {
+				delete testPhysics[w];
+				testWorlds[w]->ClearAndErase();
+				delete testWorlds[w];
+			}
+		}
+		std::cout << "  " << worldCount << " worlds: " << times[0] << "ms on 1 thread, "
+			<< times[1] << "ms on " << threadCounts[1] << " threads ("
+			<< (worldCount * steps) / (times[1] / 1000.0f) << " world steps per second)" << std::endl;
+	}
+}
+
+namespace {
+	//Counts its own deletions, so a test can see that nothing's deleted twice
+	class CountedObject : public GameObject {
+	public:
+		CountedObject(int& deletions) : deletions(deletions) {}
+		~CountedObject() {
+			deletions++;
+		}
+	protected:
+		int& deletions;
+	};
+}
+
+/*
+Queues up the awkward orders of adds and removals that callbacks can produce,
+and checks each object ends up deleted exactly once - including one that's
+added and then removed twice in the same batch, before it ever had a handle.
+*/
+void TutorialGame::CheckWorldCommands() {
+	GameWorld testWorld;
+	ComponentScope componentScope(testWorld.GetComponents());
+	WorldCommandBuffer& commands = testWorld.GetCommands();
+	int failures = 0;
+
+	//Added and removed twice in one batch
+	int deletions = 0;
+	GameObject* o = new CountedObject(deletions);
+	commands.AddGameObject(o);
+	commands.RemoveGameObject(o, true);
+	commands.RemoveGameObject(o, true);
+	testWorld.ApplyCommands();
+	failures += deletions != 1;
+
+	//Already in the world, and removed twice in one batch
+	deletions = 0;
+	o = new CountedObject(deletions);
+	testWorld.AddGameObject(o);
+	commands.RemoveGameObject(o, true);
+	commands.RemoveGameObject(o, true);
+	testWorld.ApplyCommands();
+	failures += deletions != 1;
+
+	//Removed without deleting, then added back and deleted in the next batch
+	deletions = 0;
+	o = new CountedObject(deletions);
+	testWorld.AddGameObject(o);
+	commands.RemoveGameObject(o);
+	testWorld.ApplyCommands();
+	commands.AddGameObject(o);
+	commands.RemoveGameObject(o, true);
+	testWorld.ApplyCommands();
+	failures += deletions != 1;
+
+	GameObjectIterator first;
+	GameObjectIterator last;
+	testWorld.GetObjectIterators(first, last);
+	failures += first != last;
+
+	std::cout << "World command check: " << (failures == 0 ? "passed" : "FAILED") << std::endl;
+	assert(failures == 0);
+	testWorld.ClearAndErase();
+}
+
+/*
+Builds each level the usual way a number of times, then saves it out and
+loads it back from the file the same number of times, to compare the two.
+The files go in the temp folder, and are deleted once they've been timed,
+so the game's own data is never touched. The level that was being played
+is rebuilt at the end.
+*/
+void TutorialGame::BenchmarkLevelLoading() {
+	const int runs = 20;
+	int currentLevel = level;
+	reportLevelLoads = false;
+
+	std::cout << "Level loading benchmark, " << runs << " loads each:" << std::endl;
+	for (int l = 1; l <= 2; ++l) {
+		string filename = Assets::GetTempDir() + "level" + std::to_string(l) + "_benchmark.scene";
+
+		GameTimer t;
+		t.Tick();
+		for (int i = 0; i < runs; ++i) {
+			l == 1 ? InitLevel1() : InitLevel2();
+		}
+		t.Tick();
+		float builtTime = t.GetTimeDeltaMSec();
+
+		if (!SceneFile::Save(filename, *world, *this)) {
+			continue;
+		}
+		t.Tick();
+		bool loaded = true;
+		for (int i = 0; i < runs && loaded; ++i) {
+			loaded = InitLevelFromFile(filename);
+		}
+		t.Tick();
+		float loadedTime = t.GetTimeDeltaMSec();
+		std::remove(filename.c_str());
+
+		if (!loaded) {
+			continue;
+		}
+		std::cout << "  Level " << l << ": " << builtTime / runs << "ms built in code, "
+			<< loadedTime / runs << "ms loaded from " << filename
+			<< " (" << builtTime / (loadedTime > 0.0f ? loadedTime : 1.0f) << "x)" << std::endl;
+	}
+	reportLevelLoads = true;
+	currentLevel == 2 ? InitLevel2() : InitLevel1();
+}
+
+/*
+Runs the same random queries through the heap based search and the original
+list based one, on generated grids with a quarter of their nodes walled off.
+Some queries can't be reached at all, which is where the lists hurt the most,
+as the whole reachable area has to be searched before giving up. Every path
+the two find has to be the same length, so a broken heap shows up as a wrong
+answer rather than just a change in speed.
+
+Then the heap based A* goes up against Jump Point Search, with and without
+precomputed jump distances, on a mostly open grid and a cluttered one. Paths
+are measured in nodes, so they show whether every search found equally short
+routes, and the node counts show how much less work the jumps leave.
+
+Hierarchical search is then tried against A* on a big grid, refining the whole
+path or just its first leg, and on a 2000x2000 grid that would need far too
+much memory as a NavigationGrid, where changing a node shows how much less a
+local rebuild costs than building the whole thing.
+
+The navigation mesh runs queries between random triangles, showing how many
+triangles each path crosses against how few waypoints are left once the
+funnel has pulled it straight.
+
+After that, an enemy chases a wandering target across a grid, asking for a new
+path every frame like UpdateGame does for one after a collectable, with and
+without a path cache. Lastly, a crowd of agents chase one target, each with its
+own search every frame, then all sharing a single flow field, as anything
+chasing the player does.
+*/
+void TutorialGame::BenchmarkPathfinding() {
+	const int gridSizes[]	= { 64, 128, 256 };
+	const int queries		= 20;
+	const int nodeSize		= 10;
+
+	std::cout << "Pathfinding benchmark, " << queries << " queries per grid:" << std::endl;
+	std::mt19937 rng(1234);
+	for (int size : gridSizes) {
+		std::string types(size * size, '.');
+		for (char& t : types) {
+			t = rng() % 4 == 0 ? 'x' : '.';
+		}
+		NavigationGrid grid(size, size, nodeSize, types);
+
+		std::vector<Vector3> ends;
+		while ((int)ends.size() < queries * 2) {
+			int node = rng() % (size * size);
+			if (types[node] != 'x') {
+				ends.emplace_back(Vector3((float)((node % size) * nodeSize), 0, (float)((node / size) * nodeSize)));
+			}
+		}
+
+		float times[2];
+		int found		= 0;
+		int mismatches	= 0;
+		std::vector<int> lengths(queries, -1);	//Nodes in each path the lists found, or -1 for none
+		for (int run = 0; run < 2; ++run) {
+			GameTimer t;
+			t.Tick();
+			for (int q = 0; q < queries; ++q) {
+				NavigationPath path;
+				bool result = run == 0 ?
+					grid.FindPathSimple(ends[q * 2], ends[q * 2 + 1], path) :
+					grid.FindPath(ends[q * 2], ends[q * 2 + 1], path);
+				int length = result ? (int)path.GetWaypoints().size() : -1;
+				if (run == 0) {
+					lengths[q] = length;
+				}
+				else {
+					found		+= result ? 1 : 0;
+					mismatches	+= length != lengths[q] ? 1 : 0;
+				}
+			}
+			t.Tick();
+			times[run] = t.GetTimeDeltaMSec();
+		}
+		std::cout << "  " << size << "x" << size << ": " << times[0] << "ms with lists, " << times[1] << "ms with a heap ("
+			<< times[0] / (times[1] > 0.0f ? times[1] : 1.0f) << "x), " << found << " paths found"
+			<< (mismatches > 0 ? ", PATH LENGTHS DIFFER!" : "") << std::endl;
+		//Both searches are optimal, so a different length means one of them is broken
+		assert(mismatches == 0);
+	}
+
+	const int wallChances[] = { 50, 4 };	//1 in this many nodes is a wall
+	const char* searchNames[] = { "A*", "JPS", "JPS+" };
+	for (int size : gridSizes) {
+		for (int wallChance : wallChances) {
+			std::string types(size * size, '.');
+			for (char& t : types) {
+				t = rng() % wallChance == 0 ? 'x' : '.';
+			}
+			NavigationGrid grid(size, size, nodeSize, types);
+			JumpPointSearch jps(grid, JumpPointSearch::Mode::Jump);
+			JumpPointSearch jpsPlus(grid, JumpPointSearch::Mode::JumpPlus);
+
+			std::vector<Vector3> ends;
+			while ((int)ends.size() < queries * 2) {
+				int node = rng() % (size * size);
+				if (types[node] != 'x') {
+					ends.emplace_back(Vector3((float)((node % size) * nodeSize), 0, (float)((node / size) * nodeSize)));
+				}
+			}
+
+			std::vector<int> lengths(queries);	//A*'s, which the jumps have to match
+			int mismatches = 0;
+
+			std::cout << "  " << size << "x" << size << ", 1 in " << wallChance << " walls:";
+			for (int run = 0; run < 3; ++run) {
+				int expanded	= 0;
+				int pathLength	= 0;
+				GameTimer t;
+				t.Tick();
+				for (int q = 0; q < queries; ++q) {
+					NavigationPath path;
+					if (run == 0) {
+						grid.FindPath(ends[q * 2], ends[q * 2 + 1], path);
+						expanded += grid.GetExpandedCount();
+					}
+					else {
+						JumpPointSearch& search = run == 1 ? jps : jpsPlus;
+						search.FindPath(ends[q * 2], ends[q * 2 + 1], path);
+						expanded += search.GetExpandedCount();
+					}
+					int length = (int)path.GetWaypoints().size();
+					if (run == 0) {
+						lengths[q] = length;
+					}
+					else {
+						mismatches += length != lengths[q] ? 1 : 0;
+					}
+					pathLength += length;
+				}
+				t.Tick();
+				std::cout << " " << searchNames[run] << " " << t.GetTimeDeltaMSec() << "ms, " << expanded << " nodes, " << pathLength << " long;";
+			}
+			std::cout << (mismatches > 0 ? " PATH LENGTHS DIFFER!" : "") << std::endl;
+			//Jumping only skips nodes A* would have looked at, so never changes how short the path is
+			assert(mismatches == 0);
+		}
+	}
+
+	{
+		const int size = 512;
+		std::string types(size * size, '.');
+		for (char& t : types) {
+			t = rng() % 10 == 0 ? 'x' : '.';
+		}
+		NavigationGrid grid(size, size, nodeSize, types);
+		HierarchicalGrid hierarchy(grid);
+
+		std::vector<Vector3> ends;
+		while ((int)ends.size() < queries * 2) {
+			int node = rng() % (size * size);
+			if (types[node] != 'x') {
+				ends.emplace_back(Vector3((float)((node % size) * nodeSize), 0, (float)((node / size) * nodeSize)));
+			}
+		}
+		const char* runNames[] = { "A*", "HPA*", "HPA* refining 1 leg" };
+		std::cout << "  " << size << "x" << size << ", " << hierarchy.GetEntranceCount() << " entrances:";
+		for (int run = 0; run < 3; ++run) {
+			int pathLength = 0;
+			GameTimer t;
+			t.Tick();
+			for (int q = 0; q < queries; ++q) {
+				NavigationPath path;
+				if (run == 0) {
+					grid.FindPath(ends[q * 2], ends[q * 2 + 1], path);
+				}
+				else {
+					hierarchy.FindPath(ends[q * 2], ends[q * 2 + 1], path, run == 1 ? -1 : 1);
+				}
+				pathLength += (int)path.GetWaypoints().size();
+			}
+			t.Tick();
+			std::cout << " " << runNames[run] << " " << t.GetTimeDeltaMSec() << "ms, " << pathLength << " long;";
+		}
+		std::cout << std::endl;
+	}
+	{
+		const int size = 2000;
+		std::string types(size * size, '.');
+		for (char& t : types) {
+			t = rng() % 10 == 0 ? 'x' : '.';
+		}
+		GameTimer t;
+		t.Tick();
+		HierarchicalGrid hierarchy(size, size, nodeSize, types);
+		t.Tick();
+		float buildTime = t.GetTimeDeltaMSec();
+
+		int found = 0;
+		for (int q = 0; q < queries; ++q) {
+			int a = rng() % (size * size);
+			int b = rng() % (size * size);
+			NavigationPath path;
+			found += hierarchy.FindPath(Vector3((float)((a % size) * nodeSize), 0, (float)((a / size) * nodeSize)),
+				Vector3((float)((b % size) * nodeSize), 0, (float)((b / size) * nodeSize)), path, 1) ? 1 : 0;
+		}
+		t.Tick();
+		float queryTime = t.GetTimeDeltaMSec();
+
+		hierarchy.SetNodeType(size / 2, size / 2, 'x');
+		NavigationPath path;
+		hierarchy.FindPath(Vector3(0, 0, 0), Vector3(0, 0, 0), path);	//Picks up the change
+		t.Tick();
+		std::cout << "  " << size << "x" << size << ": built " << hierarchy.GetEntranceCount() << " entrances in " << buildTime << "ms, "
+			<< queries << " queries in " << queryTime << "ms (" << found << " found), a change rebuilt in " << t.GetTimeDeltaMSec() << "ms" << std::endl;
+	}
+
+	{
+		NavigationMesh mesh("test.navmesh");
+		if (mesh.GetTriCount() > 0) {
+			const int meshQueries = 200;
+			int found		= 0;
+			int expanded	= 0;
+			int corridor	= 0;
+			int waypoints	= 0;
+			int repeats		= 0;	//Waypoints straight after an identical one, which string pulling should never leave
+			GameTimer t;
+			t.Tick();
+			for (int q = 0; q < meshQueries; ++q) {
+				NavigationPath path;
+				if (mesh.FindPath(mesh.GetTriCentre(rng() % mesh.GetTriCount()), mesh.GetTriCentre(rng() % mesh.GetTriCount()), path)) {
+					found++;
+					expanded	+= mesh.GetExpandedCount();
+					corridor	+= mesh.GetCorridorLength();
+					waypoints	+= (int)path.GetWaypoints().size();
+
+					const std::vector<Vector3>& points = path.GetWaypoints();
+					for (size_t i = 1; i < points.size(); ++i) {
+						repeats += (points[i] - points[i - 1]).LengthSquared() < 0.0001f * 0.0001f;
+					}
+				}
+			}
+			t.Tick();
+			float perPath = found > 0 ? 1.0f / found : 0.0f;
+			std::cout << "  Navmesh, " << mesh.GetTriCount() << " triangles: " << meshQueries << " queries in " << t.GetTimeDeltaMSec() << "ms, "
+				<< found << " found, averaging " << expanded * perPath << " triangles searched, " << corridor * perPath << " crossed, and "
+				<< waypoints * perPath << " waypoints" << (repeats == 0 ? "" : " (REPEATED WAYPOINTS)") << std::endl;
+			assert(repeats == 0);
+		}
+	}
+
+	const int chaseSize		= 128;
+	const int chaseFrames	= 600;
+	std::string types(chaseSize * chaseSize, '.');
+	for (char& t : types) {
+		t = rng() % 10 == 0 ? 'x' : '.';
+	}
+	types.front()	= '.';
+	types.back()	= '.';
+	NavigationGrid grid(chaseSize, chaseSize, nodeSize, types);
+	NavigationPathCache cache(grid);
+
+	float times[2];
+	for (int run = 0; run < 2; ++run) {
+		std::mt19937 chaseRng(5678);
+		int chaser = 0;
+		int target = (chaseSize * chaseSize) - 1;
+
+		GameTimer t;
+		t.Tick();
+		for (int frame = 0; frame < chaseFrames; ++frame) {
+			if (frame % 8 == 0) {	//The target wanders off a node at a time
+				int x = (target % chaseSize) + (int)(chaseRng() % 3) - 1;
+				int z = (target / chaseSize) + (int)(chaseRng() % 3) - 1;
+				if (x >= 0 && x < chaseSize && z >= 0 && z < chaseSize && types[(z * chaseSize) + x] != 'x') {
+					target = (z * chaseSize) + x;
+				}
+			}
+			Vector3 from((float)((chaser % chaseSize) * nodeSize), 0, (float)((chaser / chaseSize) * nodeSize));
+			Vector3 to((float)((target % chaseSize) * nodeSize), 0, (float)((target / chaseSize) * nodeSize));
+			NavigationPath path;
+			bool result = run == 0 ? grid.FindPath(from, to, path) : cache.FindPath(from, to, path);
+
+			Vector3 next;
+			if (result && frame % 4 == 0 && path.PopWaypoint(next) && path.PopWaypoint(next)) {
+				chaser = grid.GetNodeIndex(next);	//The first waypoint is where it already is
+			}
+		}
+		t.Tick();
+		times[run] = t.GetTimeDeltaMSec();
+	}
+	std::cout << "  Chasing for " << chaseFrames << " frames: " << times[0] << "ms searching every frame, " << times[1] << "ms with a cache ("
+		<< cache.GetHits() << " hits, " << cache.GetRepairs() << " repairs, " << cache.GetMisses() << " misses)" << std::endl;
+
+	const int crowdSize		= 100;
+	const int crowdFrames	= 20;
+	std::vector<Vector3> crowd;
+	while ((int)crowd.size() < crowdSize) {
+		int node = rng() % (chaseSize * chaseSize);
+		if (types[node] != 'x') {
+			crowd.emplace_back(Vector3((float)((node % chaseSize) * nodeSize), 0, (float)((node / chaseSize) * nodeSize)));
+		}
+	}
+	FlowField flowField(grid);
+	for (int run = 0; run < 2; ++run) {
+		Vector3 target((float)((chaseSize - 1) * nodeSize), 0, (float)((chaseSize - 1) * nodeSize));
+		GameTimer t;
+		t.Tick();
+		for (int frame = 0; frame < crowdFrames; ++frame) {
+			target.x -= nodeSize * 0.5f;	//Crosses into a new node every other frame
+			if (run == 1) {
+				flowField.SetTarget(target);
+				flowField.Update();
+			}
+			for (const Vector3& agent : crowd) {
+				if (run == 0) {
+					NavigationPath path;
+					grid.FindPath(agent, target, path);
+				}
+				else {
+					Vector3 direction;
+					flowField.GetDirection(agent, direction);
+				}
+			}
+		}
+		t.Tick();
+		times[run] = t.GetTimeDeltaMSec();
+	}
+	std::cout << "  " << crowdSize << " agents for " << crowdFrames << " frames: " << times[0] << "ms searching each, "
+		<< times[1] << "ms sharing a flow field" << std::endl;
+}
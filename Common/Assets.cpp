@@ -2,6 +2,13 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cstdlib>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
 
 using namespace NCL;
 
@@ -45,4 +52,22 @@ bool	Assets::ReadBinaryFile(const std::string& filename, char** into, size_t& si
 	size = filesize;
 
 	return data == NULL ? true : false;
+}
+
+std::string Assets::GetTempDir() {
+#ifdef _WIN32
+	char path[MAX_PATH + 1];
+	DWORD length = GetTempPathA(MAX_PATH + 1, path);
+	if (length > 0 && length <= MAX_PATH) {
+		return std::string(path, length);	//Already ends in a backslash
+	}
+#else
+	const char* dir = std::getenv("TMPDIR");
+	if (dir && *dir) {
+		std::string path(dir);
+		return path.back() == '/' ? path : path + "/";
+	}
+	return "/tmp/";
+#endif
+	return DATADIR;
 }
\ No newline at end of file
@@ -19,5 +19,7 @@ namespace NCL {
 		const std::string DATADIR("../../Assets/Data/");
 		extern bool ReadTextFile(const std::string &filepath, std::string& result);
 		extern bool ReadBinaryFile(const std::string &filepath, char** into, size_t& size);
+		//Somewhere to put files that are only needed for a while, ending in a slash
+		extern std::string GetTempDir();
 	}
 }
\ No newline at end of file